@@ -1,40 +1,130 @@
 #include "EnemiesAI.h"
 
-bool EnemiesAI::DirectLineOfSight(Enemy* source, sf::Vector2f& raycastHitpoint)
+namespace
 {
-	if (source == nullptr || _target == nullptr) return false;
+	//In ticks, like enemy velocities
+	const float AVOIDANCE_HORIZON = 20.f; //Enemies are avoided when they would collide sooner
+	const float WALL_HORIZON = 5.f;
+}
+
+void EnemiesAI::CastSightRays(const EnemyStore* store, const sf::FloatRect& targetView, const sf::Vector2f& targetCenter)
+{
+	//Target field of view covers its whole view, enemies seen in it don't need own rays
+	const FieldOfView* targetSight = nullptr;
+	if (_visibility != nullptr)
+		targetSight = _visibility->GetFieldOfView(_target, sqrt(targetView.width * targetView.width + targetView.height * targetView.height) / 2.f);
+
+	auto count = store->GetSize();
+	_sightRays.resize(count);
+	_sightHitpoints.resize(count);
+	_sightVisible.assign(count, 0);
+	_jobs.ParallelFor(count, JOB_CHUNK, [&](size_t begin, size_t end, unsigned int) {
+		for (size_t i = begin; i < end; i++)
+		{
+			auto enemyCenter = store->GetCenter(i);
+			if (_steps[i].think == false) //Keeps sight from last time it thought
+			{
+				_sightRays[i] = std::make_tuple(enemyCenter, 0.f, 0.f);
+				_sightHitpoints[i] = enemyCenter;
+				_steps[i].direct = store->HasFlag(i, EnemyStore::FLAG_DIRECT);
+				continue;
+			}
+
+			auto angle = MathHelper::GetAngleBetweenPoints(enemyCenter, targetCenter);
+			auto distance = MathHelper::GetDistanceBetweenPoints(enemyCenter, targetCenter);
+			_sightRays[i] = std::make_tuple(enemyCenter, angle, distance);
+			if (targetSight != nullptr && distance < targetSight->GetRadius() * 0.99f) //Polygon edge is cut near radius
+			{
+				//Seen ones get ray end without casting, hidden ones only need hitpoint when it is drawn
+				auto wpn = store->GetEnemy(i)->GetWeapon();
+				_sightVisible[i] = targetSight->IsVisible(enemyCenter);
+				if (_sightVisible[i] || wpn == nullptr || wpn->GetRaycastVisibility() == false)
+					_sightRays[i] = std::make_tuple(enemyCenter, angle, 0.f);
+			}
+
+			if (_sightVisible[i])
+				_sightHitpoints[i] = MathHelper::GetPointFromAngle(enemyCenter, angle, distance);
+			else
+				_sightHitpoints[i] = _collisions->GetRayHitpoint(enemyCenter, angle, std::get<2>(_sightRays[i]));
+			_steps[i].direct = DirectLineOfSight(enemyCenter, targetCenter, _sightHitpoints[i]);
+		}
+	});
+}
+
+void EnemiesAI::SelectThinkingEnemies(const EnemyStore* store, const sf::FloatRect& targetView, const sf::Vector2f& targetPos)
+{
+	//Enemies further than two view diagonals are far
+	auto farDistance = 2.f * sqrt(targetView.width * targetView.width + targetView.height * targetView.height);
+	auto count = store->GetSize();
+	_jobs.ParallelFor(count, JOB_CHUNK, [&](size_t begin, size_t end, unsigned int) {
+		for (size_t i = begin; i < end; i++)
+		{
+			auto& step = _steps[i];
+			if (CollisionHelper::CheckSimpleCollision(targetView, store->GetBox(i)))
+				step.lod = LOD_FULL;
+			else if (store->HasFlag(i, EnemyStore::FLAG_AI) == false)
+				step.lod = LOD_SLEEP;
+			else if (MathHelper::GetDistanceBetweenPoints(store->GetCenter(i), targetPos) < farDistance)
+				step.lod = LOD_SLICED;
+			else
+				step.lod = LOD_FAR;
+			step.think = (step.lod == LOD_FULL);
+		}
+	});
+
+	//Enemies on screen always think, rest of budget goes to next ones in round robin
+	size_t full = 0;
+	for (auto& step : _steps)
+		if (step.lod == LOD_FULL)
+			full++;
+	auto fitting = (float)_thinkBudget.count() / std::max(_thinkCost, 0.01f) - (float)full;
+	auto allowed = (size_t)std::max(fitting, 0.f);
+	if (allowed < MIN_SLICED_THINKS)
+		allowed = MIN_SLICED_THINKS;
+
+	if (_thinkCursor >= count) _thinkCursor = 0;
+	for (size_t visited = 0; visited < count && allowed > 0; visited++)
+	{
+		auto& step = _steps[_thinkCursor];
+		bool farSkipped = (step.lod == LOD_FAR && _thinkPass % FAR_THINK_PASSES != 0);
+		if ((step.lod == LOD_SLICED || step.lod == LOD_FAR) && farSkipped == false)
+		{
+			step.think = true;
+			allowed--;
+		}
+
+		if (++_thinkCursor >= count)
+		{
+			_thinkCursor = 0;
+			_thinkPass++;
+		}
+	}
+}
 
+bool EnemiesAI::DirectLineOfSight(const sf::Vector2f& enemyCenter, const sf::Vector2f& targetCenter, const sf::Vector2f& raycastHitpoint) const
+{
 	//Get needed values
 	auto rayPrecision = 2.F;
-	auto targetCenter = ViewHelper::GetRectCenter(_target->GetCollisionBox());
-	auto enemyCenter = ViewHelper::GetRectCenter(source->GetCollisionBox());
-	auto angle = MathHelper::GetAngleBetweenPoints(enemyCenter, targetCenter);
 
-	//Calc distances and hitpoint
+	//Calc distances, hitpoint comes from CastSightRays
 	auto distance = MathHelper::GetDistanceBetweenPoints(enemyCenter, targetCenter);
-	raycastHitpoint = _collisions->GetRayHitpoint(enemyCenter, angle, distance);
 	auto enemyRaycastDistance = MathHelper::GetDistanceBetweenPoints(enemyCenter, raycastHitpoint);
 
 	//Decide if direct line of sight
-	bool directHit = false;
-	if (enemyRaycastDistance - rayPrecision < distance && enemyRaycastDistance + rayPrecision > distance)
-		directHit = true;
-	else
-		directHit = false;
+	return (enemyRaycastDistance - rayPrecision < distance && enemyRaycastDistance + rayPrecision > distance);
+}
 
-	//Update weapon
-	auto wpn = source->GetWeapon();
-	if (wpn != nullptr)
-	{
-		wpn->SetCurrentAngle(angle);
-		wpn->SetRaycastHitpoint(raycastHitpoint);
-		if (directHit)
-			wpn->SetRaycastColor(sf::Color::Yellow);
-		else
-			wpn->SetRaycastColor(sf::Color::Cyan);
-	}
+void EnemiesAI::UpdateWeaponRaycast(Enemy* enemy, float angle, const sf::Vector2f& raycastHitpoint, bool direct)
+{
+	auto wpn = enemy->GetWeapon();
+	if (wpn == nullptr) return;
 
-	return directHit;
+	wpn->SetCurrentAngle(angle);
+	wpn->SetRaycastHitpoint(raycastHitpoint);
+	if (direct)
+		wpn->SetRaycastColor(sf::Color::Yellow);
+	else
+		wpn->SetRaycastColor(sf::Color::Cyan);
 }
 
 void EnemiesAI::PrepareVertex()
@@ -42,10 +132,25 @@ void EnemiesAI::PrepareVertex()
 	_pathfindLines.clear();
 	_pathfindLines.resize(0);
 
-	auto enemies = _enemies->GetEnemies();
-	for (auto& e : *enemies)
+	auto store = _enemies->GetStore();
+	for (size_t i = 0; i < store->GetSize(); i++)
 	{
-		auto found = _enemyPath.find(e);
+		auto center = store->GetCenter(i);
+		if (_pathfindMode == PathfindMode::FLOW_FIELD && store->HasFlag(i, EnemyStore::FLAG_AI))
+		{
+			auto next = _pathfind.GetFlowFieldNextPoint(center);
+			if (next.x != INFINITY)
+			{
+				sf::Vertex v;
+				v.color = _pathfindLinesColor;
+				v.position = center;
+				_pathfindLines.append(v);
+				v.position = next;
+				_pathfindLines.append(v);
+			}
+		}
+
+		auto found = _enemyPath.find(store->GetHandle(i));
 		if (found == _enemyPath.end()) continue;
 
 		sf::Vertex v;
@@ -54,7 +159,7 @@ void EnemiesAI::PrepareVertex()
 		{
 			v.position = found->second.front();
 			_pathfindLines.append(v);
-			v.position = ViewHelper::GetRectCenter(e->GetCollisionBox());
+			v.position = center;
 			_pathfindLines.append(v);
 
 			auto start = found->second.begin();
@@ -76,7 +181,7 @@ void EnemiesAI::PrepareVertex()
 		}
 
 		//Draw avoidance circle
-		auto vertex = Utilities::GenerateVertexCircle(ViewHelper::GetRectCenter(e->GetCollisionBox()), e->GetAvoidanceRadius(), 12);
+		auto vertex = Utilities::GenerateVertexCircle(center, store->GetAvoidanceRadius(i), 12);
 		for (size_t j = 1; j < vertex.getVertexCount(); j++)
 		{
 			_pathfindLines.append(vertex[j - 1]);
@@ -85,9 +190,31 @@ void EnemiesAI::PrepareVertex()
 	}
 }
 
-float EnemiesAI::WeightFunction(float x)
+void EnemiesAI::CancelPendingPaths()
+{
+	for (auto& pending : _pendingPaths)
+		_pathfind.CancelPathRequest(pending.second.first);
+	_pendingPaths.clear();
+}
+
+void EnemiesAI::DropRemovedEnemies(const EnemyStore* store)
 {
-	return (cosf(x) + 1.F) / 2;
+	for (auto it = _enemyPath.begin(); it != _enemyPath.end();)
+	{
+		if (store->IsValid(it->first)) it++;
+		else it = _enemyPath.erase(it);
+	}
+
+	for (auto it = _pendingPaths.begin(); it != _pendingPaths.end();)
+	{
+		if (store->IsValid(it->first))
+		{
+			it++;
+			continue;
+		}
+		_pathfind.CancelPathRequest(it->second.first);
+		it = _pendingPaths.erase(it);
+	}
 }
 
 EnemiesAI::EnemiesAI()
@@ -97,12 +224,21 @@ EnemiesAI::EnemiesAI()
 	_target = nullptr;
 	_collisions = nullptr;
 	_enemies = nullptr;
+	_visibility = nullptr;
+	_pathfindMode = PathfindMode::GRAPH;
 
 	_pathfindLines.setPrimitiveType(sf::Lines);
 	_pathfindLines.resize(0);
 	_pathfindLines.clear();
 	_pathfindLinesColor = sf::Color::Green;
 	_showPathfindLines = false;
+
+	_timings = UpdateTimings();
+
+	_thinkBudget = std::chrono::microseconds(2000);
+	_thinkCost = 20.f;
+	_thinkCursor = 0;
+	_thinkPass = 0;
 	
 	_enemyPath.clear();
 	_allPaths.clear();
@@ -114,15 +250,28 @@ void EnemiesAI::Update(float deltaTime)
 	if (_enemies == nullptr || _target == nullptr) return;
 
 	//Set vars
-	auto enemies = _enemies->GetEnemies();
-	if (enemies->size() == 0) return;
+	auto store = _enemies->GetStore();
+	DropRemovedEnemies(store);
+	if (store->GetSize() == 0) return;
 
 	auto targetView = _target->GetView();
-	auto acctualTargetPos = ViewHelper::GetRectCenter(_target->GetCollisionBox());
+	auto targetBox = _target->GetCollisionBox();
+	auto acctualTargetPos = ViewHelper::GetRectCenter(targetBox);
 
 	//Check if there is need to generate new paths
 	bool same = true;
-	if (acctualTargetPos != _lastTargetPos)
+	bool gridPath = (_pathfindMode == PathfindMode::HIERARCHICAL || (_pathfindMode != PathfindMode::FLOW_FIELD && _pathfind.GetBaseGraphSize() == 0)); //Map without pathfind points
+	if (_pathfindMode == PathfindMode::FLOW_FIELD)
+		_pathfind.UpdateFlowField(acctualTargetPos, _collisions->GetCommonMap());
+	else if ((gridPath || _pathfindMode == PathfindMode::ASYNC_GRAPH) && acctualTargetPos != _lastTargetPos)
+		same = (CollisionHelper::GetPosOnTiles(acctualTargetPos, _collisions->GetCommonMap()) == CollisionHelper::GetPosOnTiles(_lastTargetPos, _collisions->GetCommonMap()));
+	else if (_pathfindMode == PathfindMode::INCREMENTAL_GRAPH && acctualTargetPos != _lastTargetPos)
+	{
+		//Repair only changed part of tree, small root link changes are ignored
+		auto tolerance = (float)_collisions->GetCommonMap()->tileWidth / 2.f;
+		same = (_pathfind.UpdateIncrementalTree(acctualTargetPos, _collisions, tolerance) == 0);
+	}
+	else if (acctualTargetPos != _lastTargetPos)
 	{
 		std::unordered_map<Vector2MapKey<float>, bool, Vector2MapKeyHasher<float>> toFill;
 		auto neighbours = _pathfind.GetNodesInSight(acctualTargetPos, _collisions);
@@ -149,18 +298,66 @@ void EnemiesAI::Update(float deltaTime)
 		_lastNeighbours.clear();
 		_lastNeighbours = toFill;
 	}
-	if(same == false)
+	if(same == false && _pathfindMode == PathfindMode::GRAPH && gridPath == false)
 		_allPaths = _pathfind.GetDijkstrasPath(acctualTargetPos, _collisions);
 
-	//Go through enemies
-	for (size_t i = 0; i < enemies->size(); i++)
+	const Paths& allPaths = (_pathfindMode == PathfindMode::INCREMENTAL_GRAPH) ? _pathfind.GetIncrementalPaths() : _allPaths;
+
+	//Neighbours are searched in boxes around enemy centers, so largest radius has to be covered
+	float maxAvoidanceRadius = 0.f;
+	for (auto radius : store->GetAvoidanceRadiuses())
+		maxAvoidanceRadius = std::max(maxAvoidanceRadius, radius);
+
+	//Parallel phases read only state from before update and write own enemy step, so result doesn't depend on threads count
+	_steps.assign(store->GetSize(), EnemyStep());
+	auto phaseStart = std::chrono::steady_clock::now();
+	auto endPhase = [&phaseStart](std::chrono::microseconds& timing) {
+		auto now = std::chrono::steady_clock::now();
+		timing = std::chrono::duration_cast<std::chrono::microseconds>(now - phaseStart);
+		phaseStart = now;
+	};
+
+	SelectThinkingEnemies(store, targetView, acctualTargetPos);
+	endPhase(_timings.lod);
+
+	CastSightRays(store, targetView, acctualTargetPos);
+	endPhase(_timings.sight);
+
+	UpdatePaths(store, acctualTargetPos, same, gridPath, allPaths);
+	endPhase(_timings.paths);
+
+	//Cost of one think is averaged over updates, so slices follow changes slowly
+	size_t thinking = 0;
+	for (auto& step : _steps)
+		if (step.think)
+			thinking++;
+	if (thinking > 0)
+		_thinkCost = _thinkCost * 0.9f + 0.1f * (float)(_timings.sight + _timings.paths).count() / (float)thinking;
+
+	SteerEnemies(store, targetBox, maxAvoidanceRadius, deltaTime);
+	endPhase(_timings.steering);
+
+	CommitMoves(store, gridPath, deltaTime);
+	endPhase(_timings.commit);
+
+	if(acctualTargetPos != _lastTargetPos)
+		_lastTargetPos = acctualTargetPos;
+
+	if (_showPathfindLines)
+		PrepareVertex();
+}
+
+void EnemiesAI::UpdatePaths(EnemyStore* store, const sf::Vector2f& targetPos, bool same, bool gridPath, const Paths& allPaths)
+{
+	for (size_t i = 0; i < store->GetSize(); i++)
 	{
 		//Set vars
-		auto currentEnemy = enemies->at(i);
-		auto enemyBox = currentEnemy->GetCollisionBox();
-		auto currentEnemyPos = ViewHelper::GetRectCenter(enemyBox);
+		auto currentEnemy = store->GetEnemy(i);
+		auto currentHandle = store->GetHandle(i);
+		auto currentEnemyPos = store->GetCenter(i);
+		auto& step = _steps[i];
 
-		if (currentEnemy->IsAiEnabled() == false && CollisionHelper::CheckSimpleCollision(targetView, enemyBox) == false) //Not in player view
+		if (step.lod == LOD_SLEEP) //Not in player view
 		{
 			auto wpn = currentEnemy->GetWeapon();
 			if (wpn != nullptr && wpn->GetRaycastVisibility() == true) //Hide raycasts when outside screen and not chasing
@@ -168,48 +365,129 @@ void EnemiesAI::Update(float deltaTime)
 			continue;
 		}
 
-		sf::Vector2f gotoPoint = currentEnemyPos;
-		bool direct = DirectLineOfSight(currentEnemy, gotoPoint);
-		if (direct == false) //If no direct, find path
+		sf::Vector2f gotoPoint = _sightHitpoints[i];
+		if (step.think == false) //Follows what it decided last time, without searching
 		{
-			if (currentEnemy->IsAiEnabled() == false) continue;
+			if (step.direct)
+				gotoPoint = targetPos;
+			else if (_pathfindMode == PathfindMode::FLOW_FIELD)
+				gotoPoint = _pathfind.GetFlowFieldNextPoint(currentEnemyPos);
+			else
+			{
+				auto found = _enemyPath.find(currentHandle);
+				gotoPoint = (found != _enemyPath.end() && found->second.size() > 0) ? found->second.front() : sf::Vector2f(INFINITY, INFINITY);
+			}
 
-			auto pathFromPaths = _enemyPath.find(currentEnemy);
-			if (acctualTargetPos != _lastTargetPos && (same == false || pathFromPaths == _enemyPath.end() || pathFromPaths->second.size() == 0)) //Player moved or enemy has no path
+			if (gotoPoint.x != INFINITY)
 			{
-				sf::Vector2f nowGoingTo;
-
-				//Some path exists, clear all, left only acctual point
-				if (pathFromPaths != _enemyPath.end() && pathFromPaths->second.size() > 0) 
-					nowGoingTo = pathFromPaths->second.front();
-				else //Find first point
-					nowGoingTo = _pathfind.GetClosestVisibleNodeTo(_allPaths, currentEnemyPos, acctualTargetPos, _collisions);
-				_enemyPath[currentEnemy].clear();
-
-				//Get path from enemy to player
-				sf::Vector2f* currPoint = nullptr;
-				currPoint = (nowGoingTo.x == INFINITY) ? nullptr : &nowGoingTo;
-				while (currPoint != nullptr)
-				{
-					_enemyPath[currentEnemy].push_back(*currPoint);
+				step.steer = true;
+				step.gotoPoint = gotoPoint;
+			}
+			continue;
+		}
 
-					auto found = _allPaths.find(Vector2MapKey<float>(*currPoint));
-					if (found == _allPaths.end()) break;
+		UpdateWeaponRaycast(currentEnemy, std::get<1>(_sightRays[i]), gotoPoint, step.direct);
+		store->SetDirect(i, step.direct);
+		if (step.direct == false) //If no direct, find path
+		{
+			if (store->HasFlag(i, EnemyStore::FLAG_AI) == false) continue;
 
-					if (found->second.x == INFINITY) currPoint = nullptr;
-					else currPoint = &found->second;
+			auto pathFromPaths = _enemyPath.find(currentHandle);
+			if (_pathfindMode == PathfindMode::FLOW_FIELD) //Next tile from flow field
+			{
+				gotoPoint = _pathfind.GetFlowFieldNextPoint(currentEnemyPos);
+				if (gotoPoint.x == INFINITY)
+				{
+					if (store->HasFlag(i, EnemyStore::FLAG_ATTACKING) == false)
+						store->SetState(i, EnemyStore::STATE_IDLE);
+					store->SetAI(i, false);
+					continue;
 				}
+			}
+			else if (_pathfindMode == PathfindMode::ASYNC_GRAPH) //Old path is followed until new one is solved
+			{
+				auto targetTiles = _collisions->GetCommonMap();
+				auto pending = _pendingPaths.find(currentHandle);
+				bool hasPath = (pathFromPaths != _enemyPath.end() && pathFromPaths->second.size() > 0);
+				bool outdated = (same == false);
+				std::vector<sf::Vector2f> solved;
+				if (pending != _pendingPaths.end() && _pathfind.TryGetPathResult(pending->second.first, solved))
+				{
+					auto requestedFor = pending->second.second;
+					_pendingPaths.erase(pending);
+					pending = _pendingPaths.end();
+
+					_enemyPath[currentHandle].assign(solved.rbegin(), solved.rend());
+					pathFromPaths = _enemyPath.find(currentHandle);
+					hasPath = (solved.size() > 0);
+
+					//Target left tile while request was solved
+					outdated = (CollisionHelper::GetPosOnTiles(requestedFor, targetTiles) != CollisionHelper::GetPosOnTiles(targetPos, targetTiles));
+					if (hasPath == false && outdated == false) //If no path, nor direct, exit
+					{
+						if (store->HasFlag(i, EnemyStore::FLAG_ATTACKING) == false)
+							store->SetState(i, EnemyStore::STATE_IDLE);
+						store->SetAI(i, false);
+						continue;
+					}
+				}
+				if (pending == _pendingPaths.end() && (outdated || hasPath == false))
+					_pendingPaths[currentHandle] = std::make_pair(_pathfind.RequestPath(currentEnemyPos, targetPos, _collisions), targetPos);
 
-				if (_enemyPath[currentEnemy].size() == 0) //If no path, nor direct, exit
+				if (hasPath)
+					gotoPoint = pathFromPaths->second.front();
+				else
 				{
-					if (currentEnemy->IsAttacking() == false)
-						currentEnemy->SetState("idle");
-					currentEnemy->SetAI(false);
+					if (store->HasFlag(i, EnemyStore::FLAG_ATTACKING) == false)
+						store->SetState(i, EnemyStore::STATE_IDLE);
 					continue;
 				}
+			}
+			else if (targetPos != _lastTargetPos && (same == false || pathFromPaths == _enemyPath.end() || pathFromPaths->second.size() == 0)) //Player moved or enemy has no path
+			{
+				auto& path = _enemyPath[currentHandle];
+				if (gridPath) //Path on tiles
+				{
+					auto waypoints = (_pathfindMode == PathfindMode::HIERARCHICAL) ?
+						_hierarchical.GetPath(currentEnemyPos, targetPos) : _pathfind.GetJPSPath(currentEnemyPos, targetPos, _collisions);
+					path.assign(waypoints.begin(), waypoints.end());
+				}
 				else
 				{
-					gotoPoint = _enemyPath[currentEnemy].front();
+					sf::Vector2f nowGoingTo;
+
+					//Some path exists, clear all, left only acctual point
+					if (path.size() > 0)
+						nowGoingTo = path.front();
+					else //Find first point
+						nowGoingTo = _pathfind.GetClosestVisibleNodeTo(allPaths, currentEnemyPos, targetPos, _collisions);
+					path.clear();
+
+					//Get path from enemy to player
+					const sf::Vector2f* currPoint = nullptr;
+					currPoint = (nowGoingTo.x == INFINITY) ? nullptr : &nowGoingTo;
+					while (currPoint != nullptr)
+					{
+						path.push_back(*currPoint);
+
+						auto found = allPaths.find(Vector2MapKey<float>(*currPoint));
+						if (found == allPaths.end()) break;
+
+						if (found->second.x == INFINITY) currPoint = nullptr;
+						else currPoint = &found->second;
+					}
+				}
+
+				if (path.size() == 0) //If no path, nor direct, exit
+				{
+					if (store->HasFlag(i, EnemyStore::FLAG_ATTACKING) == false)
+						store->SetState(i, EnemyStore::STATE_IDLE);
+					store->SetAI(i, false);
+					continue;
+				}
+				else
+				{
+					gotoPoint = path.front();
 				}
 			}
 			else
@@ -218,96 +496,146 @@ void EnemiesAI::Update(float deltaTime)
 					gotoPoint = pathFromPaths->second.front();
 				else
 				{
-					if (currentEnemy->IsAttacking() == false)
-						currentEnemy->SetState("idle");
+					if (store->HasFlag(i, EnemyStore::FLAG_ATTACKING) == false)
+						store->SetState(i, EnemyStore::STATE_IDLE);
 					continue;
 				}
 			}
 		}
 		else
 		{
-			currentEnemy->SetAI(true);
-			auto found = _enemyPath.find(currentEnemy);
+			store->SetAI(i, true);
+			auto found = _enemyPath.find(currentHandle);
 			if (found != _enemyPath.end())
 				_enemyPath.erase(found);
-		}
-		
-		if (CollisionHelper::CheckSimpleCollision(_target->GetCollisionBox(), currentEnemy->GetCollisionBox()) == false) //Not touching target
-		{
-			//Helpful vars
-			auto startBox = currentEnemy->GetCollisionBox();
-			auto startBoxCenter = ViewHelper::GetRectCenter(startBox);
-			auto offset = currentEnemy->GetCollisionBoxOffset();
-			auto offsetPos = sf::Vector2f(offset.left, offset.top);
-
-			//Get enemies that touch current
-			float currEnemyGoalDistance = INFINITY; //CLoser to goal = more important
-			auto pathFound = _enemyPath.find(currentEnemy);
-			if (pathFound != _enemyPath.end() && pathFound->second.size() > 0)
-				currEnemyGoalDistance = MathHelper::GetDistanceBetweenPoints(startBoxCenter, pathFound->second.front());
-			std::vector<float> badAngles;
-			for (size_t no = 0; no < enemies->size(); no++)
+
+			auto pending = _pendingPaths.find(currentHandle);
+			if (pending != _pendingPaths.end())
 			{
-				if (no == i) continue;
+				_pathfind.CancelPathRequest(pending->second.first);
+				_pendingPaths.erase(pending);
+			}
+		}
 
-				auto checkedEnemy = enemies->at(no);
+		step.steer = true;
+		step.gotoPoint = gotoPoint;
+	}
+}
 
-				if (checkedEnemy->IsAiEnabled() == false) continue; //Don't care about idle ones
+void EnemiesAI::SteerEnemies(const EnemyStore* store, const sf::FloatRect& targetBox, float maxAvoidanceRadius, float deltaTime)
+{
+	_threadBuffers.resize(_jobs.GetThreadsCount());
+
+	auto broadphase = _enemies->GetBroadphase();
+	auto& flags = store->GetFlags();
+	auto& centersX = store->GetCentersX();
+	auto& centersY = store->GetCentersY();
+	auto& avoidanceRadiuses = store->GetAvoidanceRadiuses();
+	_jobs.ParallelFor(store->GetSize(), JOB_CHUNK, [&](size_t begin, size_t end, unsigned int thread) {
+		auto& buffers = _threadBuffers[thread];
+		for (size_t i = begin; i < end; i++)
+		{
+			auto& step = _steps[i];
+			if (step.steer == false || CollisionHelper::CheckSimpleCollision(targetBox, store->GetBox(i))) continue; //Touching target
+			step.move = true;
 
-				auto found = _enemyPath.find(checkedEnemy);
-				if (found != _enemyPath.end() && found->second.size() > 0)
-					if (MathHelper::GetDistanceBetweenPoints(ViewHelper::GetRectCenter(checkedEnemy->GetCollisionBox()), found->second.front()) > currEnemyGoalDistance)
-						continue; //If checked enemy has it's goal further than current one, you don't care about it
+			//Helpful vars
+			auto startBoxCenter = store->GetCenter(i);
+			auto avoidanceRadius = avoidanceRadiuses[i];
+			auto maxSpeed = store->GetMoveSpeed(i);
+			auto straightEnd = GetStraightMove(startBoxCenter, step.gotoPoint, maxSpeed * deltaTime);
+			if (deltaTime <= 0.f)
+			{
+				step.end = step.limited = startBoxCenter;
+				continue;
+			}
+			auto preferred = (straightEnd - startBoxCenter) / deltaTime;
 
-				auto checkedCenter = ViewHelper::GetRectCenter(checkedEnemy->GetCollisionBox());
-				if (CollisionHelper::CheckCirclesIntersect(startBoxCenter, currentEnemy->GetAvoidanceRadius(),
-					checkedCenter, checkedEnemy->GetAvoidanceRadius()))
+			//Closest chasing enemies that could be hit within horizon, idle ones are walked through, far ones don't care
+			buffers.avoided.clear();
+			if (step.lod != LOD_FAR)
+			{
+				broadphase->QueryNearest(startBoxCenter, avoidanceRadius + maxAvoidanceRadius + maxSpeed * AVOIDANCE_HORIZON, MAX_AVOIDED + 1, buffers.neighbours);
+				for (auto no : buffers.neighbours)
 				{
-					badAngles.push_back(MathHelper::GetAngleBetweenPoints(startBoxCenter, checkedCenter));
+					if (no == i || (flags[no] & EnemyStore::FLAG_AI) == 0) continue;
+					if (buffers.avoided.size() == MAX_AVOIDED) break;
+
+					AvoidanceHelper::Neighbour neighbour;
+					neighbour.position = sf::Vector2f(centersX[no], centersY[no]);
+					neighbour.velocity = store->GetVelocity(no);
+					neighbour.radius = avoidanceRadiuses[no];
+					neighbour.responsibility = 0.5f;
+					buffers.avoided.push_back(neighbour);
 				}
 			}
-			if (badAngles.size() > 0)
+
+			//Walls are hard lines, others can be broken when crowd leaves no room
+			buffers.lines.clear();
+			if (buffers.avoided.size() > 0)
+			{
+				auto wallDistance = _collisions->DistanceToWall(startBoxCenter);
+				if (wallDistance < avoidanceRadius + maxSpeed * WALL_HORIZON)
+					AvoidanceHelper::AddWallLine(wallDistance, _collisions->GradientAwayFromWall(startBoxCenter), avoidanceRadius, WALL_HORIZON, maxSpeed, buffers.lines);
+			}
+			auto hardLines = buffers.lines.size();
+			AvoidanceHelper::AddAgentLines(startBoxCenter, store->GetVelocity(i), avoidanceRadius, buffers.avoided, AVOIDANCE_HORIZON, deltaTime, buffers.lines);
+
+			auto velocity = (buffers.lines.size() > 0) ? AvoidanceHelper::GetVelocity(buffers.lines, hardLines, preferred, maxSpeed, buffers.projected) : preferred;
+			if (velocity == preferred)
 			{
-				auto nowGoingAngle = MathHelper::GetAngleBetweenPoints(startBoxCenter, gotoPoint);
-				auto gotoAngle = GetBestAngle(nowGoingAngle, badAngles, 8);
-				gotoPoint = MathHelper::GetPointFromAngle(startBoxCenter, gotoAngle, currentEnemy->GetStep() * deltaTime * currentEnemy->GetSpeed());
-				auto moveVector = gotoPoint - startBoxCenter;
-				currentEnemy->SetPosition(currentEnemy->GetPosition() + moveVector);
+				step.end = straightEnd;
+				step.straight = true;
 			}
 			else
-				MoveStraightToPoint(currentEnemy, gotoPoint, deltaTime);
+			{
+				step.end = startBoxCenter + velocity * deltaTime;
+				step.gotoPoint = step.end; //Avoiding, so path point isn't reached
+			}
+
+			//Check collisions with walls
+			step.limited = _collisions->GetSweptCircleLimitPosition(startBoxCenter, step.end, avoidanceRadius);
+		}
+	});
+}
 
+void EnemiesAI::CommitMoves(EnemyStore* store, bool gridPath, float deltaTime)
+{
+	auto broadphase = _enemies->GetBroadphase();
+	for (size_t i = 0; i < store->GetSize(); i++)
+	{
+		auto& step = _steps[i];
+		if (step.move == false) //Stopped enemies, including not steered ones, are avoided as standing still
+			store->SetVelocity(i, sf::Vector2f());
+		if (step.steer == false) continue;
 
-			//For collision checking
-			auto endBox = currentEnemy->GetCollisionBox();
-			auto endBoxCenter = ViewHelper::GetRectCenter(endBox);
+		if (step.move)
+		{
+			auto start = store->GetCenter(i);
+			if (step.straight)
+				FaceMove(store->GetEnemy(i), start, step.end);
 
-			//Check collisions with walls
-			auto circleCollision = _collisions->GetCircleLimitPosition(startBoxCenter, endBoxCenter, currentEnemy->GetAvoidanceRadius());
-			auto centerDiff = sf::Vector2f(startBox.left, startBox.top) - startBoxCenter;
-			currentEnemy->SetPosition(circleCollision + centerDiff - offsetPos);
+			store->SetCenter(i, step.limited);
+			store->SetVelocity(i, (deltaTime > 0.f) ? (step.limited - start) / deltaTime : sf::Vector2f());
+			broadphase->Insert(i, store->GetBox(i));
 
 			//If reached point, remove it, to go to the next
-			if (direct == false && gotoPoint == ViewHelper::GetRectCenter(currentEnemy->GetCollisionBox()))
-				if(_enemyPath[currentEnemy].size() > 0)
-					if(_enemyPath[currentEnemy].front() == gotoPoint)
-						_enemyPath[currentEnemy].pop_front();
-
+			if (step.direct == false && (_pathfindMode == PathfindMode::GRAPH || _pathfindMode == PathfindMode::ASYNC_GRAPH || gridPath) && step.gotoPoint == step.limited)
+			{
+				auto found = _enemyPath.find(store->GetHandle(i));
+				if (found != _enemyPath.end() && found->second.size() > 0 && found->second.front() == step.gotoPoint)
+					found->second.pop_front();
+			}
 		}
 
-		if (currentEnemy->IsAttacking() == false)
-			currentEnemy->SetState("move");
+		if (store->HasFlag(i, EnemyStore::FLAG_ATTACKING) == false)
+			store->SetState(i, EnemyStore::STATE_MOVE);
 	}
-
-	if(acctualTargetPos != _lastTargetPos)
-		_lastTargetPos = acctualTargetPos;
-
-	if (_showPathfindLines)
-		PrepareVertex();
 }
 
 void EnemiesAI::ClearEnemiesPaths()
 {
+	CancelPendingPaths();
 	_enemyPath.clear();
 	_lastTargetPos = sf::Vector2f(-1, -1);
 }
@@ -317,49 +645,50 @@ void EnemiesAI::MoveStraightToPoint(Enemy* source, const sf::Vector2f& point, fl
 	if (source == nullptr) return;
 
 	auto srcCenter = ViewHelper::GetRectCenter(source->GetCollisionBox());
-	sf::Vector2f moveVector(point - srcCenter);
-
-	auto distance = MathHelper::GetDistanceBetweenPoints(srcCenter, point);
-	auto radius = source->GetStep() * deltaTime * source->GetSpeed();
-	auto angle = MathHelper::GetAngleBetweenPoints(srcCenter, point);
-	auto move = MathHelper::GetPointFromAngle(srcCenter, angle, radius);
+	auto end = GetStraightMove(srcCenter, point, source->GetStep() * deltaTime * source->GetSpeed());
+	FaceMove(source, srcCenter, end);
+	source->SetPosition(source->GetPosition() + (end - srcCenter));
+}
 
-	if (distance > radius)
-		moveVector = move - srcCenter;
+sf::Vector2f EnemiesAI::GetStraightMove(const sf::Vector2f& from, const sf::Vector2f& point, float step) const
+{
+	auto distance = MathHelper::GetDistanceBetweenPoints(from, point);
+	if (distance > step)
+		return MathHelper::GetPointFromAngle(from, MathHelper::GetAngleBetweenPoints(from, point), step);
+	return point;
+}
 
-	if (moveVector.x < 0) source->GetAnimations()->ApplySetHorizontalFlip(true);
-	else if(moveVector.x > 0) source->GetAnimations()->ApplySetHorizontalFlip(false);
+void EnemiesAI::FaceMove(Enemy* source, const sf::Vector2f& from, const sf::Vector2f& to)
+{
+	if (to.x < from.x) source->GetAnimations()->ApplySetHorizontalFlip(true);
+	else if(to.x > from.x) source->GetAnimations()->ApplySetHorizontalFlip(false);
+}
 
-	source->SetPosition(source->GetPosition() + moveVector);
+void EnemiesAI::SetPathfindVisibility(bool visible)
+{
+	_showPathfindLines = visible;
 }
 
-float EnemiesAI::GetBestAngle(float gotoAngle, const std::vector<float>& avoidAngle, uint8_t precision)
+void EnemiesAI::SetPathfindMode(PathfindMode mode)
 {
-	float maxWeight = -1.F;
-	float bestAngle = gotoAngle;
+	if (mode == _pathfindMode) return;
 
-	for (float add = 0; add < 2 * PI; add += (2 * float(PI)) / (float)precision)
-	{
-		float val = add + MathHelper::DegToRad(gotoAngle);
-		float weight = WeightFunction(add);
-		for (float angle : avoidAngle)
-			weight *= WeightFunction(MathHelper::DegToRad(180.f - angle) + val);
+	_pathfindMode = mode;
+	_pathfind.ClearFlowField();
+	_pathfind.ClearIncrementalTree();
+	_allPaths.clear();
+	_lastNeighbours.clear();
+	ClearEnemiesPaths();
+}
 
-		if (weight >= maxWeight)
-		{
-			if (weight > maxWeight || rand() % 2 == 0)
-			{
-				maxWeight = weight;
-				bestAngle = MathHelper::RadToDeg(val);
-			}
-		}
-	}
-	return bestAngle;
+void EnemiesAI::SetWorkersCount(unsigned int workers)
+{
+	_jobs.Start(workers);
 }
 
-void EnemiesAI::SetPathfindVisibility(bool visible)
+void EnemiesAI::SetThinkBudget(const std::chrono::microseconds& budget)
 {
-	_showPathfindLines = visible;
+	_thinkBudget = budget;
 }
 
 void EnemiesAI::SetPathfindColor(const sf::Color& color)
@@ -379,6 +708,26 @@ sf::Color EnemiesAI::GetPathfindColor() const
 	return _pathfindLinesColor;
 }
 
+EnemiesAI::PathfindMode EnemiesAI::GetPathfindMode() const
+{
+	return _pathfindMode;
+}
+
+unsigned int EnemiesAI::GetWorkersCount() const
+{
+	return _jobs.GetThreadsCount();
+}
+
+std::chrono::microseconds EnemiesAI::GetThinkBudget() const
+{
+	return _thinkBudget;
+}
+
+const EnemiesAI::UpdateTimings& EnemiesAI::GetLastTimings() const
+{
+	return _timings;
+}
+
 void EnemiesAI::TogglePathfindingVisibility()
 {
 	std::string status = (!_showPathfindLines) ? "true" : "false";
@@ -386,6 +735,18 @@ void EnemiesAI::TogglePathfindingVisibility()
 	SetPathfindVisibility(!_showPathfindLines);
 }
 
+void EnemiesAI::TogglePathfindMode()
+{
+	auto mode = PathfindMode::GRAPH;
+	std::string name = "graph";
+	if (_pathfindMode == PathfindMode::GRAPH) { mode = PathfindMode::INCREMENTAL_GRAPH; name = "incremental graph"; }
+	else if (_pathfindMode == PathfindMode::INCREMENTAL_GRAPH) { mode = PathfindMode::FLOW_FIELD; name = "flow field"; }
+	else if (_pathfindMode == PathfindMode::FLOW_FIELD) { mode = PathfindMode::HIERARCHICAL; name = "hierarchical"; }
+	else if (_pathfindMode == PathfindMode::HIERARCHICAL) { mode = PathfindMode::ASYNC_GRAPH; name = "async graph"; }
+	_logger->Log(Logger::LogType::DEBUG, "Pathfinding mode: " + name);
+	SetPathfindMode(mode);
+}
+
 void EnemiesAI::SetTarget(Entity* target)
 {
 	_target = target;
@@ -396,14 +757,51 @@ void EnemiesAI::SetEnemiesManager(EnemiesManager* manager)
 	_enemies = manager;
 }
 
+void EnemiesAI::SetVisibilityManager(VisibilityManager* manager)
+{
+	_visibility = manager;
+}
+
 void EnemiesAI::SetCollisionsManager(CollisionsManager* manager)
 {
 	_collisions = manager;
 }
 
-void EnemiesAI::SetPathfindPoints(const std::vector<sf::Vector2f>& points)
+void EnemiesAI::SetPathfindPoints(const std::vector<sf::Vector2f>& points, const std::string& bakedGraphPath)
 {
-	_pathfind.GenerateBaseGraph(points, _collisions);
+	ClearEnemiesPaths();
+	_hierarchical.Build(_collisions);
+
+	if (bakedGraphPath != "")
+	{
+		auto hash = PathfindingManager::GetBaseGraphHash(_collisions->GetCommonMap(), points);
+		if (_pathfind.LoadBaseGraphFromFile(bakedGraphPath, hash))
+		{
+			_logger->Log(Logger::LogType::INFO, "Loaded baked pathfinding graph");
+			return;
+		}
+		_logger->Log(Logger::LogType::WARNING, "Baked pathfinding graph \"" + bakedGraphPath + "\" is missing or outdated, building it");
+	}
+
+	_pathfind.GenerateBaseGraph(points, _collisions, PathfindingManager::GraphBuildOptions());
+}
+
+void EnemiesAI::UpdateTiles(const sf::IntRect& changedTiles)
+{
+	if (_collisions == nullptr) return;
+
+	auto tiles = _collisions->GetCommonMap();
+	sf::FloatRect area((float)changedTiles.left * tiles->tileWidth + tiles->offsetX, (float)changedTiles.top * tiles->tileHeight + tiles->offsetY,
+		(float)changedTiles.width * tiles->tileWidth, (float)changedTiles.height * tiles->tileHeight);
+
+	_hierarchical.UpdateTiles(changedTiles);
+	_pathfind.UpdateBaseGraphLinks(area, _collisions);
+	_pathfind.ClearFlowField();
+
+	//Paths could go through new walls
+	_allPaths.clear();
+	_lastNeighbours.clear();
+	ClearEnemiesPaths();
 }
 
 void EnemiesAI::draw(sf::RenderTarget& target, sf::RenderStates) const
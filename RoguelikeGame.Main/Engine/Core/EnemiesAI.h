@@ -1,32 +1,112 @@
 #pragma once
 
+#include <chrono>
+
+#include "JobSystem.h"
 #include "../Managers/PathfindingManager.h"
+#include "../Managers/HierarchicalPathfindingManager.h"
 #include "../Managers/CollisionsManager.h"
 #include "../Managers/EnemiesManager.h"
+#include "../Managers/VisibilityManager.h"
 #include "../Helpers/ViewHelper.h"
+#include "../Helpers/AvoidanceHelper.h"
 
 class EnemiesAI : public sf::Drawable
 {
+public:
+	enum class PathfindMode { GRAPH = 0, FLOW_FIELD = 1, INCREMENTAL_GRAPH = 2, HIERARCHICAL = 3, ASYNC_GRAPH = 4 };
+	//SLEEP - off screen and not chasing, FULL - on screen, thinks every update
+	//SLICED - off screen and chasing, thinks in round robin slices, FAR - like sliced but thinks every few passes and doesn't avoid others
+	enum Lod : uint8_t { LOD_SLEEP = 0, LOD_FULL = 1, LOD_SLICED = 2, LOD_FAR = 3 };
+	//Duration of update phases, lod, sight and steering run on job threads
+	struct UpdateTimings
+	{
+		std::chrono::microseconds lod;
+		std::chrono::microseconds sight;
+		std::chrono::microseconds paths;
+		std::chrono::microseconds steering;
+		std::chrono::microseconds commit;
+	};
 private:
+	//Per enemy result of update phases, parallel phases write only own enemy
+	struct EnemyStep
+	{
+		uint8_t lod = LOD_SLEEP;
+		bool think = false; //Casts sight ray and searches path in this update
+		bool direct = false; //Target is in line of sight
+		bool steer = false; //Has point to go to
+		bool move = false; //Not touching target, so it moves
+		bool straight = false; //Avoidance didn't change its move, so it faces it
+		sf::Vector2f gotoPoint;
+		sf::Vector2f end; //Wanted center, before walls
+		sf::Vector2f limited; //Center after walls
+	};
+	static const size_t JOB_CHUNK = 64; //Enemies per job
+	static const size_t MIN_SLICED_THINKS = 4; //Per update, so off screen enemies never stop thinking
+	static const uint32_t FAR_THINK_PASSES = 4; //Far enemies think once per this many round robin passes
+	static const size_t MAX_AVOIDED = 10; //Closest neighbours avoided by one enemy
+
+	//Buffers of one job thread, kept to reuse memory
+	struct ThreadBuffers
+	{
+		std::vector<size_t> neighbours;
+		std::vector<AvoidanceHelper::Neighbour> avoided;
+		std::vector<AvoidanceHelper::Line> lines;
+		std::vector<AvoidanceHelper::Line> projected;
+	};
+
 	Logger* _logger;
 
 	Entity* _target;
 	EnemiesManager* _enemies;
 	CollisionsManager* _collisions;
+	VisibilityManager* _visibility; //Optional, sight rays are cast for every enemy without it
 	PathfindingManager _pathfind;
+	HierarchicalPathfindingManager _hierarchical;
+	PathfindMode _pathfindMode;
 
 	sf::Vector2f _lastTargetPos;
 	std::unordered_map<Vector2MapKey<float>, bool, Vector2MapKeyHasher<float>> _lastNeighbours;
-	std::map<Enemy*, std::list<sf::Vector2f>> _enemyPath;
+	std::map<EnemyHandle, std::list<sf::Vector2f>> _enemyPath;
+	std::map<EnemyHandle, std::pair<PathRequestHandle, sf::Vector2f>> _pendingPaths; //Request and target it was made for
 	Paths _allPaths;
+	std::vector<std::tuple<sf::Vector2f, float, float>> _sightRays; //Per enemy center, angle and range, rays are cast one by one in parallel jobs
+	std::vector<sf::Vector2f> _sightHitpoints;
+	std::vector<uint8_t> _sightVisible; //Enemy is in target field of view, bytes so threads can write next to each other
+	std::vector<EnemyStep> _steps;
+
+	JobSystem _jobs;
+	std::vector<ThreadBuffers> _threadBuffers;
+	UpdateTimings _timings;
+
+	std::chrono::microseconds _thinkBudget; //Per update, for all thinking enemies
+	float _thinkCost; //Average microseconds of sight and paths phases per thinking enemy
+	size_t _thinkCursor; //Next dense index in round robin
+	uint32_t _thinkPass; //Full round robin passes done
 
 	sf::VertexArray _pathfindLines;
 	sf::Color _pathfindLinesColor;
 	bool _showPathfindLines;
 
-	bool DirectLineOfSight(Enemy* source, sf::Vector2f& raycastHitpoint);
+	//Parallel lods, then serial round robin picking sliced enemies that fit into budget
+	void SelectThinkingEnemies(const EnemyStore* store, const sf::FloatRect& targetView, const sf::Vector2f& targetPos);
+	//Parallel, decides direct line of sight of thinking enemies
+	void CastSightRays(const EnemyStore* store, const sf::FloatRect& targetView, const sf::Vector2f& targetCenter);
+	bool DirectLineOfSight(const sf::Vector2f& enemyCenter, const sf::Vector2f& targetCenter, const sf::Vector2f& raycastHitpoint) const;
+	void UpdateWeaponRaycast(Enemy* enemy, float angle, const sf::Vector2f& raycastHitpoint, bool direct);
+	//Serial, finds point every enemy goes to
+	void UpdatePaths(EnemyStore* store, const sf::Vector2f& targetPos, bool same, bool gridPath, const Paths& allPaths);
+	//Parallel ORCA avoidance, reads only state from before update
+	void SteerEnemies(const EnemyStore* store, const sf::FloatRect& targetBox, float maxAvoidanceRadius, float deltaTime);
+	//Serial, applies steering results
+	void CommitMoves(EnemyStore* store, bool gridPath, float deltaTime);
 	void PrepareVertex();
-	float WeightFunction(float x);
+	//Point reached by moving at most step towards point
+	sf::Vector2f GetStraightMove(const sf::Vector2f& from, const sf::Vector2f& point, float step) const;
+	void FaceMove(Enemy* source, const sf::Vector2f& from, const sf::Vector2f& to);
+	void CancelPendingPaths();
+	//Paths and requests of enemies removed from store since last update
+	void DropRemovedEnemies(const EnemyStore* store);
 
 	// Inherited via Drawable
 	void draw(sf::RenderTarget& target, sf::RenderStates) const override;
@@ -37,22 +117,32 @@ public:
 	void Update(float deltaTime);
 	void ClearEnemiesPaths();
 	void MoveStraightToPoint(Enemy* source, const sf::Vector2f& point, float deltaTime);
-	float GetBestAngle(float gotoAngle, const std::vector<float>& avoidAngle, uint8_t precision = 8);
 
 	//EnemiesAI setters
 	void SetPathfindVisibility(bool visible);
 	void SetPathfindColor(const sf::Color& color);
+	void SetPathfindMode(PathfindMode mode);
+	void SetWorkersCount(unsigned int workers); //0 means all cores
+	void SetThinkBudget(const std::chrono::microseconds& budget);
 
 	//EnemiesAI getters
 	bool GetPathfindVisibility() const;
 	sf::Color GetPathfindColor() const;
+	PathfindMode GetPathfindMode() const;
+	unsigned int GetWorkersCount() const;
+	std::chrono::microseconds GetThinkBudget() const;
+	const UpdateTimings& GetLastTimings() const;
 
 	void TogglePathfindingVisibility();
+	void TogglePathfindMode();
 
 	void SetTarget(Entity* target);
 	void SetEnemiesManager(EnemiesManager* manager);
 	void SetCollisionsManager(CollisionsManager* manager);
-	void SetPathfindPoints(const std::vector<sf::Vector2f>& points);
+	void SetVisibilityManager(VisibilityManager* manager);
+	void SetPathfindPoints(const std::vector<sf::Vector2f>& points, const std::string& bakedGraphPath = "");
+	//Collisions have to be updated first, rect is in tiles
+	void UpdateTiles(const sf::IntRect& changedTiles);
 
 };
 
@@ -33,7 +33,7 @@ void EntityMovement::Update(float deltaTime)
 			_entity->SetPosition(sf::Vector2f(nextPos.left - hitbox.left, nextPos.top - hitbox.top));
 		else
 		{
-			auto pos = _collisions->GetLimitPosition(currPos, nextPos);
+			auto pos = _collisions->GetSweptLimitPosition(currPos, nextPos);
 			_entity->SetPosition(sf::Vector2f(pos.x - hitbox.left, pos.y - hitbox.top));
 		}
 	}
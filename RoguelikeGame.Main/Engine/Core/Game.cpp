@@ -63,6 +63,8 @@ void Game::UpdateUI()
 
 void Game::UpdateGame()
 {
+	_visibility.NextTick();
+	ApplyMapChanges();
 	_playerMovement.Update((float)_delta);
 	_player->Update(Game::Tick(), (float)_delta);
 	if (_playerMovement.IsKeyPressed()) RecalcPlayerRays();
@@ -71,9 +73,30 @@ void Game::UpdateGame()
 	_enemies.CheckAttacks();
 	_enemiesAI.Update((float)_delta);
 
+	auto& aiTimings = _enemiesAI.GetLastTimings();
+	_debug.AddTiming("AI lod", aiTimings.lod);
+	_debug.AddTiming("AI sight", aiTimings.sight);
+	_debug.AddTiming("AI paths", aiTimings.paths);
+	_debug.AddTiming("AI steering", aiTimings.steering);
+	_debug.AddTiming("AI commit", aiTimings.commit);
+
 	_camera.setCenter(ViewHelper::GetRectCenter(_player->GetCollisionBox()));
 }
 
+void Game::ApplyMapChanges()
+{
+	//Only tiles changed by GameMap::SetActionTile are updated
+	auto changed = _gameMap.GetChangedActionTiles();
+	if (changed.width > 0)
+	{
+		_collisionsManager.UpdateMap(*_gameMap.GetActionMap(), (unsigned char)1, changed);
+		_enemiesAI.UpdateTiles(changed);
+		_gameMap.ClearChangedActionTiles();
+		RecalcPlayerRays();
+	}
+	_gameMap.PrepareDirtyTiles();
+}
+
 void Game::CheckButtons()
 {
 	auto loaded = _sceneManager.GetLoadedScene();
@@ -201,6 +224,8 @@ void Game::SaveSettings()
 void Game::ApplySettings()
 {
 	_sounds.ApplyVolume(_settings->SOUNDS_VOLUME);
+	_enemiesAI.SetWorkersCount(_settings->AI_WORKERS);
+	_enemiesAI.SetThinkBudget(std::chrono::microseconds(_settings->AI_BUDGET_US));
 }
 
 void Game::LoadLevel(const std::string& path, const std::string& playerTemplate)
@@ -238,22 +263,21 @@ void Game::LoadLevel(const std::string& path, const std::string& playerTemplate)
 	_enemiesAI.SetTarget(_player);
 	_enemiesAI.SetCollisionsManager(&_collisionsManager);
 	_enemiesAI.SetEnemiesManager(&_enemies);
-	_enemiesAI.SetPathfindPoints(_gameMap.GetPathfindingPoints());
+	_visibility.SetCollisionsManager(&_collisionsManager);
+	_enemiesAI.SetVisibilityManager(&_visibility);
+	_enemiesAI.SetWorkersCount(_settings->AI_WORKERS);
+	_enemiesAI.SetThinkBudget(std::chrono::microseconds(_settings->AI_BUDGET_US));
+	_enemiesAI.SetPathfindPoints(_gameMap.GetPathfindingPoints(), path + ".graph");
 
 	//Enemies
+	_enemies.Clear();
 	_enemies.SetPlayer(_player);
-	_enemies.Add(_objTemplates.GetEnemy("devil"));
-	_enemies.Add(_objTemplates.GetEnemy("devil"));
-	_enemies.Add(_objTemplates.GetEnemy("devil"));
-	_enemies.Add(_objTemplates.GetEnemy("devil"));
-	_enemies.GetEnemies()->at(0)->SetWeapon(_objTemplates.GetHitboxWeapon("bite"));
-	_enemies.GetEnemies()->at(1)->SetWeapon(_objTemplates.GetHitboxWeapon("bite"));
-	_enemies.GetEnemies()->at(2)->SetWeapon(_objTemplates.GetHitboxWeapon("bite"));
-	_enemies.GetEnemies()->at(3)->SetWeapon(_objTemplates.GetHitboxWeapon("bite"));
-	_enemies.GetEnemies()->at(0)->SetPosition(500, 290);
-	_enemies.GetEnemies()->at(1)->SetPosition(580, 300);
-	_enemies.GetEnemies()->at(2)->SetPosition(590, 310);
-	_enemies.GetEnemies()->at(3)->SetPosition(610, 300);
+	auto devil = _objTemplates.GetEnemyTemplate("devil");
+	auto bite = _objTemplates.GetHitboxWeaponTemplate("bite");
+	_enemies.Spawn(devil, bite, sf::Vector2f(500, 290));
+	_enemies.Spawn(devil, bite, sf::Vector2f(580, 300));
+	_enemies.Spawn(devil, bite, sf::Vector2f(590, 310));
+	_enemies.Spawn(devil, bite, sf::Vector2f(610, 300));
 
 	//Sounds
 	_sounds.LoadFromFile("entities_dmg4", "./res/sounds/entities/dmg4.wav");
@@ -500,6 +524,7 @@ void Game::Start()
 		sf::Event::KeyEvent ctrlAltP = { sf::Keyboard::P, true, true, false, false };
 		sf::Event::KeyEvent ctrlAltN = { sf::Keyboard::N, true, true, false, false };
 		sf::Event::KeyEvent ctrlAltU = { sf::Keyboard::U, true, true, false, false };
+		sf::Event::KeyEvent ctrlAltF = { sf::Keyboard::F, true, true, false, false };
 		_keyboardHandler.NewOn(ctrlAltG, &Game::ToggleGridVisibility);
 		_keyboardHandler.NewOn(ctrlAltA, &Game::ToggleActionMapVisibility);
 		_keyboardHandler.NewOn(ctrlAltH, &Game::ToggleHitboxVisibility);
@@ -511,6 +536,7 @@ void Game::Start()
 		_keyboardHandler.NewOn(ctrlAltP, &Game::TogglePathfindingVisibility);
 		_keyboardHandler.NewOn(ctrlAltN, &Game::ToggleNoClip);
 		_keyboardHandler.NewOn(ctrlAltU, &Game::ToggleUIFrames);
+		_keyboardHandler.NewOn(ctrlAltF, &Game::TogglePathfindMode);
 	}
 
 	//Reset timings
@@ -651,6 +677,11 @@ void Game::TogglePathfindingVisibility()
 	_enemiesAI.TogglePathfindingVisibility();
 }
 
+void Game::TogglePathfindMode()
+{
+	_enemiesAI.TogglePathfindMode();
+}
+
 void Game::ToggleNoClip()
 {
 	_playerMovement.ToggleNoClip();
@@ -48,11 +48,13 @@ private:
 	EntityMovement _playerMovement;
 	EnemiesManager _enemies;
 	EnemiesAI _enemiesAI;
+	VisibilityManager _visibility;
 	std::chrono::steady_clock::time_point _lastFrameTime;
 	void SetDeltaAndTick();
 	void RecalcPlayerRays();
 	void UpdateUI();
 	void UpdateGame();
+	void ApplyMapChanges();
 	void CheckButtons();
 	void SaveSettings();
 	void ApplySettings();
@@ -72,6 +74,7 @@ private:
 	void ToggleMapCollisionLinesVisibility();
 	void ToggleRaycastVisibility();
 	void TogglePathfindingVisibility();
+	void TogglePathfindMode();
 	void ToggleNoClip();
 	void ToggleUIFrames();
 #pragma endregion
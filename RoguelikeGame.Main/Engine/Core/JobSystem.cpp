@@ -0,0 +1,134 @@
+#include "JobSystem.h"
+
+void JobSystem::WorkerLoop(unsigned int thread)
+{
+	uint64_t lastBatch = 0;
+	while (true)
+	{
+		{
+			std::unique_lock<std::mutex> lock(_mutex);
+			_wake.wait(lock, [&]() { return _stop || _batch != lastBatch; });
+			if (_stop) return;
+			lastBatch = _batch;
+		}
+
+		while (RunChunk(thread));
+	}
+}
+
+bool JobSystem::RunChunk(unsigned int thread)
+{
+	std::pair<size_t, size_t> chunk;
+	bool found = false;
+
+	auto count = (unsigned int)_queues.size();
+	for (unsigned int i = 0; i < count && found == false; i++)
+	{
+		auto& queue = *_queues[(thread + i) % count];
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		if (queue.chunks.empty()) continue;
+
+		if (i == 0)
+		{
+			chunk = queue.chunks.back();
+			queue.chunks.pop_back();
+		}
+		else
+		{
+			chunk = queue.chunks.front();
+			queue.chunks.pop_front();
+		}
+		found = true;
+	}
+	if (found == false) return false;
+
+	//Job is set before chunks are queued, so queue lock makes it visible here
+	(*_job)(chunk.first, chunk.second, thread);
+
+	if (--_pendingChunks == 0)
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_done.notify_all();
+	}
+	return true;
+}
+
+JobSystem::JobSystem()
+{
+	_job = nullptr;
+	_pendingChunks = 0;
+	_batch = 0;
+	_stop = false;
+	_queues.emplace_back(new Queue());
+}
+
+JobSystem::~JobSystem()
+{
+	Stop();
+}
+
+void JobSystem::Start(unsigned int threads)
+{
+	if (threads == 0)
+		threads = std::max(std::thread::hardware_concurrency(), 1U);
+	if (threads == GetThreadsCount()) return;
+
+	Stop();
+	_stop = false;
+	for (unsigned int i = 1; i < threads; i++)
+		_queues.emplace_back(new Queue());
+	for (unsigned int i = 1; i < threads; i++)
+		_workers.emplace_back(&JobSystem::WorkerLoop, this, i);
+}
+
+void JobSystem::Stop()
+{
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_stop = true;
+	}
+	_wake.notify_all();
+	for (auto& worker : _workers)
+		worker.join();
+	_workers.clear();
+	_queues.resize(1);
+}
+
+unsigned int JobSystem::GetThreadsCount() const
+{
+	return (unsigned int)_queues.size();
+}
+
+void JobSystem::ParallelFor(size_t count, size_t chunkSize, const Job& job)
+{
+	if (count == 0) return;
+	chunkSize = std::max(chunkSize, (size_t)1);
+	if (_workers.size() == 0 || count <= chunkSize)
+	{
+		job(0, count, 0);
+		return;
+	}
+
+	//Chunks are dealt round robin, so every thread starts with similar amount of work
+	size_t chunks = (count + chunkSize - 1) / chunkSize;
+	_job = &job;
+	_pendingChunks = chunks;
+	for (size_t i = 0; i < chunks; i++)
+	{
+		auto& queue = *_queues[i % _queues.size()];
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		queue.chunks.emplace_back(i * chunkSize, std::min((i + 1) * chunkSize, count));
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_batch++;
+	}
+	_wake.notify_all();
+
+	while (RunChunk(0));
+
+	std::unique_lock<std::mutex> lock(_mutex);
+	_done.wait(lock, [this]() { return _pendingChunks == 0; });
+	_job = nullptr;
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <vector>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <algorithm>
+#include <cstdint>
+
+//Runs ranges of indexes on pool of threads, thread that calls ParallelFor works too
+//Every thread has own queue of chunks, idle ones steal chunks from others
+class JobSystem
+{
+public:
+	//Range [begin, end) and index of thread running it (0 is caller), so job can use per thread buffers
+	typedef std::function<void(size_t begin, size_t end, unsigned int thread)> Job;
+private:
+	struct Queue
+	{
+		std::mutex mutex;
+		std::deque<std::pair<size_t, size_t>> chunks;
+	};
+	std::vector<std::unique_ptr<Queue>> _queues; //Per thread
+	std::vector<std::thread> _workers;
+
+	std::mutex _mutex;
+	std::condition_variable _wake;
+	std::condition_variable _done;
+	const Job* _job;
+	std::atomic<size_t> _pendingChunks;
+	uint64_t _batch; //Changed by every ParallelFor, so sleeping workers know there is new work
+	bool _stop;
+
+	void WorkerLoop(unsigned int thread);
+	//Own chunks are taken from back, stolen ones from front, false if all queues are empty
+	bool RunChunk(unsigned int thread);
+public:
+	JobSystem();
+	~JobSystem();
+
+	//0 means all cores, 1 runs everything on caller thread
+	void Start(unsigned int threads);
+	void Stop();
+	unsigned int GetThreadsCount() const;
+
+	//Blocks until job was run for every index, calls can't be nested
+	void ParallelFor(size_t count, size_t chunkSize, const Job& job);
+};
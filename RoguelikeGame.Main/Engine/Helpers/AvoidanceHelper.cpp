@@ -0,0 +1,193 @@
+#include "AvoidanceHelper.h"
+
+namespace
+{
+	const float AVOIDANCE_EPSILON = 0.00001f;
+}
+
+float AvoidanceHelper::Det(const sf::Vector2f& first, const sf::Vector2f& second)
+{
+	return first.x * second.y - first.y * second.x;
+}
+
+float AvoidanceHelper::Dot(const sf::Vector2f& first, const sf::Vector2f& second)
+{
+	return first.x * second.x + first.y * second.y;
+}
+
+sf::Vector2f AvoidanceHelper::Normalize(const sf::Vector2f& vector)
+{
+	float length = std::sqrt(Dot(vector, vector));
+	if (length == 0.f) return sf::Vector2f(0.f, 0.f);
+	return vector / length;
+}
+
+bool AvoidanceHelper::LinearProgram1(const std::vector<Line>& lines, size_t lineNo, float maxSpeed, const sf::Vector2f& optVelocity, bool directionOpt, sf::Vector2f& result)
+{
+	auto& line = lines[lineNo];
+	float dotProduct = Dot(line.point, line.direction);
+	float discriminant = dotProduct * dotProduct + maxSpeed * maxSpeed - Dot(line.point, line.point);
+	if (discriminant < 0.f) return false; //Max speed circle doesn't reach line
+
+	float sqrtDiscriminant = std::sqrt(discriminant);
+	float tLeft = -dotProduct - sqrtDiscriminant;
+	float tRight = -dotProduct + sqrtDiscriminant;
+	for (size_t i = 0; i < lineNo; i++)
+	{
+		float denominator = Det(line.direction, lines[i].direction);
+		float numerator = Det(lines[i].direction, line.point - lines[i].point);
+		if (std::fabs(denominator) <= AVOIDANCE_EPSILON) //Parallel lines
+		{
+			if (numerator < 0.f) return false;
+			continue;
+		}
+
+		float t = numerator / denominator;
+		if (denominator >= 0.f) tRight = std::min(tRight, t);
+		else tLeft = std::max(tLeft, t);
+		if (tLeft > tRight) return false;
+	}
+
+	if (directionOpt) //Furthest point in direction
+	{
+		if (Dot(optVelocity, line.direction) > 0.f) result = line.point + tRight * line.direction;
+		else result = line.point + tLeft * line.direction;
+	}
+	else //Closest point to velocity
+	{
+		float t = Dot(line.direction, optVelocity - line.point);
+		result = line.point + std::max(tLeft, std::min(t, tRight)) * line.direction;
+	}
+	return true;
+}
+
+size_t AvoidanceHelper::LinearProgram2(const std::vector<Line>& lines, float maxSpeed, const sf::Vector2f& optVelocity, bool directionOpt, sf::Vector2f& result)
+{
+	if (directionOpt) //Optimal velocity is unit direction then
+		result = optVelocity * maxSpeed;
+	else if (Dot(optVelocity, optVelocity) > maxSpeed * maxSpeed)
+		result = Normalize(optVelocity) * maxSpeed;
+	else
+		result = optVelocity;
+
+	for (size_t i = 0; i < lines.size(); i++)
+	{
+		if (Det(lines[i].direction, lines[i].point - result) <= 0.f) continue; //Result already satisfies line
+
+		auto tempResult = result;
+		if (LinearProgram1(lines, i, maxSpeed, optVelocity, directionOpt, result) == false)
+		{
+			result = tempResult;
+			return i;
+		}
+	}
+	return lines.size();
+}
+
+void AvoidanceHelper::LinearProgram3(const std::vector<Line>& lines, size_t hardLines, size_t beginLine, float maxSpeed, sf::Vector2f& result, std::vector<Line>& projected)
+{
+	float distance = 0.f;
+	for (size_t i = beginLine; i < lines.size(); i++)
+	{
+		if (Det(lines[i].direction, lines[i].point - result) <= distance) continue;
+
+		//Lines projected on line i, result may not go further behind them than behind line i
+		projected.assign(lines.begin(), lines.begin() + hardLines);
+		for (size_t j = hardLines; j < i; j++)
+		{
+			Line line;
+			float determinant = Det(lines[i].direction, lines[j].direction);
+			if (std::fabs(determinant) <= AVOIDANCE_EPSILON)
+			{
+				if (Dot(lines[i].direction, lines[j].direction) > 0.f) continue; //Same direction
+				line.point = 0.5f * (lines[i].point + lines[j].point);
+			}
+			else
+				line.point = lines[i].point + (Det(lines[j].direction, lines[i].point - lines[j].point) / determinant) * lines[i].direction;
+
+			line.direction = Normalize(lines[j].direction - lines[i].direction);
+			projected.push_back(line);
+		}
+
+		auto tempResult = result;
+		if (LinearProgram2(projected, maxSpeed, sf::Vector2f(-lines[i].direction.y, lines[i].direction.x), true, result) < projected.size())
+			result = tempResult; //Only rounding errors get here
+
+		distance = Det(lines[i].direction, lines[i].point - result);
+	}
+}
+
+void AvoidanceHelper::AddAgentLines(const sf::Vector2f& position, const sf::Vector2f& velocity, float radius, const std::vector<Neighbour>& neighbours, float timeHorizon, float deltaTime, std::vector<Line>& lines)
+{
+	float invTimeHorizon = 1.f / timeHorizon;
+	for (auto& neighbour : neighbours)
+	{
+		auto relativePosition = neighbour.position - position;
+		auto relativeVelocity = velocity - neighbour.velocity;
+		float distanceSq = Dot(relativePosition, relativePosition);
+		float combinedRadius = radius + neighbour.radius;
+		float combinedRadiusSq = combinedRadius * combinedRadius;
+
+		Line line;
+		sf::Vector2f u;
+		if (distanceSq > combinedRadiusSq) //No collision yet
+		{
+			//Vector from cutoff center to relative velocity
+			auto w = relativeVelocity - invTimeHorizon * relativePosition;
+			float wLengthSq = Dot(w, w);
+			float dotProduct = Dot(w, relativePosition);
+			if (dotProduct < 0.f && dotProduct * dotProduct > combinedRadiusSq * wLengthSq) //Project on cutoff circle
+			{
+				float wLength = std::sqrt(wLengthSq);
+				auto unitW = w / wLength;
+				line.direction = sf::Vector2f(unitW.y, -unitW.x);
+				u = (combinedRadius * invTimeHorizon - wLength) * unitW;
+			}
+			else //Project on legs
+			{
+				float leg = std::sqrt(distanceSq - combinedRadiusSq);
+				if (Det(relativePosition, w) > 0.f)
+					line.direction = sf::Vector2f(relativePosition.x * leg - relativePosition.y * combinedRadius, relativePosition.x * combinedRadius + relativePosition.y * leg) / distanceSq;
+				else
+					line.direction = -sf::Vector2f(relativePosition.x * leg + relativePosition.y * combinedRadius, -relativePosition.x * combinedRadius + relativePosition.y * leg) / distanceSq;
+				u = Dot(relativeVelocity, line.direction) * line.direction - relativeVelocity;
+			}
+		}
+		else //Already overlapping, get apart in one step
+		{
+			if (deltaTime <= 0.f) continue;
+
+			auto w = relativeVelocity - relativePosition / deltaTime;
+			float wLength = std::sqrt(Dot(w, w));
+			if (wLength <= AVOIDANCE_EPSILON) continue; //Same spot and velocity, no side to choose
+
+			auto unitW = w / wLength;
+			line.direction = sf::Vector2f(unitW.y, -unitW.x);
+			u = (combinedRadius / deltaTime - wLength) * unitW;
+		}
+
+		line.point = velocity + neighbour.responsibility * u;
+		lines.push_back(line);
+	}
+}
+
+void AvoidanceHelper::AddWallLine(float distanceToWall, const sf::Vector2f& away, float radius, float timeHorizon, float maxSpeed, std::vector<Line>& lines)
+{
+	auto normal = Normalize(-away); //Towards wall
+	if (normal.x == 0.f && normal.y == 0.f) return;
+
+	//Speed towards wall <= space left / horizon, pushing out of wall can't be faster than max speed
+	Line line;
+	line.point = normal * std::max((distanceToWall - radius) / timeHorizon, -maxSpeed);
+	line.direction = sf::Vector2f(-normal.y, normal.x);
+	lines.push_back(line);
+}
+
+sf::Vector2f AvoidanceHelper::GetVelocity(const std::vector<Line>& lines, size_t hardLines, const sf::Vector2f& preferred, float maxSpeed, std::vector<Line>& projected)
+{
+	sf::Vector2f result;
+	auto failed = LinearProgram2(lines, maxSpeed, preferred, false, result);
+	if (failed < lines.size())
+		LinearProgram3(lines, hardLines, failed, maxSpeed, result, projected);
+	return result;
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <vector>
+#include <cmath>
+#include <algorithm>
+
+#include "SFML/System/Vector2.hpp"
+
+//Optimal reciprocal collision avoidance (ORCA), every neighbour cuts half plane out of allowed velocities
+//Velocity closest to preferred one is found by incremental linear programming, based on RVO2 library
+class AvoidanceHelper
+{
+public:
+	//Velocities on left side of line are allowed
+	struct Line
+	{
+		sf::Vector2f point;
+		sf::Vector2f direction;
+	};
+	struct Neighbour
+	{
+		sf::Vector2f position;
+		sf::Vector2f velocity;
+		float radius;
+		float responsibility; //Part of avoidance taken by agent, 0.5 when neighbour avoids too
+	};
+private:
+	static float Det(const sf::Vector2f& first, const sf::Vector2f& second);
+	static float Dot(const sf::Vector2f& first, const sf::Vector2f& second);
+	static sf::Vector2f Normalize(const sf::Vector2f& vector);
+
+	//Best velocity on one line, limited by lines before it and max speed circle
+	static bool LinearProgram1(const std::vector<Line>& lines, size_t lineNo, float maxSpeed, const sf::Vector2f& optVelocity, bool directionOpt, sf::Vector2f& result);
+	//Returns index of first line that couldn't be satisfied, lines count if all are
+	static size_t LinearProgram2(const std::vector<Line>& lines, float maxSpeed, const sf::Vector2f& optVelocity, bool directionOpt, sf::Vector2f& result);
+	//Minimizes largest violation of soft lines, hard lines are kept
+	static void LinearProgram3(const std::vector<Line>& lines, size_t hardLines, size_t beginLine, float maxSpeed, sf::Vector2f& result, std::vector<Line>& projected);
+public:
+	//Time horizon and delta time are in units of velocities
+	static void AddAgentLines(const sf::Vector2f& position, const sf::Vector2f& velocity, float radius, const std::vector<Neighbour>& neighbours, float timeHorizon, float deltaTime, std::vector<Line>& lines);
+	//Velocity towards wall stays small enough to stop at radius from it, away is wall normal
+	static void AddWallLine(float distanceToWall, const sf::Vector2f& away, float radius, float timeHorizon, float maxSpeed, std::vector<Line>& lines);
+	//Hard lines have to be added first, projected is buffer for infeasible case
+	static sf::Vector2f GetVelocity(const std::vector<Line>& lines, size_t hardLines, const sf::Vector2f& preferred, float maxSpeed, std::vector<Line>& projected);
+};
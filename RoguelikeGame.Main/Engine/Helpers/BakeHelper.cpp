@@ -0,0 +1,27 @@
+#include "BakeHelper.h"
+
+bool BakeHelper::BakePathfindingGraph(const std::string& mapPath)
+{
+	auto logger = Logger::GetInstance();
+	logger->Log(Logger::LogType::INFO, "Baking pathfinding graph: " + mapPath);
+
+	GameMap<unsigned char> map;
+	if (map.LoadFromFile(mapPath) == false)
+		return false;
+
+	//Same collision setup as Game::LoadLevel
+	CollisionsManager collisions;
+	collisions.AddMap(*map.GetActionMap(), (unsigned char)1);
+	collisions.GenerateCommonMap();
+	collisions.CovertTilesIntoEdges();
+
+	PathfindingManager pathfinding;
+	pathfinding.GenerateBaseGraph(map.GetPathfindingPoints(), &collisions, PathfindingManager::GraphBuildOptions());
+
+	auto hash = PathfindingManager::GetBaseGraphHash(collisions.GetCommonMap(), map.GetPathfindingPoints());
+	if (pathfinding.SaveBaseGraphToFile(mapPath + ".graph", hash) == false)
+		return false;
+
+	logger->Log(Logger::LogType::INFO, "Saved " + std::to_string(pathfinding.GetBaseGraphLinks().size()) + " links to " + mapPath + ".graph");
+	return true;
+}
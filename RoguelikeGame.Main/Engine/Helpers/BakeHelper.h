@@ -0,0 +1,12 @@
+#pragma once
+
+#include "../Core/Logger.h"
+#include "../Managers/PathfindingManager.h"
+#include "../Managers/CollisionsManager.h"
+#include "../Models/GameMap.h"
+
+class BakeHelper
+{
+public:
+	static bool BakePathfindingGraph(const std::string& mapPath);
+};
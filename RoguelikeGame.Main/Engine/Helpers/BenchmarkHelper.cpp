@@ -0,0 +1,519 @@
+#include "BenchmarkHelper.h"
+
+namespace
+{
+	//Reference copy of the list-sorting solver, kept only to measure against
+	struct LegacyCell
+	{
+		bool visited = false;
+
+		sf::Vector2f pos;
+		float localGoal = INFINITY;
+		float globalGoal = INFINITY;
+
+		LegacyCell* parent = nullptr;
+		std::map<LegacyCell*, float> neighbours;
+	};
+
+	Paths LegacySolveDijkstras(std::list<LegacyCell>& graph, LegacyCell* startCell)
+	{
+		for (auto it = graph.begin(); it != graph.end(); it++)
+		{
+			it->visited = false;
+			it->globalGoal = INFINITY;
+			it->localGoal = INFINITY;
+			it->parent = nullptr;
+		}
+
+		LegacyCell* currentCell = startCell;
+		startCell->localGoal = 0.0f;
+		startCell->globalGoal = 0.0f;
+
+		std::list<LegacyCell*> listNotTestedNodes;
+		listNotTestedNodes.push_back(startCell);
+
+		while (!listNotTestedNodes.empty())
+		{
+			listNotTestedNodes.sort([](const LegacyCell* lhs, const LegacyCell* rhs) { return lhs->globalGoal < rhs->globalGoal; });
+
+			while (!listNotTestedNodes.empty() && listNotTestedNodes.front()->visited)
+				listNotTestedNodes.pop_front();
+
+			if (listNotTestedNodes.empty())
+				break;
+
+			currentCell = listNotTestedNodes.front();
+			currentCell->visited = true;
+
+			for (auto& nodeNeighbour : currentCell->neighbours)
+			{
+				if (!nodeNeighbour.first->visited)
+					listNotTestedNodes.push_back(nodeNeighbour.first);
+
+				float fPossiblyLowerGoal = currentCell->localGoal + nodeNeighbour.second;
+				if (fPossiblyLowerGoal < nodeNeighbour.first->localGoal)
+				{
+					nodeNeighbour.first->parent = currentCell;
+					nodeNeighbour.first->localGoal = fPossiblyLowerGoal;
+					nodeNeighbour.first->globalGoal = nodeNeighbour.first->localGoal;
+				}
+			}
+		}
+
+		Paths paths;
+		for (auto it = graph.begin(); it != graph.end(); it++)
+		{
+			if (it->parent == nullptr) paths[Vector2MapKey<float>(it->pos)] = sf::Vector2f(INFINITY, INFINITY);
+			else paths[Vector2MapKey<float>(it->pos)] = it->parent->pos;
+		}
+		return paths;
+	}
+
+	//Reference copy of the raycast testing every edge
+	sf::Vector2f LegacyRayHitpoint(const std::vector<std::tuple<sf::Vector2f, sf::Vector2f>>& edges, const sf::Vector2f& center, float angle, float raycastRange)
+	{
+		auto endPoint = MathHelper::GetPointFromAngle(center, angle, raycastRange);
+
+		sf::Vector2f closest = endPoint;
+		float currDst = raycastRange;
+		for (auto& l : edges)
+		{
+			auto hitpoint = MathHelper::GetLinesIntersection(center, endPoint, std::get<0>(l), std::get<1>(l));
+			auto distance = MathHelper::GetDistanceBetweenPoints(center, hitpoint);
+			if (distance < currDst)
+			{
+				currDst = distance;
+				closest = hitpoint;
+			}
+		}
+		return closest;
+	}
+}
+
+void BenchmarkHelper::LogResult(const std::string& name, const std::chrono::microseconds& legacy, const std::chrono::microseconds& current, size_t runs, size_t mismatches)
+{
+	auto legacyAvg = (double)legacy.count() / (double)std::max<size_t>(runs, 1);
+	auto currentAvg = (double)current.count() / (double)std::max<size_t>(runs, 1);
+	auto speedup = (currentAvg > 0.0) ? legacyAvg / currentAvg : 0.0;
+
+	std::stringstream ss;
+	ss << std::fixed << std::setprecision(2) << name << ": legacy avg(" << legacyAvg << "us)  heap avg(" << currentAvg << "us)  speedup(" << speedup << "x)  runs(" << runs << ")";
+	Logger::GetInstance()->Log(Logger::LogType::INFO, ss.str());
+
+	if (mismatches > 0)
+		Logger::GetInstance()->Log(Logger::LogType::WARNING, name + ": " + std::to_string(mismatches) + " nodes got a different parent");
+}
+
+void BenchmarkHelper::ComparePathfindingSolvers(const std::string& name, PathfindingManager* pathfinding, size_t runs)
+{
+	auto points = pathfinding->GetBaseGraphPoints();
+	auto links = pathfinding->GetBaseGraphLinks();
+	if (points.size() == 0 || runs == 0)
+	{
+		Logger::GetInstance()->Log(Logger::LogType::WARNING, name + ": empty graph, skipped");
+		return;
+	}
+
+	//Build legacy graph copy
+	std::list<LegacyCell> legacyGraph;
+	std::vector<LegacyCell*> legacyCells;
+	for (auto& p : points)
+	{
+		LegacyCell c;
+		c.pos = p;
+		legacyGraph.push_back(c);
+		legacyCells.push_back(&legacyGraph.back());
+	}
+	for (auto& l : links)
+		legacyCells[std::get<0>(l)]->neighbours[legacyCells[std::get<1>(l)]] = std::get<2>(l);
+
+	auto stopwatch = Stopwatch::GetInstance();
+	std::chrono::microseconds legacyTime(0);
+	std::chrono::microseconds currentTime(0);
+	size_t mismatches = 0;
+
+	for (size_t i = 0; i < runs; i++)
+	{
+		size_t startNode = (i * points.size()) / runs;
+
+		stopwatch->Start("benchmark_legacy");
+		auto legacyPaths = LegacySolveDijkstras(legacyGraph, legacyCells[startNode]);
+		legacyTime += stopwatch->Stop("benchmark_legacy");
+
+		stopwatch->Start("benchmark_current");
+		auto currentPaths = pathfinding->GetDijkstrasPath(startNode);
+		currentTime += stopwatch->Stop("benchmark_current");
+
+		for (auto& p : legacyPaths)
+		{
+			auto found = currentPaths.find(p.first);
+			if (found == currentPaths.end() || found->second != p.second)
+				mismatches++;
+		}
+	}
+
+	LogResult(name + " (" + std::to_string(points.size()) + " nodes, " + std::to_string(links.size()) + " links)", legacyTime, currentTime, runs, mismatches);
+}
+
+void BenchmarkHelper::CompareGraphBuilders(const std::string& name, const std::vector<sf::Vector2f>& points, CollisionsManager* collisions)
+{
+	auto stopwatch = Stopwatch::GetInstance();
+
+	PathfindingManager allPairs;
+	stopwatch->Start("benchmark_graph_legacy");
+	allPairs.GenerateBaseGraph(points, collisions);
+	auto legacyTime = stopwatch->Stop("benchmark_graph_legacy");
+
+	PathfindingManager accelerated;
+	stopwatch->Start("benchmark_graph_current");
+	accelerated.GenerateBaseGraph(points, collisions, PathfindingManager::GraphBuildOptions());
+	auto currentTime = stopwatch->Stop("benchmark_graph_current");
+
+	auto legacyLinks = allPairs.GetBaseGraphLinks();
+	auto currentLinks = accelerated.GetBaseGraphLinks();
+	size_t mismatches = (legacyLinks.size() > currentLinks.size()) ? legacyLinks.size() - currentLinks.size() : currentLinks.size() - legacyLinks.size();
+	for (size_t i = 0; i < std::min(legacyLinks.size(), currentLinks.size()); i++)
+		if (legacyLinks[i] != currentLinks[i])
+			mismatches++;
+
+	std::stringstream ss;
+	ss << std::fixed << std::setprecision(2) << name << " graph build (" << points.size() << " nodes, " << currentLinks.size() << " links): all pairs("
+		<< legacyTime.count() << "us)  accelerated(" << currentTime.count() << "us)  speedup(" << ((currentTime.count() > 0) ? (double)legacyTime.count() / (double)currentTime.count() : 0.0) << "x)";
+	Logger::GetInstance()->Log(Logger::LogType::INFO, ss.str());
+
+	if (mismatches > 0)
+		Logger::GetInstance()->Log(Logger::LogType::WARNING, name + ": " + std::to_string(mismatches) + " graph links differ");
+}
+
+void BenchmarkHelper::CompareIncrementalTree(const std::string& name, PathfindingManager* pathfinding, CollisionsManager* collisions, size_t steps, float tolerance)
+{
+	auto points = pathfinding->GetBaseGraphPoints();
+	if (points.size() == 0 || steps == 0)
+	{
+		Logger::GetInstance()->Log(Logger::LogType::WARNING, name + ": empty graph, skipped");
+		return;
+	}
+
+	//Random walk of the root, both solvers get the same positions
+	srand(99U);
+	auto stopwatch = Stopwatch::GetInstance();
+	std::chrono::microseconds fullTime(0);
+	std::chrono::microseconds incrementalTime(0);
+	size_t repaired = 0;
+	size_t mismatches = 0;
+
+	pathfinding->ClearIncrementalTree();
+	sf::Vector2f root = points[points.size() / 2];
+	for (size_t i = 0; i < steps; i++)
+	{
+		sf::Vector2f next = root + sf::Vector2f((float)(rand() % 7 - 3), (float)(rand() % 7 - 3));
+		if (collisions->CheckCircleCollision(next, 2.f) == false)
+			root = next;
+
+		stopwatch->Start("benchmark_full");
+		auto fullPaths = pathfinding->GetDijkstrasPath(root, collisions);
+		fullTime += stopwatch->Stop("benchmark_full");
+
+		stopwatch->Start("benchmark_incremental");
+		repaired += pathfinding->UpdateIncrementalTree(root, collisions, tolerance);
+		incrementalTime += stopwatch->Stop("benchmark_incremental");
+
+		//Ties can pick other parent, so path lengths are compared, only exact tree can be checked
+		if (tolerance > 0.f) continue;
+		auto& incrementalPaths = pathfinding->GetIncrementalPaths();
+		auto pathLength = [](const Paths& paths, sf::Vector2f pos)
+		{
+			float length = 0.f;
+			for (size_t guard = 0; guard < paths.size(); guard++)
+			{
+				auto found = paths.find(Vector2MapKey<float>(pos));
+				if (found == paths.end()) return -1.f;
+				if (found->second.x == INFINITY) return length;
+				length += MathHelper::GetDistanceBetweenPoints(pos, found->second);
+				pos = found->second;
+			}
+			return -1.f;
+		};
+		for (auto& p : fullPaths)
+			if (fabsf(pathLength(fullPaths, p.first) - pathLength(incrementalPaths, p.first)) > 0.05f)
+				mismatches++;
+	}
+
+	std::stringstream ss;
+	ss << std::fixed << std::setprecision(2) << name << " moving root (" << steps << " steps, tolerance " << tolerance << "): full avg(" << (double)fullTime.count() / (double)steps
+		<< "us)  incremental avg(" << (double)incrementalTime.count() / (double)steps << "us)  repaired avg(" << (double)repaired / (double)steps << " of " << points.size() << " nodes)";
+	Logger::GetInstance()->Log(Logger::LogType::INFO, ss.str());
+
+	if (mismatches > 0)
+		Logger::GetInstance()->Log(Logger::LogType::WARNING, name + ": " + std::to_string(mismatches) + " nodes got a different path length");
+}
+
+void BenchmarkHelper::CompareGridPlanners(const std::string& name, CollisionsManager* collisions, size_t runs)
+{
+	auto tiles = collisions->GetCommonMap();
+	if (tiles->data.size() == 0 || runs == 0)
+	{
+		Logger::GetInstance()->Log(Logger::LogType::WARNING, name + ": empty map, skipped");
+		return;
+	}
+
+	auto stopwatch = Stopwatch::GetInstance();
+	PathfindingManager pathfinding;
+	HierarchicalPathfindingManager hierarchical;
+	stopwatch->Start("benchmark_hierarchical_build");
+	hierarchical.Build(collisions);
+	auto buildTime = stopwatch->Stop("benchmark_hierarchical_build");
+
+	//Long range queries between random free tiles
+	srand(77U);
+	std::chrono::microseconds jpsTime(0);
+	std::chrono::microseconds hierarchicalTime(0);
+	size_t jpsExpanded = 0;
+	size_t hierarchicalExpanded = 0;
+	size_t mismatches = 0;
+	for (size_t i = 0; i < runs; i++)
+	{
+		sf::Vector2f start(tiles->offsetX + (float)(rand() % (tiles->width * tiles->tileWidth)), tiles->offsetY + (float)(rand() % (tiles->height * tiles->tileHeight)));
+		sf::Vector2f end(tiles->offsetX + (float)(rand() % (tiles->width * tiles->tileWidth)), tiles->offsetY + (float)(rand() % (tiles->height * tiles->tileHeight)));
+		size_t expanded = 0;
+
+		stopwatch->Start("benchmark_jps");
+		auto jpsPath = pathfinding.GetJPSPath(start, end, collisions, 0.f, &expanded);
+		jpsTime += stopwatch->Stop("benchmark_jps");
+		jpsExpanded += expanded;
+
+		stopwatch->Start("benchmark_hierarchical");
+		auto hierarchicalPath = hierarchical.GetPath(start, end, 0.f, &expanded);
+		hierarchicalTime += stopwatch->Stop("benchmark_hierarchical");
+		hierarchicalExpanded += expanded;
+
+		if (jpsPath.empty() != hierarchicalPath.empty())
+			mismatches++;
+	}
+
+	std::stringstream ss;
+	ss << std::fixed << std::setprecision(2) << name << " grid planners (" << tiles->width << "x" << tiles->height << " tiles, " << hierarchical.GetClustersCount() << " clusters, "
+		<< hierarchical.GetEntrancesCount() << " entrances, build " << buildTime.count() << "us): jps avg(" << (double)jpsTime.count() / (double)runs << "us, "
+		<< (double)jpsExpanded / (double)runs << " nodes)  hierarchical avg(" << (double)hierarchicalTime.count() / (double)runs << "us, " << (double)hierarchicalExpanded / (double)runs << " nodes)";
+	Logger::GetInstance()->Log(Logger::LogType::INFO, ss.str());
+
+	if (mismatches > 0)
+		Logger::GetInstance()->Log(Logger::LogType::WARNING, name + ": " + std::to_string(mismatches) + " queries found a path in only one planner");
+}
+
+void BenchmarkHelper::CompareRaycasts(const std::string& name, CollisionsManager* collisions, size_t runs)
+{
+	auto tiles = collisions->GetCommonMap();
+	if (tiles->data.size() == 0 || runs == 0)
+	{
+		Logger::GetInstance()->Log(Logger::LogType::WARNING, name + ": empty map, skipped");
+		return;
+	}
+
+	//Random rays from anywhere on the map, same set for both
+	srand(99U);
+	std::vector<std::tuple<sf::Vector2f, float, float>> rays;
+	rays.reserve(runs);
+	for (size_t i = 0; i < runs; i++)
+	{
+		sf::Vector2f center(tiles->offsetX + (float)(rand() % (tiles->width * tiles->tileWidth * 10)) / 10.f, tiles->offsetY + (float)(rand() % (tiles->height * tiles->tileHeight * 10)) / 10.f);
+		rays.emplace_back(center, (float)(rand() % 36000) / 100.f - 180.f, 20.f + (float)(rand() % 600));
+	}
+
+	auto stopwatch = Stopwatch::GetInstance();
+	std::vector<sf::Vector2f> legacyHits(runs);
+	std::vector<sf::Vector2f> currentHits(runs);
+
+	stopwatch->Start("benchmark_raycast_legacy");
+	for (size_t i = 0; i < runs; i++)
+		legacyHits[i] = LegacyRayHitpoint(*collisions->GetEdges(), std::get<0>(rays[i]), std::get<1>(rays[i]), std::get<2>(rays[i]));
+	auto legacyTime = stopwatch->Stop("benchmark_raycast_legacy");
+
+	stopwatch->Start("benchmark_raycast");
+	for (size_t i = 0; i < runs; i++)
+		currentHits[i] = collisions->GetRayHitpoint(std::get<0>(rays[i]), std::get<1>(rays[i]), std::get<2>(rays[i]));
+	auto currentTime = stopwatch->Stop("benchmark_raycast");
+
+	//Tiles walk used when edges are not built
+	stopwatch->Start("benchmark_raycast_tiles");
+	for (size_t i = 0; i < runs; i++)
+	{
+		auto endPoint = MathHelper::GetPointFromAngle(std::get<0>(rays[i]), std::get<1>(rays[i]), std::get<2>(rays[i]));
+		CollisionHelper::GetSegmentEdgeHit(std::get<0>(rays[i]), endPoint, tiles);
+	}
+	auto tilesTime = stopwatch->Stop("benchmark_raycast_tiles");
+
+	size_t mismatches = 0;
+	for (size_t i = 0; i < runs; i++)
+		if (MathHelper::GetDistanceBetweenPoints(legacyHits[i], currentHits[i]) > 0.05f)
+			mismatches++;
+
+	std::stringstream ss;
+	ss << std::fixed << std::setprecision(3) << name << " raycasts (" << collisions->GetEdges()->size() << " edges): all edges avg(" << (double)legacyTime.count() / (double)runs
+		<< "us)  edges grid avg(" << (double)currentTime.count() / (double)runs << "us)  tiles avg(" << (double)tilesTime.count() / (double)runs << "us)  runs(" << runs << ")";
+	Logger::GetInstance()->Log(Logger::LogType::INFO, ss.str());
+
+	if (mismatches > 0)
+		Logger::GetInstance()->Log(Logger::LogType::WARNING, name + ": " + std::to_string(mismatches) + " rays hit a different point");
+}
+
+void BenchmarkHelper::CompareVisibilityCache(const std::string& name, const std::vector<sf::Vector2f>& points, CollisionsManager* collisions, size_t frames)
+{
+	if (points.size() == 0 || frames == 0)
+	{
+		Logger::GetInstance()->Log(Logger::LogType::WARNING, name + ": empty graph, skipped");
+		return;
+	}
+
+	PathfindingManager cached;
+	PathfindingManager uncached;
+	cached.GenerateBaseGraph(points, collisions, PathfindingManager::GraphBuildOptions());
+	uncached.GenerateBaseGraph(points, collisions, PathfindingManager::GraphBuildOptions());
+	uncached.SetVisibilityCacheCapacity(0);
+
+	//Few enemies wandering around, target moves every few frames
+	srand(55U);
+	auto tiles = collisions->GetCommonMap();
+	std::vector<sf::Vector2f> enemies;
+	for (size_t guard = 0; enemies.size() < 20 && guard < 10000; guard++)
+	{
+		sf::Vector2f pos(tiles->offsetX + (float)(rand() % (tiles->width * tiles->tileWidth)), tiles->offsetY + (float)(rand() % (tiles->height * tiles->tileHeight)));
+		if (collisions->CheckCircleCollision(pos, 4.f) == false)
+			enemies.push_back(pos);
+	}
+
+	auto stopwatch = Stopwatch::GetInstance();
+	std::chrono::microseconds cachedTime(0);
+	std::chrono::microseconds uncachedTime(0);
+	size_t mismatches = 0;
+	sf::Vector2f target;
+	Paths paths;
+	for (size_t i = 0; i < frames; i++)
+	{
+		if (i % 25 == 0)
+		{
+			target = points[(size_t)rand() % points.size()];
+			paths = uncached.GetDijkstrasPath(target, collisions);
+		}
+
+		for (auto& enemy : enemies)
+		{
+			sf::Vector2f next = enemy + sf::Vector2f((float)(rand() % 5 - 2), (float)(rand() % 5 - 2));
+			if (collisions->CheckCircleCollision(next, 4.f) == false)
+				enemy = next;
+
+			stopwatch->Start("benchmark_cached");
+			auto cachedNode = cached.GetClosestVisibleNodeTo(paths, enemy, target, collisions);
+			cachedTime += stopwatch->Stop("benchmark_cached");
+
+			stopwatch->Start("benchmark_uncached");
+			auto uncachedNode = uncached.GetClosestVisibleNodeTo(paths, enemy, target, collisions);
+			uncachedTime += stopwatch->Stop("benchmark_uncached");
+
+			if (cachedNode != uncachedNode)
+				mismatches++;
+		}
+	}
+
+	auto& stats = cached.GetCacheStats();
+	auto queries = (double)(frames * enemies.size());
+	std::stringstream ss;
+	ss << std::fixed << std::setprecision(2) << name << " closest visible node (" << (size_t)queries << " queries): uncached avg(" << (double)uncachedTime.count() / queries
+		<< "us)  cached avg(" << (double)cachedTime.count() / queries << "us)  cell hits(" << stats.visibilityHits << ")  cell misses(" << stats.visibilityMisses << ")";
+	Logger::GetInstance()->Log(Logger::LogType::INFO, ss.str());
+
+	if (mismatches > 0)
+		Logger::GetInstance()->Log(Logger::LogType::WARNING, name + ": " + std::to_string(mismatches) + " queries picked a different node");
+}
+
+void BenchmarkHelper::RunPathfinding(const std::string& mapPath)
+{
+	auto logger = Logger::GetInstance();
+	logger->Log(Logger::LogType::INFO, "Pathfinding benchmark");
+
+	//Real map
+	GameMap<unsigned char> map;
+	if (map.LoadFromFile(mapPath))
+	{
+		CollisionsManager collisions;
+		collisions.AddMap(*map.GetActionMap(), (unsigned char)1);
+		collisions.GenerateCommonMap();
+		collisions.CovertTilesIntoEdges();
+
+		PathfindingManager pathfinding;
+		pathfinding.GenerateBaseGraph(map.GetPathfindingPoints(), &collisions);
+		ComparePathfindingSolvers(mapPath, &pathfinding, map.GetPathfindingPoints().size());
+		CompareGraphBuilders(mapPath, map.GetPathfindingPoints(), &collisions);
+		CompareRaycasts(mapPath, &collisions, 100000);
+	}
+	else
+		logger->Log(Logger::LogType::ERROR, "Unable to load benchmark map: " + mapPath);
+
+	//Synthetic 128x128 tiles map with random walls and a few hundred pathfind points
+	{
+		srand(4321U);
+		MapLayerModel<unsigned char> layer;
+		layer.width = 128;
+		layer.height = 128;
+		layer.tileWidth = 16;
+		layer.tileHeight = 16;
+		layer.data.resize((size_t)layer.width * layer.height, 0);
+		for (unsigned int y = 0; y < layer.height; y++)
+			for (unsigned int x = 0; x < layer.width; x++)
+				if (x == 0 || y == 0 || x == layer.width - 1 || y == layer.height - 1 || rand() % 100 < 8)
+					layer.data[(size_t)y * layer.width + x] = 1;
+
+		std::vector<sf::Vector2f> mapPoints;
+		for (unsigned int y = 3; y < layer.height; y += 6)
+			for (unsigned int x = 3; x < layer.width; x += 6)
+				if (layer.data[(size_t)y * layer.width + x] == 0)
+					mapPoints.emplace_back((float)x * 16.f + 8.f, (float)y * 16.f + 8.f);
+
+		CollisionsManager collisions;
+		collisions.AddMap(layer, (unsigned char)1);
+		collisions.GenerateCommonMap();
+		collisions.CovertTilesIntoEdges();
+		CompareGraphBuilders("synthetic map", mapPoints, &collisions);
+
+		PathfindingManager pathfinding;
+		pathfinding.GenerateBaseGraph(mapPoints, &collisions, PathfindingManager::GraphBuildOptions());
+		CompareIncrementalTree("synthetic map", &pathfinding, &collisions, 100, 0.f);
+		CompareIncrementalTree("synthetic map", &pathfinding, &collisions, 100, 8.f);
+		CompareGridPlanners("synthetic map", &collisions, 200);
+		CompareRaycasts("synthetic map", &collisions, 100000);
+		CompareVisibilityCache("synthetic map", mapPoints, &collisions, 500);
+	}
+
+	//Synthetic 100x100 grid with 8 neighbours and jittered weights
+	const size_t size = 100;
+	const float spacing = 16.f;
+	std::vector<sf::Vector2f> points;
+	std::vector<GraphLink> links;
+	points.reserve(size * size);
+	for (size_t y = 0; y < size; y++)
+		for (size_t x = 0; x < size; x++)
+			points.emplace_back((float)x * spacing, (float)y * spacing);
+
+	srand(1234U);
+	for (size_t y = 0; y < size; y++)
+		for (size_t x = 0; x < size; x++)
+			for (int dy = -1; dy <= 1; dy++)
+				for (int dx = -1; dx <= 1; dx++)
+				{
+					if (dx == 0 && dy == 0) continue;
+					int nx = (int)x + dx;
+					int ny = (int)y + dy;
+					if (nx < 0 || ny < 0 || nx >= (int)size || ny >= (int)size) continue;
+
+					size_t from = y * size + x;
+					size_t to = (size_t)ny * size + (size_t)nx;
+					float jitter = 1.f + (float)(rand() % 1000) / 1000.f;
+					links.emplace_back(from, to, MathHelper::GetDistanceBetweenPoints(points[from], points[to]) * jitter);
+				}
+
+	PathfindingManager synthetic;
+	synthetic.LoadBaseGraph(points, links);
+	ComparePathfindingSolvers("synthetic", &synthetic, 5);
+
+	logger->Log(Logger::LogType::INFO, "Pathfinding benchmark done");
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <sstream>
+#include <iomanip>
+
+#include "../Core/Logger.h"
+#include "../Managers/PathfindingManager.h"
+#include "../Managers/HierarchicalPathfindingManager.h"
+#include "../Managers/CollisionsManager.h"
+#include "../Models/GameMap.h"
+
+class BenchmarkHelper
+{
+private:
+	static void LogResult(const std::string& name, const std::chrono::microseconds& legacy, const std::chrono::microseconds& current, size_t runs, size_t mismatches);
+	static void ComparePathfindingSolvers(const std::string& name, PathfindingManager* pathfinding, size_t runs);
+	static void CompareIncrementalTree(const std::string& name, PathfindingManager* pathfinding, CollisionsManager* collisions, size_t steps, float tolerance);
+	static void CompareGraphBuilders(const std::string& name, const std::vector<sf::Vector2f>& points, CollisionsManager* collisions);
+	static void CompareGridPlanners(const std::string& name, CollisionsManager* collisions, size_t runs);
+	static void CompareRaycasts(const std::string& name, CollisionsManager* collisions, size_t runs);
+	static void CompareVisibilityCache(const std::string& name, const std::vector<sf::Vector2f>& points, CollisionsManager* collisions, size_t frames);
+public:
+	static void RunPathfinding(const std::string& mapPath);
+};
@@ -78,6 +78,48 @@ bool CollisionHelper::CheckTileCollision(const sf::Vector2f& center, float radiu
     return false;
 }
 
+bool CollisionHelper::CheckTileCollision(const sf::FloatRect& obj, const MapLayerModel<bool>* tiles, const BitGrid* blocked)
+{
+    auto pos = GetPosOnTiles(obj, tiles);
+    if (pos.y < 0 || pos.y >(int)blocked->GetHeight() - 1 ||
+        pos.w < 0 || pos.w >(int)blocked->GetHeight() - 1 ||
+        pos.x < 0 || pos.x >(int)blocked->GetWidth() - 1 ||
+        pos.z < 0 || pos.z >(int)blocked->GetWidth() - 1)
+        return false;
+
+    return blocked->Get(pos.x, pos.y) || blocked->Get(pos.z, pos.y) || blocked->Get(pos.x, pos.w) || blocked->Get(pos.z, pos.w);
+}
+
+bool CollisionHelper::CheckTileCollision(const sf::Vector2f& center, float radius, const MapLayerModel<bool>* tiles, const BitGrid* blocked)
+{
+    auto tl = GetPosOnTiles(sf::Vector2f(center.x - radius, center.y - radius), tiles);
+    auto dr = GetPosOnTiles(sf::Vector2f(center.x + radius, center.y + radius), tiles);
+    sf::IntRect area(tl.x, tl.y, dr.x - tl.x + 1, dr.y - tl.y + 1);
+
+    //Whole words are checked first, usually there is nothing blocked around
+    if (blocked->AnyInRect(area) == false)
+        return false;
+
+    return blocked->FindInRect(area, [&](int x, int y)
+    {
+        auto tileCenter = sf::Vector2f((float)((float)x * tiles->tileWidth + ((float)tiles->tileWidth / 2.f)) - tiles->offsetX,
+                                       (float)((float)y * tiles->tileHeight + ((float)tiles->tileHeight / 2.f)) - tiles->offsetY);
+        sf::Vector2f circleDistance;
+        circleDistance.x = abs(center.x - tileCenter.x);
+        circleDistance.y = abs(center.y - tileCenter.y);
+
+        if (circleDistance.x > ((float)tiles->tileWidth / 2.f + radius)) return false;
+        if (circleDistance.y > ((float)tiles->tileHeight / 2.f + radius)) return false;
+
+        if (circleDistance.x <= ((float)tiles->tileWidth / 2.f)) return true;
+        if (circleDistance.y <= ((float)tiles->tileHeight / 2.f)) return true;
+
+        auto cX = circleDistance.x - ((float)tiles->tileWidth / 2.f);
+        auto cY = circleDistance.y - ((float)tiles->tileHeight / 2.f);
+        return (cX * cX + cY * cY <= radius * radius);
+    });
+}
+
 bool CollisionHelper::CheckRectContains(const sf::IntRect& outer, const sf::IntRect& inner)
 {
     return (inner.left >= outer.left && inner.left + inner.width <= outer.left + outer.width &&
@@ -332,3 +374,370 @@ std::vector<sf::Vector2f> CollisionHelper::GetRectPoints(const sf::FloatRect& re
 
     return output;
 }
+
+float CollisionHelper::GetSegmentTileEntry(const sf::Vector2f& startPos, const sf::Vector2f& endPos, float margin, const MapLayerModel<bool>* tiles)
+{
+    if (tiles->width == 0 || tiles->height == 0 || tiles->tileWidth == 0 || tiles->tileHeight == 0)
+        return INFINITY;
+
+    double tw = (double)tiles->tileWidth;
+    double th = (double)tiles->tileHeight;
+    double dirX = (double)endPos.x - startPos.x;
+    double dirY = (double)endPos.y - startPos.y;
+    double length = sqrt(dirX * dirX + dirY * dirY);
+
+    //Segment entry into closed box, as fraction of segment length
+    auto slab = [&](double left, double top, double right, double bottom) -> double
+    {
+        double tMin = 0.0, tMax = 1.0;
+        double p[2] = { startPos.x, startPos.y };
+        double d[2] = { dirX, dirY };
+        double lo[2] = { left, top };
+        double hi[2] = { right, bottom };
+        for (int i = 0; i < 2; i++)
+        {
+            if (d[i] == 0.0)
+            {
+                if (p[i] < lo[i] || p[i] > hi[i]) return INFINITY;
+                continue;
+            }
+            double t1 = (lo[i] - p[i]) / d[i];
+            double t2 = (hi[i] - p[i]) / d[i];
+            if (t1 > t2) std::swap(t1, t2);
+            tMin = std::max(tMin, t1);
+            tMax = std::min(tMax, t2);
+            if (tMin > tMax) return INFINITY;
+        }
+        return tMin;
+    };
+
+    //Walk tiles under the segment in tile units
+    double sx = ((double)startPos.x - tiles->offsetX) / tw;
+    double sy = ((double)startPos.y - tiles->offsetY) / th;
+    double dx = dirX / tw;
+    double dy = dirY / th;
+    int x = (int)floor(sx);
+    int y = (int)floor(sy);
+    int endX = (int)floor(sx + dx);
+    int endY = (int)floor(sy + dy);
+    int stepX = (dx > 0) ? 1 : ((dx < 0) ? -1 : 0);
+    int stepY = (dy > 0) ? 1 : ((dy < 0) ? -1 : 0);
+    double tDeltaX = (dx != 0) ? 1.0 / fabs(dx) : INFINITY;
+    double tDeltaY = (dy != 0) ? 1.0 / fabs(dy) : INFINITY;
+    double tMaxX = (dx > 0) ? ((double)x + 1.0 - sx) / dx : ((dx < 0) ? (sx - (double)x) / -dx : INFINITY);
+    double tMaxY = (dy > 0) ? ((double)y + 1.0 - sy) / dy : ((dy < 0) ? (sy - (double)y) / -dy : INFINITY);
+
+    double best = INFINITY;
+    double tEntry = 0.0;
+    int steps = abs(endX - x) + abs(endY - y) + 1;
+    for (int i = 0; i < steps && tEntry <= best; i++)
+    {
+        //Neighbours are checked too, margin can reach them
+        for (int ny = y - 1; ny <= y + 1; ny++)
+            for (int nx = x - 1; nx <= x + 1; nx++)
+            {
+                if (nx < 0 || ny < 0 || nx > (int)tiles->width - 1 || ny > (int)tiles->height - 1) continue;
+                if (tiles->data[(size_t)ny * tiles->width + nx] == false) continue;
+
+                double left = (double)nx * tw + tiles->offsetX - margin;
+                double top = (double)ny * th + tiles->offsetY - margin;
+                double t = slab(left, top, left + tw + 2.0 * margin, top + th + 2.0 * margin);
+                if (t < best) best = t;
+            }
+
+        if (tMaxX < tMaxY)
+        {
+            tEntry = tMaxX;
+            tMaxX += tDeltaX;
+            x += stepX;
+        }
+        else
+        {
+            tEntry = tMaxY;
+            tMaxY += tDeltaY;
+            y += stepY;
+        }
+    }
+
+    return (best == INFINITY) ? INFINITY : (float)(best * length);
+}
+
+float CollisionHelper::GetSegmentEdgeHit(const sf::Vector2f& startPos, const sf::Vector2f& endPos, const MapLayerModel<bool>* tiles)
+{
+    if (tiles->width == 0 || tiles->height == 0 || tiles->tileWidth == 0 || tiles->tileHeight == 0)
+        return INFINITY;
+
+    int width = (int)tiles->width;
+    int height = (int)tiles->height;
+    auto blocked = [tiles, width, height](int x, int y)
+    {
+        return x >= 0 && y >= 0 && x < width && y < height && tiles->data[(size_t)y * width + x];
+    };
+
+    //Segment in tile units
+    double sx = ((double)startPos.x - tiles->offsetX) / (double)tiles->tileWidth;
+    double sy = ((double)startPos.y - tiles->offsetY) / (double)tiles->tileHeight;
+    double dx = ((double)endPos.x - startPos.x) / (double)tiles->tileWidth;
+    double dy = ((double)endPos.y - startPos.y) / (double)tiles->tileHeight;
+
+    //Segment that never touches the map can't cross any edge
+    if (std::min(sx, sx + dx) > width || std::max(sx, sx + dx) < 0.0 || std::min(sy, sy + dy) > height || std::max(sy, sy + dy) < 0.0)
+        return INFINITY;
+
+    //Points this close to a grid line are treated as lying on it, so corners are not missed because of rounding
+    auto onLine = [](double& value)
+    {
+        double rounded = floor(value + 0.5);
+        if (fabs(value - rounded) > 1e-5) return false;
+        value = rounded;
+        return true;
+    };
+
+    //Edge passing through point, point is on vertical grid line if onX, on horizontal if onY
+    auto edgeAt = [&](double px, double py, bool onX, bool onY)
+    {
+        int ix = (int)floor(px);
+        int iy = (int)floor(py);
+        bool hit = false;
+        if (onX && dx != 0.0)
+        {
+            hit = hit || blocked(ix - 1, iy) != blocked(ix, iy);
+            if (onY) hit = hit || blocked(ix - 1, iy - 1) != blocked(ix, iy - 1);
+        }
+        if (onY && dy != 0.0)
+        {
+            hit = hit || blocked(ix, iy - 1) != blocked(ix, iy);
+            if (onX) hit = hit || blocked(ix - 1, iy - 1) != blocked(ix - 1, iy);
+        }
+        return hit;
+    };
+
+    double px = sx;
+    double py = sy;
+    bool onX = onLine(px);
+    bool onY = onLine(py);
+    if (edgeAt(px, py, onX, onY))
+        return 0.f;
+
+    //Amanatides-Woo walk, every grid line crossing is tested for an edge
+    int x = (int)floor(sx);
+    int y = (int)floor(sy);
+    int stepX = (dx > 0) ? 1 : ((dx < 0) ? -1 : 0);
+    int stepY = (dy > 0) ? 1 : ((dy < 0) ? -1 : 0);
+    double tDeltaX = (dx != 0) ? 1.0 / fabs(dx) : INFINITY;
+    double tDeltaY = (dy != 0) ? 1.0 / fabs(dy) : INFINITY;
+    double tMaxX = (dx > 0) ? ((double)x + 1.0 - sx) / dx : ((dx < 0) ? (sx - (double)x) / -dx : INFINITY);
+    double tMaxY = (dy > 0) ? ((double)y + 1.0 - sy) / dy : ((dy < 0) ? (sy - (double)y) / -dy : INFINITY);
+
+    while (true)
+    {
+        double t = std::min(tMaxX, tMaxY);
+        if (t > 1.0) return INFINITY;
+
+        bool crossX = (tMaxX <= tMaxY);
+        bool crossY = (tMaxY <= tMaxX);
+        px = crossX ? (double)((stepX > 0) ? x + 1 : x) : sx + dx * t;
+        py = crossY ? (double)((stepY > 0) ? y + 1 : y) : sy + dy * t;
+        onX = crossX || onLine(px);
+        onY = crossY || onLine(py);
+        if (edgeAt(px, py, onX, onY))
+            return (float)t;
+
+        if (crossX)
+        {
+            x += stepX;
+            tMaxX += tDeltaX;
+        }
+        if (crossY)
+        {
+            y += stepY;
+            tMaxY += tDeltaY;
+        }
+
+        //Left the map and moving away from it
+        if ((x < 0 && stepX <= 0) || (x >= width && stepX >= 0) || (y < 0 && stepY <= 0) || (y >= height && stepY >= 0))
+            return INFINITY;
+    }
+}
+
+bool CollisionHelper::SweepInterval(float min, float max, float move, float tileMin, float tileMax, float& tNear, float& tFar)
+{
+    const float skin = 0.01F;
+    if (move == 0.f)
+    {
+        //Only real overlap blocks, so shapes slide along walls they are flush with
+        if (max <= tileMin + skin || min >= tileMax - skin) return false;
+        tNear = -INFINITY;
+        tFar = INFINITY;
+        return true;
+    }
+
+    float nearGap = (move > 0.f) ? tileMin - max : min - tileMax;
+    float farGap = (move > 0.f) ? tileMax - min : max - tileMin;
+    if (nearGap < 0.f && nearGap > -skin) //Touching, but rounding put it a bit inside
+        nearGap = 0.f;
+
+    tNear = nearGap / fabs(move);
+    tFar = farGap / fabs(move);
+    return true;
+}
+
+sf::IntRect CollisionHelper::GetSweptTiles(const sf::FloatRect& bounds, const sf::Vector2f& move, const MapLayerModel<bool>* tiles)
+{
+    float left = std::min(bounds.left, bounds.left + move.x) - tiles->offsetX;
+    float top = std::min(bounds.top, bounds.top + move.y) - tiles->offsetY;
+    float right = std::max(bounds.left, bounds.left + move.x) + bounds.width - tiles->offsetX;
+    float bottom = std::max(bounds.top, bounds.top + move.y) + bounds.height - tiles->offsetY;
+
+    int x1 = std::max((int)floor(left / (float)tiles->tileWidth), 0);
+    int y1 = std::max((int)floor(top / (float)tiles->tileHeight), 0);
+    int x2 = std::min((int)floor(right / (float)tiles->tileWidth), (int)tiles->width - 1);
+    int y2 = std::min((int)floor(bottom / (float)tiles->tileHeight), (int)tiles->height - 1);
+    return sf::IntRect(x1, y1, x2 - x1 + 1, y2 - y1 + 1);
+}
+
+CollisionHelper::SweepHit CollisionHelper::SweepRect(const sf::FloatRect& rect, const sf::Vector2f& move, const MapLayerModel<bool>* tiles)
+{
+    SweepHit hit;
+    if ((move.x == 0.f && move.y == 0.f) || tiles->tileWidth == 0 || tiles->tileHeight == 0) return hit;
+
+    auto area = GetSweptTiles(rect, move, tiles);
+    for (int y = area.top; y < area.top + area.height; y++)
+        for (int x = area.left; x < area.left + area.width; x++)
+        {
+            if (tiles->data[(size_t)y * tiles->width + x] == false) continue;
+
+            float tileLeft = (float)x * (float)tiles->tileWidth + tiles->offsetX;
+            float tileTop = (float)y * (float)tiles->tileHeight + tiles->offsetY;
+
+            float nearX, farX, nearY, farY;
+            if (SweepInterval(rect.left, rect.left + rect.width, move.x, tileLeft, tileLeft + (float)tiles->tileWidth, nearX, farX) == false) continue;
+            if (SweepInterval(rect.top, rect.top + rect.height, move.y, tileTop, tileTop + (float)tiles->tileHeight, nearY, farY) == false) continue;
+
+            //Negative enter means it overlaps at start
+            float enter = std::max(nearX, nearY);
+            float exit = std::min(farX, farY);
+            if (enter >= exit || enter < 0.f || enter > hit.time) continue;
+            if (enter == hit.time && (hit.normal.x != 0.f || hit.normal.y != 0.f)) continue;
+
+            hit.time = enter;
+            if (nearX >= nearY)
+                hit.normal = sf::Vector2f((move.x > 0.f) ? -1.f : 1.f, 0.f);
+            else
+                hit.normal = sf::Vector2f(0.f, (move.y > 0.f) ? -1.f : 1.f);
+        }
+    return hit;
+}
+
+CollisionHelper::SweepHit CollisionHelper::SweepCircle(const sf::Vector2f& center, float radius, const sf::Vector2f& move, const MapLayerModel<bool>* tiles)
+{
+    SweepHit hit;
+    if ((move.x == 0.f && move.y == 0.f) || tiles->tileWidth == 0 || tiles->tileHeight == 0) return hit;
+
+    const float skin = 0.01F;
+    auto area = GetSweptTiles(sf::FloatRect(center.x - radius, center.y - radius, radius * 2.f, radius * 2.f), move, tiles);
+    for (int y = area.top; y < area.top + area.height; y++)
+        for (int x = area.left; x < area.left + area.width; x++)
+        {
+            if (tiles->data[(size_t)y * tiles->width + x] == false) continue;
+
+            float left = (float)x * (float)tiles->tileWidth + tiles->offsetX;
+            float top = (float)y * (float)tiles->tileHeight + tiles->offsetY;
+            float right = left + (float)tiles->tileWidth;
+            float bottom = top + (float)tiles->tileHeight;
+
+            //Center against tile grown by radius first
+            float nearX, farX, nearY, farY;
+            if (SweepInterval(center.x, center.x, move.x, left - radius, right + radius, nearX, farX) == false) continue;
+            if (SweepInterval(center.y, center.y, move.y, top - radius, bottom + radius, nearY, farY) == false) continue;
+
+            float enter = std::max(nearX, nearY);
+            float exit = std::min(farX, farY);
+            if (enter >= exit || enter > hit.time) continue;
+
+            auto contact = center + move * std::max(enter, 0.f);
+            bool alongY = (contact.y >= top && contact.y <= bottom);
+            bool alongX = (contact.x >= left && contact.x <= right);
+            float time = enter;
+            sf::Vector2f normal;
+            if (alongX || alongY)
+            {
+                if (enter < 0.f) continue; //Overlaps side at start
+                if (nearX >= nearY)
+                    normal = sf::Vector2f((move.x > 0.f) ? -1.f : 1.f, 0.f);
+                else
+                    normal = sf::Vector2f(0.f, (move.y > 0.f) ? -1.f : 1.f);
+            }
+            else
+            {
+                //Rounded corner of grown tile, ray that misses it misses whole tile
+                sf::Vector2f corner((contact.x < left) ? left : right, (contact.y < top) ? top : bottom);
+                auto diff = center - corner;
+                float a = move.x * move.x + move.y * move.y;
+                float b = diff.x * move.x + diff.y * move.y;
+                float c = diff.x * diff.x + diff.y * diff.y - radius * radius;
+                if (c < -2.f * radius * skin) continue; //Overlaps corner at start
+
+                if (c <= 0.f)
+                {
+                    if (b >= 0.f) continue; //Touching, but moving away
+                    time = 0.f;
+                }
+                else
+                {
+                    float discriminant = b * b - a * c;
+                    if (discriminant < 0.f) continue;
+                    time = (-b - sqrt(discriminant)) / a;
+                    if (time < 0.f) continue;
+                }
+                if (time > hit.time) continue;
+
+                normal = center + move * time - corner;
+                float length = sqrt(normal.x * normal.x + normal.y * normal.y);
+                if (length == 0.f) continue;
+                normal /= length;
+            }
+
+            if (time == hit.time && (hit.normal.x != 0.f || hit.normal.y != 0.f)) continue;
+            hit.time = time;
+            hit.normal = normal;
+        }
+    return hit;
+}
+
+sf::Vector2f CollisionHelper::SlideRect(const sf::FloatRect& rect, const sf::Vector2f& move, const MapLayerModel<bool>* tiles)
+{
+    auto current = rect;
+    auto left = move;
+    for (int i = 0; i < 3 && (left.x != 0.f || left.y != 0.f); i++)
+    {
+        auto hit = SweepRect(current, left, tiles);
+        current.left += left.x * hit.time;
+        current.top += left.y * hit.time;
+        if (hit.normal.x == 0.f && hit.normal.y == 0.f) break;
+
+        //Rest of move without part going into wall
+        left *= 1.f - hit.time;
+        float into = left.x * hit.normal.x + left.y * hit.normal.y;
+        left -= hit.normal * into;
+    }
+    return sf::Vector2f(current.left, current.top);
+}
+
+sf::Vector2f CollisionHelper::SlideCircle(const sf::Vector2f& center, float radius, const sf::Vector2f& move, const MapLayerModel<bool>* tiles)
+{
+    auto current = center;
+    auto left = move;
+    for (int i = 0; i < 3 && (left.x != 0.f || left.y != 0.f); i++)
+    {
+        auto hit = SweepCircle(current, radius, left, tiles);
+        current += left * hit.time;
+        if (hit.normal.x == 0.f && hit.normal.y == 0.f) break;
+
+        //Rest of move without part going into wall
+        left *= 1.f - hit.time;
+        float into = left.x * hit.normal.x + left.y * hit.normal.y;
+        left -= hit.normal * into;
+    }
+    return current;
+}
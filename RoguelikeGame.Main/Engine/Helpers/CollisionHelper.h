@@ -2,12 +2,24 @@
 
 #include "../Models/MapLayerModel.h"
 #include "../Helpers/MathHelper.h"
+#include "../Utilities/BitGrid.h"
 
 #include "SFML/Graphics/Rect.hpp"
 #include "SFML/Graphics/Glsl.hpp"
 
 class CollisionHelper
 {
+public:
+	//Result of moving shape against blocked tiles, time is part of move (0-1) done before contact
+	struct SweepHit
+	{
+		float time = 1.f;
+		sf::Vector2f normal; //Zero if nothing was hit
+	};
+private:
+	//Times when moving interval starts and stops overlapping tile interval, false if it never does
+	static bool SweepInterval(float min, float max, float move, float tileMin, float tileMax, float& tNear, float& tFar);
+	static sf::IntRect GetSweptTiles(const sf::FloatRect& bounds, const sf::Vector2f& move, const MapLayerModel<bool>* tiles);
 public:
 	static bool CheckSimpleCollision(const sf::FloatRect& first, const sf::FloatRect& second);
 	static bool CheckCircleCollision(const sf::Vector2f& point, const sf::Vector2f& center, float radius, float arc, float angle);
@@ -15,6 +27,9 @@ public:
 	static bool CheckCirclesIntersect(const sf::Vector2f& center1, float radius1, const sf::Vector2f& center2, float radius2);
 	static bool CheckTileCollision(const sf::FloatRect& obj, const MapLayerModel<bool> *tiles);
 	static bool CheckTileCollision(const sf::Vector2f& center, float radius, const MapLayerModel<bool>* tiles);
+	//Same as above, but blocked tiles are read from packed grid (tiles give only size and offset)
+	static bool CheckTileCollision(const sf::FloatRect& obj, const MapLayerModel<bool>* tiles, const BitGrid* blocked);
+	static bool CheckTileCollision(const sf::Vector2f& center, float radius, const MapLayerModel<bool>* tiles, const BitGrid* blocked);
 	static bool CheckRectContains(const sf::IntRect& outer, const sf::IntRect& inner);
 	static bool CheckRectContains(const sf::FloatRect& outer, const sf::FloatRect& inner);
 
@@ -24,4 +39,17 @@ public:
 	static sf::Glsl::Ivec4 GetPosOnTiles(const sf::FloatRect& pos, const MapLayerModel<bool>* tiles);
 	static sf::Vector2i GetPosOnTiles(const sf::Vector2f& pos, const MapLayerModel<bool>* tiles);
 	static std::vector<sf::Vector2f> GetRectPoints(const sf::FloatRect& rect);
+
+	//Tiles overlapped at start are ignored, so shapes can leave them
+	static SweepHit SweepRect(const sf::FloatRect& rect, const sf::Vector2f& move, const MapLayerModel<bool>* tiles);
+	static SweepHit SweepCircle(const sf::Vector2f& center, float radius, const sf::Vector2f& move, const MapLayerModel<bool>* tiles);
+	//Moves until contact and slides rest of move along walls, returns new rect position or circle center
+	static sf::Vector2f SlideRect(const sf::FloatRect& rect, const sf::Vector2f& move, const MapLayerModel<bool>* tiles);
+	static sf::Vector2f SlideCircle(const sf::Vector2f& center, float radius, const sf::Vector2f& move, const MapLayerModel<bool>* tiles);
+
+	//Distance along segment where it first touches blocked tile grown by margin (|margin| < tile size), INFINITY if never
+	static float GetSegmentTileEntry(const sf::Vector2f& startPos, const sf::Vector2f& endPos, float margin, const MapLayerModel<bool>* tiles);
+	//Part of segment (0-1) where it first crosses edge between blocked and free tiles, INFINITY if never
+	//Tiles outside map are free and edges parallel to segment are ignored, same as line tests against map edges
+	static float GetSegmentEdgeHit(const sf::Vector2f& startPos, const sf::Vector2f& endPos, const MapLayerModel<bool>* tiles);
 };
@@ -8,6 +8,11 @@ void DebugHelper::Reset()
 	_tickCounter = 0;
 	_measureTime = std::chrono::steady_clock::now();
 	_fpsTime = std::chrono::steady_clock::now();
+	for (auto& timing : _timings)
+	{
+		timing.total = std::chrono::microseconds(0);
+		timing.samples = 0;
+	}
 }
 
 DebugHelper::DebugHelper()
@@ -40,11 +45,34 @@ void DebugHelper::Status(bool tick)
 		std::stringstream ss;
 		ss << std::fixed << std::setprecision(2) << "FPS: avg(" << avgFPS << ")  min(" << _minFPS <<  ")  max(" << _maxFPS << ")  TPS: " << avgTPS;
 		_logger->Log(Logger::LogType::DEBUG, ss.str());
+
+		if (_timings.size() > 0)
+		{
+			std::stringstream times;
+			times << "Avg times:";
+			for (auto& timing : _timings)
+				times << "  " << timing.name << "(" << ((timing.samples > 0) ? timing.total.count() / timing.samples : 0) << "us)";
+			_logger->Log(Logger::LogType::DEBUG, times.str());
+		}
 		Reset();
 	}
 	_fpsTime = now;
 }
 
+void DebugHelper::AddTiming(const std::string& name, const std::chrono::microseconds& duration)
+{
+	if (_debug == false) return;
+
+	auto found = std::find_if(_timings.begin(), _timings.end(), [&name](const Timing& timing) { return timing.name == name; });
+	if (found == _timings.end())
+	{
+		_timings.push_back({ name, duration, 1 });
+		return;
+	}
+	found->total += duration;
+	found->samples++;
+}
+
 void DebugHelper::SetMeasureEvery(const std::chrono::milliseconds& milis)
 {
 	_measureEvery = milis;
@@ -3,12 +3,22 @@
 #include <chrono>
 #include <sstream>
 #include <iomanip>
+#include <vector>
+#include <algorithm>
 
 #include "../Core/Logger.h"
 
 class DebugHelper
 {
 private:
+	//Summed since last log, averaged when logged
+	struct Timing
+	{
+		std::string name;
+		std::chrono::microseconds total;
+		unsigned int samples;
+	};
+
 	bool _debug;
 
 	unsigned short _minFPS;
@@ -19,6 +29,7 @@ private:
 	std::chrono::steady_clock::time_point _measureTime;
 	std::chrono::steady_clock::time_point _fpsTime;
 	std::chrono::milliseconds _measureEvery;
+	std::vector<Timing> _timings; //Order of first add
 
 	void Reset();
 
@@ -28,6 +39,8 @@ public:
 	~DebugHelper() = default;
 
 	void Status(bool tick);
+	//Logged with FPS, only while debug is on
+	void AddTiming(const std::string& name, const std::chrono::microseconds& duration);
 
 	void SetMeasureEvery(const std::chrono::milliseconds& milis);
 	void SetDebug(bool debug);
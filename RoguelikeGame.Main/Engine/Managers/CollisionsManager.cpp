@@ -4,16 +4,19 @@ CollisionsManager::CollisionsManager()
 {
 	_logger = Logger::GetInstance();
 	_maps.clear();
+	_mapsBits.clear();
 	_edges.clear();
 	_edgesLines.resize(0);
 	_edgesLines.setPrimitiveType(sf::PrimitiveType::Lines);
 	_linesColor = sf::Color::White;
 	_showCollisionLines = false;
+	_version = 0;
 }
 
 void CollisionsManager::GenerateCommonMap()
 {
 	if (_maps.size() <= 0) return;
+	_version++;
 
 	_sumMap.offsetX = _maps[0].offsetX;
 	_sumMap.offsetY = _maps[0].offsetY;
@@ -29,185 +32,279 @@ void CollisionsManager::GenerateCommonMap()
 	_sumMap.height = std::max_element(_maps.begin(), _maps.end(), compareMapHeight)->height;
 	_sumMap.width = std::max_element(_maps.begin(), _maps.end(), compareMapWidth)->width;
 
-	_sumMap.data.resize((size_t)_sumMap.height * (size_t)_sumMap.width, false);
-	for (auto it = _maps.begin(); it != _maps.end(); it++)
-		for (size_t i = 0; i < it->data.size(); i++)
-			if (it->data[i])
-				_sumMap.data[(i / it->width) * _sumMap.width + (i % it->width)] = true;
+	//Maps are merged a word at a time
+	_sumBits.Resize(_sumMap.width, _sumMap.height);
+	for (auto& bits : _mapsBits)
+		_sumBits.Merge(bits);
+	_sumBits.CopyTo(_sumMap.data);
+
+	_distanceField.Build(&_sumBits, &_sumMap);
 }
 
-void CollisionsManager::CovertTilesIntoEdges()
+void CollisionsManager::UpdateCommonTiles(const sf::IntRect& tiles)
 {
-	_edges.clear();
+	int left = std::max(tiles.left, 0);
+	int top = std::max(tiles.top, 0);
+	int right = std::min(tiles.left + tiles.width, (int)_sumMap.width) - 1;
+	int bottom = std::min(tiles.top + tiles.height, (int)_sumMap.height) - 1;
+	if (left > right || top > bottom) return;
+
+	for (int y = top; y <= bottom; y++)
+		for (int x = left; x <= right; x++)
+		{
+			bool blocked = false;
+			for (auto& bits : _mapsBits)
+				blocked = blocked || bits.Get(x, y);
 
-	struct Cell
-	{
-		std::array<size_t, 4> edge_id = { 0,0,0,0 };
-		std::array<bool, 4> edge_exist = { false,false,false,false };
-		bool exist = false;
-	};
-	std::vector<Cell> grid((size_t)_sumMap.width * (size_t)_sumMap.height);
+			_sumMap.data[(size_t)y * _sumMap.width + x] = blocked;
+			_sumBits.Set(x, y, blocked);
+		}
 
-	for (size_t i = 0; i < grid.size(); i++)
+	auto changed = sf::IntRect(left, top, right - left + 1, bottom - top + 1);
+	_distanceField.UpdateTiles(changed);
+	UpdateEdges(changed); //Changes version too
+}
+
+void CollisionsManager::AppendHorizontalEdges(unsigned int line, unsigned int firstTile, unsigned int lastTile, std::array<std::vector<EdgeGrid::Edge>, 4>& output) const
+{
+	float posY = (float)(line * _sumMap.tileHeight) + _sumMap.offsetY;
+	std::array<bool, 2> open = { false, false };
+	for (unsigned int x = firstTile; x <= lastTile; x++)
 	{
-		grid[i].exist = _sumMap.data[i];
-		for (int j = 0; j < 4; j++)
+		bool above = (line > 0 && _sumMap.data[(size_t)(line - 1) * _sumMap.width + x]);
+		bool below = (line < _sumMap.height && _sumMap.data[(size_t)line * _sumMap.width + x]);
+		std::array<bool, 2> faces = { below && !above, above && !below }; //North side of tile below, south side of tile above
+
+		float posX = (float)(x * _sumMap.tileWidth) + _sumMap.offsetX;
+		for (size_t f = 0; f < 2; f++)
 		{
-			grid[i].edge_exist[j] = false;
-			grid[i].edge_id[j] = 0;
+			auto& edges = output[EDGE_NORTH + f];
+			if (faces[f] == false)
+				open[f] = false;
+			else if (open[f]) //Grow eastwards
+				std::get<1>(edges.back()).x += (float)_sumMap.tileWidth;
+			else
+			{
+				edges.emplace_back(sf::Vector2f(posX, posY), sf::Vector2f(posX + (float)_sumMap.tileWidth, posY));
+				open[f] = true;
+			}
 		}
 	}
+}
 
-	// Iterate through region from top left to bottom right
-	for (unsigned int x = 0; x < _sumMap.width; x++)
+void CollisionsManager::AppendVerticalEdges(unsigned int line, unsigned int firstTile, unsigned int lastTile, std::array<std::vector<EdgeGrid::Edge>, 4>& output) const
+{
+	float posX = (float)(line * _sumMap.tileWidth) + _sumMap.offsetX;
+	std::array<bool, 2> open = { false, false };
+	for (unsigned int y = firstTile; y <= lastTile; y++)
 	{
-		for (unsigned int y = 0; y < _sumMap.height; y++)
+		bool left = (line > 0 && _sumMap.data[(size_t)y * _sumMap.width + line - 1]);
+		bool right = (line < _sumMap.width && _sumMap.data[(size_t)y * _sumMap.width + line]);
+		std::array<bool, 2> faces = { right && !left, left && !right }; //West side of tile on right, east side of tile on left
+
+		float posY = (float)(y * _sumMap.tileHeight) + _sumMap.offsetY;
+		for (size_t f = 0; f < 2; f++)
 		{
-			// Create some convenient indices
-			unsigned int i = y * _sumMap.width + x;			// This
-			unsigned int n = (y - 1) * _sumMap.width + x;	// Northern Neighbour
-			unsigned int s = (y + 1) * _sumMap.width + x;	// Southern Neighbour
-			unsigned int w = y * _sumMap.width + (x - 1);	// Western Neighbour
-			unsigned int e = y * _sumMap.width + (x + 1);	// Eastern Neighbour
-
-			// If this cell exists, check if it needs edges
-			if (grid[i].exist)
+			auto& edges = output[EDGE_WEST + f];
+			if (faces[f] == false)
+				open[f] = false;
+			else if (open[f]) //Grow downwards
+				std::get<1>(edges.back()).y += (float)_sumMap.tileHeight;
+			else
 			{
-				if (x == 0 || !grid[w].exist) //Western neighbour or map end
-				{
-					if (y == 0 || grid[n].edge_exist[0] == false)
-					{
-						// Northern neighbour does not have one, so create one
-						std::tuple<sf::Vector2f, sf::Vector2f> edge;
-
-						float posX = (float)(x * _sumMap.tileWidth) + _sumMap.offsetX;
-						float posY = (float)(y * _sumMap.tileHeight) + _sumMap.offsetY;
-
-						std::get<0>(edge) = sf::Vector2f(posX, posY); //Start pos
-						std::get<1>(edge) = sf::Vector2f(posX, posY + (float)_sumMap.tileHeight); //End pos
-
-						// Add edge to pool
-						size_t edge_id = _edges.size();
-						_edges.push_back(edge);
-
-						// Update tile information with edge information
-						grid[i].edge_id[0] = edge_id;
-						grid[i].edge_exist[0] = true;
-					}
-					else
-					{
-						// Northern neighbour has a western edge, so grow it downwards
-						std::get<1>(_edges[grid[n].edge_id[0]]).y += (float)_sumMap.tileHeight;
-						grid[i].edge_id[0] = grid[n].edge_id[0];
-						grid[i].edge_exist[0] = true;
-					}
-				}
-
-				if (x == _sumMap.width - 1 || !grid[e].exist) //Eastern neignbour or map end
-				{
-					if (y == 0 || !grid[n].edge_exist[1])
-					{
-						// Northern neighbour does not have one, so create one
-						std::tuple<sf::Vector2f, sf::Vector2f> edge;
+				edges.emplace_back(sf::Vector2f(posX, posY), sf::Vector2f(posX, posY + (float)_sumMap.tileHeight));
+				open[f] = true;
+			}
+		}
+	}
+}
 
-						float posX = (float)((x + 1) * _sumMap.tileWidth) + _sumMap.offsetX;
-						float posY = (float)(y * _sumMap.tileHeight) + _sumMap.offsetY;
+void CollisionsManager::RebuildEdgesData()
+{
+	//Bucket grid for edges queries
+	sf::FloatRect bounds((float)_sumMap.offsetX, (float)_sumMap.offsetY, (float)(_sumMap.width * _sumMap.tileWidth), (float)(_sumMap.height * _sumMap.tileHeight));
+	sf::Vector2f bucketSize((float)(EDGES_BUCKET_TILES * _sumMap.tileWidth), (float)(EDGES_BUCKET_TILES * _sumMap.tileHeight));
+	_edgesGrid.Build(_edges, bounds, bucketSize);
 
-						std::get<0>(edge) = sf::Vector2f(posX, posY); //Start pos
-						std::get<1>(edge) = sf::Vector2f(posX, posY + (float)_sumMap.tileHeight); //End pos
+	//Pass points to VertexArray
+	_edgesLines.clear();
+	_edgesLines.setPrimitiveType(sf::PrimitiveType::Lines);
+	_edgesLines.resize(_edges.size() * 2);
+	for (size_t i = 0; i < _edges.size(); i++)
+	{
+		_edgesLines[(i * 2) + 0].position = std::get<0>(_edges[i]);
+		_edgesLines[(i * 2) + 1].position = std::get<1>(_edges[i]);
 
-						// Add edge to Polygon Pool
-						size_t edge_id = _edges.size();
-						_edges.push_back(edge);
+		_edgesLines[(i * 2) + 0].color = _linesColor;
+		_edgesLines[(i * 2) + 1].color = _linesColor;
+	}
+}
 
-						// Update tile information with edge information
-						grid[i].edge_id[1] = edge_id;
-						grid[i].edge_exist[1] = true;
-					}
-					else
-					{
-						// Northern neighbour has one, so grow it downwards
-						std::get<1>(_edges[grid[n].edge_id[1]]).y += (float)_sumMap.tileHeight;
-						grid[i].edge_id[1] = grid[n].edge_id[1];
-						grid[i].edge_exist[1] = true;
-					}
-				}
+void CollisionsManager::CovertTilesIntoEdges()
+{
+	_version++;
+	_edges.clear();
 
-				if (y == 0 || !grid[n].exist) //Northern neignbour or map end
+	if (_sumMap.width > 0 && _sumMap.height > 0)
+	{
+		//Map is split into row bands, every band on its own thread
+		unsigned int bandsCount = std::max(std::min(std::thread::hardware_concurrency(), _sumMap.height / EDGES_BAND_ROWS), 1U);
+		std::vector<std::array<std::vector<EdgeGrid::Edge>, 4>> bands(bandsCount);
+		auto generateBand = [&](unsigned int band) {
+			unsigned int firstRow = band * _sumMap.height / bandsCount;
+			unsigned int endRow = (band + 1) * _sumMap.height / bandsCount;
+			unsigned int endLine = (band == bandsCount - 1) ? endRow + 1 : endRow; //Bottom map border belongs to last band
+
+			for (unsigned int line = firstRow; line < endLine; line++)
+				AppendHorizontalEdges(line, 0, _sumMap.width - 1, bands[band]);
+			for (unsigned int line = 0; line <= _sumMap.width; line++)
+				AppendVerticalEdges(line, firstRow, endRow - 1, bands[band]);
+		};
+
+		std::vector<std::thread> workers;
+		for (unsigned int band = 1; band < bandsCount; band++)
+			workers.emplace_back(generateBand, band);
+		generateBand(0);
+		for (auto& worker : workers)
+			worker.join();
+
+		//Vertical edges cut by band borders are joined back
+		for (auto type : { EDGE_WEST, EDGE_EAST })
+		{
+			std::vector<EdgeGrid::Edge> joined;
+			std::vector<size_t> touched; //Added or grown by previous band
+			for (unsigned int band = 0; band < bandsCount; band++)
+			{
+				float borderY = (float)((band * _sumMap.height / bandsCount) * _sumMap.tileHeight) + _sumMap.offsetY;
+				std::unordered_map<float, size_t> open; //Edges ending at border by x
+				for (auto id : touched)
+					if (std::get<1>(joined[id]).y == borderY)
+						open[std::get<1>(joined[id]).x] = id;
+
+				touched.clear();
+				for (auto& edge : bands[band][type])
 				{
-					if (x == 0 || !grid[w].edge_exist[2])
+					auto found = (std::get<0>(edge).y == borderY) ? open.find(std::get<0>(edge).x) : open.end();
+					if (found != open.end())
 					{
-						// Western neighbour does not have one, so create one
-						std::tuple<sf::Vector2f, sf::Vector2f> edge;
-
-						float posX = (float)(x * _sumMap.tileWidth) + _sumMap.offsetX;
-						float posY = (float)(y * _sumMap.tileHeight) + _sumMap.offsetY;
-
-						std::get<0>(edge) = sf::Vector2f(posX, posY); //Start pos
-						std::get<1>(edge) = sf::Vector2f(posX + (float)_sumMap.tileWidth, posY); //End pos
-
-						// Add edge to Polygon Pool
-						size_t edge_id = _edges.size();
-						_edges.push_back(edge);
-
-						// Update tile information with edge information
-						grid[i].edge_id[2] = edge_id;
-						grid[i].edge_exist[2] = true;
+						std::get<1>(joined[found->second]).y = std::get<1>(edge).y;
+						touched.push_back(found->second);
 					}
 					else
 					{
-						// Western neighbour has one, so grow it eastwards
-						std::get<1>(_edges[grid[w].edge_id[2]]).x += (float)_sumMap.tileWidth;
-						grid[i].edge_id[2] = grid[w].edge_id[2];
-						grid[i].edge_exist[2] = true;
+						touched.push_back(joined.size());
+						joined.push_back(edge);
 					}
 				}
+			}
+			bands[0][type].swap(joined);
+			for (unsigned int band = 1; band < bandsCount; band++)
+				bands[band][type].clear();
+		}
 
-				if (y == _sumMap.height - 1 || !grid[s].exist) //Southern neignbour or map end
-				{
-					if (x == 0 || !grid[w].edge_exist[3])
-					{
-						// Western neighbour does not have one, so I need to create one
-						std::tuple<sf::Vector2f, sf::Vector2f> edge;
+		for (auto& band : bands)
+			for (auto& edges : band)
+				_edges.insert(_edges.end(), edges.begin(), edges.end());
+	}
 
-						float posX = (float)(x * _sumMap.tileWidth) + _sumMap.offsetX;
-						float posY = (float)((y + 1) * _sumMap.tileHeight) + _sumMap.offsetY;
+	RebuildEdgesData();
+}
 
-						std::get<0>(edge) = sf::Vector2f(posX, posY); //Start pos
-						std::get<1>(edge) = sf::Vector2f(posX + (float)_sumMap.tileWidth, posY); //End pos
+void CollisionsManager::UpdateEdges(const sf::IntRect& tiles)
+{
+	if (_edgesGrid.IsBuilt() == false)
+	{
+		CovertTilesIntoEdges();
+		return;
+	}
 
-						// Add edge to Polygon Pool
-						size_t edge_id = _edges.size();
-						_edges.push_back(edge);
+	//Sides of neighbour tiles change too
+	int left = std::max(tiles.left - 1, 0);
+	int top = std::max(tiles.top - 1, 0);
+	int right = std::min(tiles.left + tiles.width, (int)_sumMap.width - 1);
+	int bottom = std::min(tiles.top + tiles.height, (int)_sumMap.height - 1);
+	if (left > right || top > bottom) return;
+	_version++;
+
+	//Every edge touching area is removed, parts of them outside area are generated again
+	auto tileW = (float)_sumMap.tileWidth;
+	auto tileH = (float)_sumMap.tileHeight;
+	sf::FloatRect area((float)left * tileW + _sumMap.offsetX - 0.5f, (float)top * tileH + _sumMap.offsetY - 0.5f,
+		(float)(right - left + 1) * tileW + 1.f, (float)(bottom - top + 1) * tileH + 1.f);
+	std::vector<size_t> removed;
+	_edgesGrid.GetEdgesInRect(area, removed);
+
+	//Tiles range to generate on every line crossing area
+	std::vector<std::pair<int, int>> rowsRange((size_t)(bottom - top + 2), std::make_pair(left, right));
+	std::vector<std::pair<int, int>> columnsRange((size_t)(right - left + 2), std::make_pair(top, bottom));
+	for (auto id : removed)
+	{
+		auto& start = std::get<0>(_edges[id]);
+		auto& end = std::get<1>(_edges[id]);
+		if (start.y == end.y)
+		{
+			auto& range = rowsRange[(size_t)((int)round((start.y - _sumMap.offsetY) / tileH) - top)];
+			range.first = std::min(range.first, (int)round((start.x - _sumMap.offsetX) / tileW));
+			range.second = std::max(range.second, (int)round((end.x - _sumMap.offsetX) / tileW) - 1);
+		}
+		else
+		{
+			auto& range = columnsRange[(size_t)((int)round((start.x - _sumMap.offsetX) / tileW) - left)];
+			range.first = std::min(range.first, (int)round((start.y - _sumMap.offsetY) / tileH));
+			range.second = std::max(range.second, (int)round((end.y - _sumMap.offsetY) / tileH) - 1);
+		}
+	}
 
-						// Update tile information with edge information
-						grid[i].edge_id[3] = edge_id;
-						grid[i].edge_exist[3] = true;
-					}
-					else
-					{
-						// Western neighbour has one, so grow it eastwards
-						std::get<1>(_edges[grid[w].edge_id[3]]).x += (float)_sumMap.tileWidth;
-						grid[i].edge_id[3] = grid[w].edge_id[3];
-						grid[i].edge_exist[3] = true;
-					}
-				}
-			}
+	std::array<std::vector<EdgeGrid::Edge>, 4> generated;
+	for (size_t i = 0; i < rowsRange.size(); i++)
+		AppendHorizontalEdges((unsigned int)(top + (int)i), (unsigned int)rowsRange[i].first, (unsigned int)rowsRange[i].second, generated);
+	for (size_t i = 0; i < columnsRange.size(); i++)
+		AppendVerticalEdges((unsigned int)(left + (int)i), (unsigned int)columnsRange[i].first, (unsigned int)columnsRange[i].second, generated);
+
+	//New edges take places of removed ones, free places are filled from the end, so most indexes stay the same
+	std::vector<size_t> changed;
+	size_t reused = 0;
+	for (auto& edges : generated)
+		for (auto& edge : edges)
+		{
+			size_t id = (reused < removed.size()) ? removed[reused++] : _edges.size();
+			if (id == _edges.size())
+				_edges.push_back(edge);
+			else
+				_edges[id] = edge;
+			changed.push_back(id);
 		}
+	for (size_t i = removed.size(); i > reused; i--)
+	{
+		size_t last = _edges.size() - 1;
+		if (removed[i - 1] != last)
+		{
+			_edges[removed[i - 1]] = _edges[last];
+			changed.push_back(removed[i - 1]);
+		}
+		changed.push_back(last);
+		_edges.pop_back();
 	}
+	std::sort(changed.begin(), changed.end());
+	changed.erase(std::unique(changed.begin(), changed.end()), changed.end());
+
+	_edgesGrid.Update(_edges, changed);
 
-	//Pass points to VertexArray
-	_edgesLines.clear();
-	_edgesLines.setPrimitiveType(sf::PrimitiveType::Lines);
 	_edgesLines.resize(_edges.size() * 2);
-	for (size_t i = 0; i < _edges.size(); i++)
-	{
-		_edgesLines[(i * 2) + 0].position = std::get<0>(_edges[i]);
-		_edgesLines[(i * 2) + 1].position = std::get<1>(_edges[i]);
+	for (auto id : changed)
+		if (id < _edges.size())
+		{
+			_edgesLines[(id * 2) + 0].position = std::get<0>(_edges[id]);
+			_edgesLines[(id * 2) + 1].position = std::get<1>(_edges[id]);
 
-		_edgesLines[(i * 2) + 0].color = _linesColor;
-		_edgesLines[(i * 2) + 1].color = _linesColor;
-	}
+			_edgesLines[(id * 2) + 0].color = _linesColor;
+			_edgesLines[(id * 2) + 1].color = _linesColor;
+		}
+}
+
+const BitGrid* CollisionsManager::GetCommonBits() const
+{
+	return &_sumBits;
 }
 
 const std::vector<std::tuple<sf::Vector2f, sf::Vector2f>>* CollisionsManager::GetEdges() const
@@ -215,6 +312,16 @@ const std::vector<std::tuple<sf::Vector2f, sf::Vector2f>>* CollisionsManager::Ge
 	return &_edges;
 }
 
+const EdgeGrid* CollisionsManager::GetEdgesGrid() const
+{
+	return &_edgesGrid;
+}
+
+uint64_t CollisionsManager::GetVersion() const
+{
+	return _version;
+}
+
 void CollisionsManager::SetCollisionLinesColor(const sf::Color& color)
 {
 	_linesColor = color;
@@ -246,53 +353,209 @@ bool CollisionsManager::GetCollisionLinesVisibility() const
 
 bool CollisionsManager::CheckTileCollision(const sf::FloatRect& rect) const
 {
-	return CollisionHelper::CheckTileCollision(rect, &_sumMap);
+	return CollisionHelper::CheckTileCollision(rect, &_sumMap, &_sumBits);
 }
 
 bool CollisionsManager::CheckCircleCollision(const sf::Vector2f& center, float radius) const
 {
-	return CollisionHelper::CheckTileCollision(center, radius, &_sumMap);
+	return CollisionHelper::CheckTileCollision(center, radius, &_sumMap, &_sumBits);
 }
 
 sf::Vector2f CollisionsManager::GetCircleLimitPosition(const sf::Vector2f& startPos, const sf::Vector2f& endPos, float radius) const
 {
+	//Walls are further than radius (and tile precision), nothing can push circle back
+	if (_distanceField.GetClearance(endPos) > radius + 0.1f)
+		return endPos;
+
 	return CollisionHelper::GetTileLimitPosition(startPos, endPos, radius, &_sumMap);
 }
 
+float CollisionsManager::DistanceToWall(const sf::Vector2f& pos) const
+{
+	return _distanceField.DistanceToWall(pos);
+}
+
+sf::Vector2f CollisionsManager::GradientAwayFromWall(const sf::Vector2f& pos) const
+{
+	return _distanceField.GradientAwayFromWall(pos);
+}
+
 sf::Vector2f CollisionsManager::GetLimitPosition(const sf::FloatRect& startPos, const sf::FloatRect& endPos) const
 {
 	return CollisionHelper::GetTileLimitPosition(startPos, endPos, &_sumMap);
 }
 
+sf::Vector2f CollisionsManager::GetSweptLimitPosition(const sf::FloatRect& startPos, const sf::FloatRect& endPos) const
+{
+	return CollisionHelper::SlideRect(startPos, sf::Vector2f(endPos.left - startPos.left, endPos.top - startPos.top), &_sumMap);
+}
+
+sf::Vector2f CollisionsManager::GetSweptCircleLimitPosition(const sf::Vector2f& startPos, const sf::Vector2f& endPos, float radius) const
+{
+	auto slided = CollisionHelper::SlideCircle(startPos, radius, endPos - startPos, &_sumMap);
+
+	//Sweep ignores walls it starts in, old resolve still pushes circle out of them
+	return GetCircleLimitPosition(startPos, slided, radius);
+}
+
+CollisionHelper::SweepHit CollisionsManager::SweepRect(const sf::FloatRect& rect, const sf::Vector2f& move) const
+{
+	return CollisionHelper::SweepRect(rect, move, &_sumMap);
+}
+
+CollisionHelper::SweepHit CollisionsManager::SweepCircle(const sf::Vector2f& center, float radius, const sf::Vector2f& move) const
+{
+	return CollisionHelper::SweepCircle(center, radius, move, &_sumMap);
+}
+
 sf::Vector2f CollisionsManager::GetRayHitpoint(const sf::Vector2f& center, float angle, float raycastRange) const
+{
+	return GetRayHitpoint(_sumMap, _edgesGrid, center, angle, raycastRange);
+}
+
+bool CollisionsManager::RaycastHitsPoint(const sf::Vector2f& startPos, const sf::Vector2f& endPos, float* distanceToHitpoint) const
+{
+	return RaycastHitsPoint(_sumMap, _edgesGrid, startPos, endPos, distanceToHitpoint);
+}
+
+bool CollisionsManager::TileRaycastHitsPoint(const sf::Vector2f& startPos, const sf::Vector2f& endPos, float* distanceToHitpoint) const
+{
+	return TileRaycastHitsPoint(_sumMap, _edgesGrid, startPos, endPos, distanceToHitpoint);
+}
+
+sf::Vector2f CollisionsManager::GetRayHitpoint(const MapLayerModel<bool>& tiles, const EdgeGrid& edgesGrid, const sf::Vector2f& center, float angle, float raycastRange)
 {
 	auto endPoint = MathHelper::GetPointFromAngle(center, angle, raycastRange);
 
-	sf::Vector2f closest = endPoint;
-	float currDst = raycastRange;
-	for (auto& l : _edges)
-	{
-		auto hitpoint = MathHelper::GetLinesIntersection(center, endPoint, std::get<0>(l), std::get<1>(l));
-		auto distance = MathHelper::GetDistanceBetweenPoints(center, hitpoint);
-		if (distance < currDst)
-		{
-			currDst = distance;
-			closest = hitpoint;
-		}
-	}
-	return closest;
+	//Edges near the ray when they are built, otherwise walk tiles under it
+	auto hit = (edgesGrid.IsBuilt()) ? edgesGrid.GetSegmentHit(center, endPoint) : CollisionHelper::GetSegmentEdgeHit(center, endPoint, &tiles);
+	if (hit == INFINITY || hit >= 1.f)
+		return endPoint;
+	return center + (endPoint - center) * hit;
 }
 
-bool CollisionsManager::RaycastHitsPoint(const sf::Vector2f& startPos, const sf::Vector2f& endPos, float* distanceToHitpoint) const
+bool CollisionsManager::RaycastHitsPoint(const MapLayerModel<bool>& tiles, const EdgeGrid& edgesGrid, const sf::Vector2f& startPos, const sf::Vector2f& endPos, float* distanceToHitpoint)
 {
 	float precision = 0.05F;
 	auto angle = MathHelper::GetAngleBetweenPoints(startPos, endPos);
 	auto range = MathHelper::GetDistanceBetweenPoints(startPos, endPos);
-	auto hitpoint = GetRayHitpoint(startPos, angle, range);
+	auto hitpoint = GetRayHitpoint(tiles, edgesGrid, startPos, angle, range);
 	*distanceToHitpoint = MathHelper::GetDistanceBetweenPoints(startPos, hitpoint);
 	return (*distanceToHitpoint >= range - precision && *distanceToHitpoint <= range + precision);
 }
 
+bool CollisionsManager::TileRaycastHitsPoint(const MapLayerModel<bool>& tiles, const EdgeGrid& edgesGrid, const sf::Vector2f& startPos, const sf::Vector2f& endPos, float* distanceToHitpoint)
+{
+	//Gives same answer as RaycastHitsPoint (and same distance when point is visible),
+	//edges are tested only when ray passes close to a wall
+	if (edgesGrid.GetEdges()->empty())
+		return RaycastHitsPoint(tiles, edgesGrid, startPos, endPos, distanceToHitpoint);
+
+	float precision = 0.05F;
+	float margin = 0.1F;
+	auto angle = MathHelper::GetAngleBetweenPoints(startPos, endPos);
+	auto range = MathHelper::GetDistanceBetweenPoints(startPos, endPos);
+	auto endPoint = MathHelper::GetPointFromAngle(startPos, angle, range);
+
+	//Ray does not come near any blocked tile, so no edge is hit
+	auto touch = CollisionHelper::GetSegmentTileEntry(startPos, endPoint, margin, &tiles);
+	if (touch == INFINITY)
+	{
+		*distanceToHitpoint = MathHelper::GetDistanceBetweenPoints(startPos, endPoint);
+		return (*distanceToHitpoint >= range - precision && *distanceToHitpoint <= range + precision);
+	}
+
+	//Ray starts in free space and gets deep into a wall, it crossed an edge before that
+	if (touch > 0.f)
+	{
+		auto enter = CollisionHelper::GetSegmentTileEntry(startPos, endPoint, -margin, &tiles);
+		if (enter < range - precision - margin)
+		{
+			*distanceToHitpoint = enter;
+			return false;
+		}
+	}
+
+	return RaycastHitsPoint(tiles, edgesGrid, startPos, endPos, distanceToHitpoint);
+}
+
+void CollisionsManager::GetSegmentsHitpoints(const std::vector<EdgeGrid::Edge>& segments, std::vector<sf::Vector2f>& output) const
+{
+	std::vector<float> hits;
+	if (_edgesGrid.IsBuilt())
+		_edgesGrid.GetSegmentHits(segments, hits);
+	else
+	{
+		hits.resize(segments.size());
+		for (size_t i = 0; i < segments.size(); i++)
+			hits[i] = CollisionHelper::GetSegmentEdgeHit(std::get<0>(segments[i]), std::get<1>(segments[i]), &_sumMap);
+	}
+
+	output.resize(segments.size());
+	for (size_t i = 0; i < segments.size(); i++)
+	{
+		auto& startPos = std::get<0>(segments[i]);
+		auto& endPos = std::get<1>(segments[i]);
+		output[i] = (hits[i] == INFINITY || hits[i] >= 1.f) ? endPos : startPos + (endPos - startPos) * hits[i];
+	}
+}
+
+void CollisionsManager::GetRayHitpoints(const sf::Vector2f& center, const std::vector<float>& angles, float raycastRange, std::vector<sf::Vector2f>& output) const
+{
+	std::vector<EdgeGrid::Edge> segments;
+	segments.reserve(angles.size());
+	for (auto angle : angles)
+		segments.emplace_back(center, MathHelper::GetPointFromAngle(center, angle, raycastRange));
+	GetSegmentsHitpoints(segments, output);
+}
+
+void CollisionsManager::GetRayHitpoints(const std::vector<std::tuple<sf::Vector2f, float, float>>& rays, std::vector<sf::Vector2f>& output) const
+{
+	std::vector<EdgeGrid::Edge> segments;
+	segments.reserve(rays.size());
+	for (auto& ray : rays)
+		segments.emplace_back(std::get<0>(ray), MathHelper::GetPointFromAngle(std::get<0>(ray), std::get<1>(ray), std::get<2>(ray)));
+	GetSegmentsHitpoints(segments, output);
+}
+
+void CollisionsManager::RaycastHitsPoints(const sf::Vector2f& startPos, const std::vector<sf::Vector2f>& endPositions, std::vector<float>& distancesToHitpoint, std::vector<bool>& hits) const
+{
+	float precision = 0.05F;
+	std::vector<float> ranges(endPositions.size());
+	std::vector<EdgeGrid::Edge> segments;
+	segments.reserve(endPositions.size());
+	for (size_t i = 0; i < endPositions.size(); i++)
+	{
+		auto angle = MathHelper::GetAngleBetweenPoints(startPos, endPositions[i]);
+		ranges[i] = MathHelper::GetDistanceBetweenPoints(startPos, endPositions[i]);
+		segments.emplace_back(startPos, MathHelper::GetPointFromAngle(startPos, angle, ranges[i]));
+	}
+
+	std::vector<sf::Vector2f> hitpoints;
+	GetSegmentsHitpoints(segments, hitpoints);
+
+	distancesToHitpoint.resize(endPositions.size());
+	hits.resize(endPositions.size());
+	for (size_t i = 0; i < endPositions.size(); i++)
+	{
+		distancesToHitpoint[i] = MathHelper::GetDistanceBetweenPoints(startPos, hitpoints[i]);
+		hits[i] = (distancesToHitpoint[i] >= ranges[i] - precision && distancesToHitpoint[i] <= ranges[i] + precision);
+	}
+}
+
+sf::Vector2f CollisionsManager::GetEdgesHitpoint(const sf::Vector2f& startPos, const sf::Vector2f& endPos) const
+{
+	auto hit = _edgesGrid.GetSegmentHit(startPos, endPos);
+	if (hit == INFINITY)
+		return endPos;
+	return startPos + (endPos - startPos) * hit;
+}
+
+void CollisionsManager::GetEdgesInRect(const sf::FloatRect& rect, std::vector<size_t>& output) const
+{
+	_edgesGrid.GetEdgesInRect(rect, output);
+}
+
 const std::vector<MapLayerModel<bool>>* CollisionsManager::GetStoredMaps() const
 {
 	return &_maps;
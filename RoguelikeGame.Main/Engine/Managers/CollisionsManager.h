@@ -2,11 +2,16 @@
 
 #include <tuple>
 #include <array>
+#include <thread>
+#include <unordered_map>
 
 #include "../Core/Logger.h"
 
 #include "../Helpers/CollisionHelper.h"
 #include "../Models/MapLayerModel.h"
+#include "../Utilities/EdgeGrid.h"
+#include "../Utilities/BitGrid.h"
+#include "../Utilities/DistanceField.h"
 
 #include "SFML/Graphics/RenderTarget.hpp"
 #include "SFML/Graphics/VertexArray.hpp"
@@ -18,15 +23,36 @@ private:
 	Logger* _logger;
 
 	std::vector<MapLayerModel<bool>> _maps;
+	std::vector<BitGrid> _mapsBits; //Packed copy of every map
 	MapLayerModel<bool> _sumMap;
+	BitGrid _sumBits; //Packed copy of common map
+	DistanceField _distanceField; //Built with common map
 
 	std::vector<std::tuple<sf::Vector2f, sf::Vector2f>> _edges;
 	sf::VertexArray _edgesLines;
+	EdgeGrid _edgesGrid; //Rebuilt with edges
+
+	static const unsigned int EDGES_BUCKET_TILES = 8; //Bigger buckets pay off when edges are tested 4 at once
+	static const unsigned int EDGES_BAND_ROWS = 64; //Smallest rows band worth own thread
+	enum EdgeSide { EDGE_WEST = 0, EDGE_EAST = 1, EDGE_NORTH = 2, EDGE_SOUTH = 3 };
 
 	sf::Color _linesColor;
 
 	bool _showCollisionLines;
 
+	uint64_t _version; //Changed every time collision data changes
+
+	//Edges along one tiles line (0 - map size) for tiles range on it, merged with edges of same side, output is indexed by side
+	void AppendHorizontalEdges(unsigned int line, unsigned int firstTile, unsigned int lastTile, std::array<std::vector<EdgeGrid::Edge>, 4>& output) const;
+	void AppendVerticalEdges(unsigned int line, unsigned int firstTile, unsigned int lastTile, std::array<std::vector<EdgeGrid::Edge>, 4>& output) const;
+	//Edges grid and debug lines
+	void RebuildEdgesData();
+	//Common map, distance field and edges for tiles (rect in tiles) after stored maps changed
+	void UpdateCommonTiles(const sf::IntRect& tiles);
+
+	//Hitpoint for every segment (start, end), end if nothing is hit
+	void GetSegmentsHitpoints(const std::vector<EdgeGrid::Edge>& segments, std::vector<sf::Vector2f>& output) const;
+
 	// Inherited via Drawable
 	void draw(sf::RenderTarget& target, sf::RenderStates) const override;
 public:
@@ -35,9 +61,14 @@ public:
 
 	template<typename T>
 	void AddMap(const MapLayerModel<T>& map, const T& block);
+	//Copies tiles inside rect (in tiles) from map added with same id, false if there is no such map
+	template<typename T>
+	bool UpdateMap(const MapLayerModel<T>& map, const T& block, const sf::IntRect& tiles);
 
 	void GenerateCommonMap();
 	void CovertTilesIntoEdges();
+	//Common map has to be updated first, rect is in tiles
+	void UpdateEdges(const sf::IntRect& tiles);
 
 	//Manager setters
 	void SetCollisionLinesColor(const sf::Color& color);
@@ -53,13 +84,37 @@ public:
 	bool CheckCircleCollision(const sf::Vector2f& center, float radius) const;
 	sf::Vector2f GetCircleLimitPosition(const sf::Vector2f& startPos, const sf::Vector2f& endPos, float radius) const;
 	sf::Vector2f GetLimitPosition(const sf::FloatRect& startPos, const sf::FloatRect& endPos) const;
+	//Whole move is swept and slid along walls, so fast movers can't skip thin walls
+	sf::Vector2f GetSweptLimitPosition(const sf::FloatRect& startPos, const sf::FloatRect& endPos) const;
+	sf::Vector2f GetSweptCircleLimitPosition(const sf::Vector2f& startPos, const sf::Vector2f& endPos, float radius) const;
+	CollisionHelper::SweepHit SweepRect(const sf::FloatRect& rect, const sf::Vector2f& move) const;
+	CollisionHelper::SweepHit SweepCircle(const sf::Vector2f& center, float radius, const sf::Vector2f& move) const;
 	sf::Vector2f GetRayHitpoint(const sf::Vector2f& center, float angle, float raycastRange) const;
 	bool RaycastHitsPoint(const sf::Vector2f& startPos, const sf::Vector2f& endPos, float* distanceToHitpoint) const;
+	bool TileRaycastHitsPoint(const sf::Vector2f& startPos, const sf::Vector2f& endPos, float* distanceToHitpoint) const;
+	//Same ray tests on copies of common map and edges grid, for threads that can't use manager while it changes
+	static sf::Vector2f GetRayHitpoint(const MapLayerModel<bool>& tiles, const EdgeGrid& edgesGrid, const sf::Vector2f& center, float angle, float raycastRange);
+	static bool RaycastHitsPoint(const MapLayerModel<bool>& tiles, const EdgeGrid& edgesGrid, const sf::Vector2f& startPos, const sf::Vector2f& endPos, float* distanceToHitpoint);
+	static bool TileRaycastHitsPoint(const MapLayerModel<bool>& tiles, const EdgeGrid& edgesGrid, const sf::Vector2f& startPos, const sf::Vector2f& endPos, float* distanceToHitpoint);
+	//Distance field lookups, distance is negative inside walls
+	float DistanceToWall(const sf::Vector2f& pos) const;
+	sf::Vector2f GradientAwayFromWall(const sf::Vector2f& pos) const;
+	//Batched ray methods, one result per ray
+	void GetRayHitpoints(const sf::Vector2f& center, const std::vector<float>& angles, float raycastRange, std::vector<sf::Vector2f>& output) const;
+	void GetRayHitpoints(const std::vector<std::tuple<sf::Vector2f, float, float>>& rays, std::vector<sf::Vector2f>& output) const; //Center, angle, range
+	void RaycastHitsPoints(const sf::Vector2f& startPos, const std::vector<sf::Vector2f>& endPositions, std::vector<float>& distancesToHitpoint, std::vector<bool>& hits) const;
+	//Same as ray methods but tested against edges, returns endPos if nothing is hit
+	sf::Vector2f GetEdgesHitpoint(const sf::Vector2f& startPos, const sf::Vector2f& endPos) const;
+	//Indexes of edges which bounding box overlaps rect
+	void GetEdgesInRect(const sf::FloatRect& rect, std::vector<size_t>& output) const;
 
 	//Var access methods
 	const std::vector<MapLayerModel<bool>>* GetStoredMaps() const;
 	const MapLayerModel<bool>* GetCommonMap() const;
+	const BitGrid* GetCommonBits() const;
 	const std::vector<std::tuple<sf::Vector2f, sf::Vector2f>>* GetEdges() const;
+	const EdgeGrid* GetEdgesGrid() const;
+	uint64_t GetVersion() const;
 };
 
 	template<typename T>
@@ -78,9 +133,45 @@ public:
 		blocked.visible = map.visible;
 		blocked.data.resize(map.data.size(), false);
 
+		BitGrid bits;
+		bits.Resize(map.width, map.height);
 		for (size_t i = 0; i < map.data.size(); i++)
 			if (map.data[i] == block)
+			{
 				blocked.data[i] = true;
+				bits.Set((int)(i % map.width), (int)(i / map.width), true);
+			}
 
 		_maps.push_back(blocked);
+		_mapsBits.push_back(std::move(bits));
 };
+
+	template<typename T>
+	inline bool CollisionsManager::UpdateMap(const MapLayerModel<T>& map, const T& block, const sf::IntRect& tiles)
+	{
+		size_t index = 0;
+		while (index < _maps.size() && _maps[index].id != map.id)
+			index++;
+		if (index == _maps.size()) return false;
+
+		auto& blocked = _maps[index];
+		auto& bits = _mapsBits[index];
+		if (blocked.width != map.width || blocked.height != map.height) return false;
+
+		int left = std::max(tiles.left, 0);
+		int top = std::max(tiles.top, 0);
+		int right = std::min(tiles.left + tiles.width, (int)map.width) - 1;
+		int bottom = std::min(tiles.top + tiles.height, (int)map.height) - 1;
+		if (left > right || top > bottom) return true;
+
+		for (int y = top; y <= bottom; y++)
+			for (int x = left; x <= right; x++)
+			{
+				size_t i = (size_t)y * map.width + x;
+				blocked.data[i] = (map.data[i] == block);
+				bits.Set(x, y, blocked.data[i]);
+			}
+
+		UpdateCommonTiles(sf::IntRect(left, top, right - left + 1, bottom - top + 1));
+		return true;
+	};
@@ -2,66 +2,97 @@
 
 EnemiesManager::EnemiesManager()
 {
-	_enemies.clear();
 	_logger = Logger::GetInstance();
 	_player = nullptr;
 }
 
 EnemiesManager::~EnemiesManager()
 {
-	for (auto it : _enemies)
-		if(it != nullptr)
-			delete it;
+	Clear();
 }
 
 void EnemiesManager::Update(bool tick, float deltaTime)
 {
-	for (size_t i = 0; i < _enemies.size(); i++)
+	if (tick) //No need to do it every frame
 	{
-		auto it = _enemies[i];
-
-		if (tick) //No need to do it every frame
+		for (size_t i = 0; i < _store.GetSize();)
 		{
-			if (it->IsDead())
-			{
-				_enemies.erase(_enemies.begin() + i);
-				continue;
-			}
+			if (_store.GetEnemy(i)->IsDead())
+				Release(i); //Next enemy to check is moved to i
+			else
+				i++;
 		}
+	}
 
+	//Objects update animations and weapons, hot data is read back after that
+	auto enemies = _store.GetEnemies();
+	for (size_t i = 0; i < enemies->size(); i++)
+	{
+		auto it = enemies->at(i);
 		it->Update(tick, deltaTime);
+		_store.Gather(i);
 
 		auto wpn = it->GetWeapon();
 		if (wpn == nullptr) continue;
 
-		wpn->setPosition(ViewHelper::GetRectCenter(it->GetCollisionBox()));
+		wpn->setPosition(_store.GetCenter(i));
 	}
+
+	RebuildBroadphase();
+}
+
+void EnemiesManager::RebuildBroadphase()
+{
+	_broadphase.Clear();
+	for (size_t i = 0; i < _store.GetSize(); i++)
+		_broadphase.Insert(i, _store.GetBox(i));
+}
+
+void EnemiesManager::Release(size_t index)
+{
+	auto handle = _store.GetHandle(index);
+	auto enemy = _store.GetEnemy(index);
+	ReleaseWeapon(handle.slot, enemy);
+	_store.Remove(handle);
+
+	if (_enemyPool.Release(enemy) == false)
+		delete enemy;
+}
+
+void EnemiesManager::ReleaseWeapon(uint32_t slot, Enemy* enemy)
+{
+	if (slot >= _pooledWeapons.size() || _pooledWeapons[slot] == nullptr) return;
+
+	auto weapon = _pooledWeapons[slot];
+	if (enemy->GetWeapon() == weapon)
+		enemy->DetachWeapon();
+
+	if (weapon->GetWeaponType() == WeaponType::MELEE)
+		_meleeWeaponPool.Release((MeleeWeapon*)weapon);
+	else
+		_hitboxWeaponPool.Release((HitboxWeapon*)weapon);
+	_pooledWeapons[slot] = nullptr;
 }
 
 void EnemiesManager::CheckForHit()
 {
 	//Player -> Enemy
 	auto weapon = _player->GetWeapon();
+	if (weapon == nullptr) return;
+
 	auto playerCenter = ViewHelper::GetRectCenter(_player->GetCollisionBox());
 	auto playerView = _player->GetView();
 
-	for (auto obj : _enemies)
+	if (weapon->GetWeaponType() == WeaponType::MELEE)
 	{
-		if (CollisionHelper::CheckSimpleCollision(playerView, obj->GetCollisionBox()) == false) continue; //Not in player view
-		if (weapon == nullptr) continue;
-
-		if (weapon->GetWeaponType() == WeaponType::MELEE)
+		MeleeWeapon* wep = (MeleeWeapon*)weapon;
+		_broadphase.QueryCone(playerCenter, wep->GetWeaponRange(), wep->GetWeaponAngle(), wep->GetCurrentAngle(), _queryResult);
+		for (auto id : _queryResult)
 		{
-			auto enemyHitboxPoints = CollisionHelper::GetRectPoints(obj->GetCollisionBox());
-			MeleeWeapon* wep = (MeleeWeapon*)weapon;
-			for (auto &p : enemyHitboxPoints)
-			{
-				if (CollisionHelper::CheckCircleCollision(p, playerCenter, wep->GetWeaponRange(), wep->GetWeaponAngle(), wep->GetCurrentAngle()))
-				{
-					obj->TakeDmg(wep->GetWeaponDMG());
-					break;
-				}
-			}
+			if (CollisionHelper::CheckSimpleCollision(playerView, _store.GetBox(id)) == false) continue; //Not in player view
+
+			_store.GetEnemy(id)->TakeDmg(wep->GetWeaponDMG());
+			_store.Gather(id);
 		}
 	}
 }
@@ -72,10 +103,13 @@ void EnemiesManager::CheckAttacks()
 	auto playerHitbox = _player->GetCollisionBox();
 	auto playerView = _player->GetView();
 
-	for (auto enemy : _enemies)
+	//Only enemies touching player can hit it
+	_broadphase.QueryRect(playerHitbox, _queryResult);
+	for (auto id : _queryResult)
 	{
-		if (CollisionHelper::CheckSimpleCollision(playerView, enemy->GetCollisionBox()) == false) continue; //Not in player view
+		if (CollisionHelper::CheckSimpleCollision(playerView, _store.GetBox(id)) == false) continue; //Not in player view
 
+		auto enemy = _store.GetEnemy(id);
 		auto enemyWeapon = enemy->GetWeapon();
 		if (enemyWeapon == nullptr) continue;
 
@@ -84,13 +118,10 @@ void EnemiesManager::CheckAttacks()
 
 		if (enemyWeapon->GetWeaponType() == WeaponType::NONE) //Enemy attacks if hitboxes collide
 		{
-			auto enemyHitbox = enemy->GetCollisionBox();
-			if (CollisionHelper::CheckSimpleCollision(enemyHitbox, playerHitbox))
-			{
-				_player->TakeDmg(enemyWeapon->GetWeaponDMG());
-				enemy->Attack();
-				continue;
-			}
+			_player->TakeDmg(enemyWeapon->GetWeaponDMG());
+			enemy->Attack();
+			_store.Gather(id);
+			continue;
 		}
 	}
 }
@@ -102,14 +133,14 @@ void EnemiesManager::SetPlayer(Player* player)
 
 void EnemiesManager::SetEnemiesHitboxVisibility(bool visibility)
 {
-	for (auto it : _enemies)
+	for (auto it : *_store.GetEnemies())
 		it->SetHitboxVisibility(visibility);
 }
 
 bool EnemiesManager::GetEnemiesHitboxVisibility() const
 {
-	if(_enemies.size() > 0)
-		return _enemies[0]->GetHitboxVisibility();
+	if(_store.GetSize() > 0)
+		return _store.GetEnemy(0)->GetHitboxVisibility();
 	return false;
 }
 
@@ -125,7 +156,7 @@ void EnemiesManager::ToggleEnemiesRaycastVisibility()
 	bool status = false;
 	bool logged = false;
 
-	for (auto& enemy : _enemies)
+	for (auto enemy : *_store.GetEnemies())
 	{
 		auto enemyWeapon = enemy->GetWeapon();
 		if (enemyWeapon != nullptr)
@@ -142,18 +173,76 @@ void EnemiesManager::ToggleEnemiesRaycastVisibility()
 	}
 }
 
-void EnemiesManager::Add(Enemy* enemy)
+EnemyHandle EnemiesManager::Add(Enemy* enemy)
+{
+	auto handle = _store.Add(enemy);
+	if (_store.IsValid(handle) == false)
+		return handle;
+
+	if (handle.slot >= _pooledWeapons.size())
+		_pooledWeapons.resize(handle.slot + 1, nullptr);
+	_pooledWeapons[handle.slot] = nullptr;
+
+	_broadphase.Insert(_store.GetIndex(handle), _store.GetBox(_store.GetIndex(handle)));
+	return handle;
+}
+
+EnemyHandle EnemiesManager::Spawn(const Enemy* enemyTemplate, const Weapon* weaponTemplate, const sf::Vector2f& position)
+{
+	if (enemyTemplate == nullptr) return EnemyHandle();
+
+	auto enemy = _enemyPool.Acquire(*enemyTemplate);
+	enemy->SetPosition(position);
+
+	Weapon* weapon = nullptr;
+	if (weaponTemplate != nullptr)
+	{
+		if (weaponTemplate->GetWeaponType() == WeaponType::MELEE)
+			weapon = _meleeWeaponPool.Acquire(*(const MeleeWeapon*)weaponTemplate);
+		else
+			weapon = _hitboxWeaponPool.Acquire(*(const HitboxWeapon*)weaponTemplate);
+		enemy->SetWeapon(weapon, false);
+	}
+
+	auto handle = Add(enemy);
+	_pooledWeapons[handle.slot] = weapon;
+	return handle;
+}
+
+bool EnemiesManager::Remove(EnemyHandle handle)
+{
+	auto index = _store.GetIndex(handle);
+	if (index == SIZE_MAX) return false;
+
+	Release(index);
+	RebuildBroadphase();
+	return true;
+}
+
+void EnemiesManager::Clear()
+{
+	while (_store.GetSize() > 0)
+		Release(_store.GetSize() - 1);
+	_broadphase.Clear();
+}
+
+const std::vector<Enemy*>* EnemiesManager::GetEnemies() const
+{
+	return _store.GetEnemies();
+}
+
+EnemyStore* EnemiesManager::GetStore()
 {
-	_enemies.push_back(enemy);
+	return &_store;
 }
 
-std::vector<Enemy*>* EnemiesManager::GetEnemies()
+SpatialHash* EnemiesManager::GetBroadphase()
 {
-	return &_enemies;
+	return &_broadphase;
 }
 
 void EnemiesManager::draw(sf::RenderTarget& target, sf::RenderStates) const
 {
-	for (auto it : _enemies)
+	for (auto it : *_store.GetEnemies())
 		target.draw(*it);
 }
@@ -4,6 +4,10 @@
 
 #include "../Managers/CollisionsManager.h"
 #include "../Helpers/CollisionHelper.h"
+#include "../Utilities/SpatialHash.h"
+#include "../Utilities/EnemyStore.h"
+#include "../Utilities/ObjectPool.hpp"
+#include "../Models/HitboxWeapon.h"
 #include "../Models/MeleeWeapon.h"
 #include "../Models/Player.h"
 #include "../Models/Enemy.h"
@@ -13,10 +17,23 @@ class EnemiesManager : public sf::Drawable
 private:
 	Logger* _logger;
 
-	std::vector<Enemy*> _enemies;
+	EnemyStore _store;
+	SpatialHash _broadphase; //Enemies collision boxes by dense index in _store
+	std::vector<size_t> _queryResult;
+
+	//Spawned enemies and their weapons are reused after death
+	ObjectPool<Enemy> _enemyPool;
+	ObjectPool<HitboxWeapon> _hitboxWeaponPool;
+	ObjectPool<MeleeWeapon> _meleeWeaponPool;
+	std::vector<Weapon*> _pooledWeapons; //By handle slot, dying enemy forgets its weapon before it is removed
 
 	Player* _player;
 
+	void RebuildBroadphase();
+	//Last enemy takes its dense index, pooled objects go back to pools, others are deleted
+	void Release(size_t index);
+	void ReleaseWeapon(uint32_t slot, Enemy* enemy);
+
 	// Inherited via Drawable
 	void draw(sf::RenderTarget& target, sf::RenderStates) const override;
 public:
@@ -34,7 +51,16 @@ public:
 	void ToggleEnemiesHitboxVisibility();
 	void ToggleEnemiesRaycastVisibility();
 
-	void Add(Enemy* enemy);
-	std::vector<Enemy*>* GetEnemies();
+	//Manager owns enemy and deletes it after death
+	EnemyHandle Add(Enemy* enemy);
+	//Copies of templates come from pools, weapon can be nullptr
+	EnemyHandle Spawn(const Enemy* enemyTemplate, const Weapon* weaponTemplate, const sf::Vector2f& position);
+	bool Remove(EnemyHandle handle);
+	void Clear();
+	//Dense order of store
+	const std::vector<Enemy*>* GetEnemies() const;
+	EnemyStore* GetStore();
+	//Rebuilt every update, whoever moves enemy later should insert its new box
+	SpatialHash* GetBroadphase();
 };
 
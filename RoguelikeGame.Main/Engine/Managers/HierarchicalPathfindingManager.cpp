@@ -0,0 +1,437 @@
+#include "HierarchicalPathfindingManager.h"
+
+const uint32_t HierarchicalPathfindingManager::NO_TILE;
+const uint16_t HierarchicalPathfindingManager::NO_ENTRANCE;
+const unsigned int HierarchicalPathfindingManager::MAX_SINGLE_TRANSITION;
+
+namespace
+{
+	//Tile neighbours, diagonals last
+	const int TILE_DX[8] = { 1, -1, 0, 0, 1, 1, -1, -1 };
+	const int TILE_DY[8] = { 0, 0, 1, -1, 1, -1, 1, -1 };
+	const float TILE_COST[8] = { 1.f, 1.f, 1.f, 1.f, 1.41421356f, 1.41421356f, 1.41421356f, 1.41421356f };
+
+	float GetOctileDistance(int ax, int ay, int bx, int by)
+	{
+		float dx = (float)abs(ax - bx);
+		float dy = (float)abs(ay - by);
+		return std::max(dx, dy) + 0.41421356f * std::min(dx, dy);
+	}
+}
+
+HierarchicalPathfindingManager::HierarchicalPathfindingManager()
+{
+	_tiles = nullptr;
+	_clusterSize = 0;
+	_clustersX = 0;
+	_clustersY = 0;
+}
+
+bool HierarchicalPathfindingManager::IsTileFree(int x, int y) const
+{
+	if (x < 0 || y < 0 || x > (int)_tiles->width - 1 || y > (int)_tiles->height - 1) return false;
+	return !_tiles->data[(size_t)y * _tiles->width + x];
+}
+
+uint32_t HierarchicalPathfindingManager::GetClusterOf(uint32_t tile) const
+{
+	return (tile / _tiles->width / _clusterSize) * _clustersX + (tile % _tiles->width) / _clusterSize;
+}
+
+sf::Vector2i HierarchicalPathfindingManager::GetTileOf(const sf::Vector2f& pos) const
+{
+	return sf::Vector2i((int)floorf((pos.x - _tiles->offsetX) / (float)_tiles->tileWidth), (int)floorf((pos.y - _tiles->offsetY) / (float)_tiles->tileHeight));
+}
+
+sf::Vector2f HierarchicalPathfindingManager::GetTileCenter(uint32_t tile) const
+{
+	return sf::Vector2f(((float)(tile % _tiles->width) + 0.5f) * (float)_tiles->tileWidth + _tiles->offsetX,
+						((float)(tile / _tiles->width) + 0.5f) * (float)_tiles->tileHeight + _tiles->offsetY);
+}
+
+void HierarchicalPathfindingManager::BuildAll()
+{
+	_clustersX = (_tiles->width + _clusterSize - 1) / _clusterSize;
+	_clustersY = (_tiles->height + _clusterSize - 1) / _clusterSize;
+
+	_clusters.clear();
+	_clusters.resize((size_t)_clustersX * _clustersY);
+	for (unsigned int y = 0; y < _clustersY; y++)
+		for (unsigned int x = 0; x < _clustersX; x++)
+		{
+			auto& bounds = _clusters[(size_t)y * _clustersX + x].bounds;
+			bounds.left = (int)(x * _clusterSize);
+			bounds.top = (int)(y * _clusterSize);
+			bounds.width = (int)std::min(_clusterSize, _tiles->width - x * _clusterSize);
+			bounds.height = (int)std::min(_clusterSize, _tiles->height - y * _clusterSize);
+		}
+
+	_entranceIndex.assign(_tiles->data.size(), NO_ENTRANCE);
+	for (uint32_t i = 0; i < _clusters.size(); i++)
+		BuildCluster(i);
+
+	_abstract.g.assign(_tiles->data.size(), INFINITY);
+	_abstract.parent.assign(_tiles->data.size(), NO_TILE);
+	_abstract.closed.assign(_tiles->data.size(), 0);
+	_abstract.touched.clear();
+}
+
+void HierarchicalPathfindingManager::AddBorderTransitions(std::vector<uint32_t>& output, int x, int y, int stepX, int stepY, int crossX, int crossY, int length) const
+{
+	//Both clusters walk the border in the same direction, so they pick the same transitions
+	int runStart = -1;
+	for (int i = 0; i <= length; i++)
+	{
+		int tx = x + i * stepX;
+		int ty = y + i * stepY;
+		bool open = (i < length && IsTileFree(tx, ty) && IsTileFree(tx + crossX, ty + crossY));
+		if (open && runStart < 0) runStart = i;
+		if (open || runStart < 0) continue;
+
+		int runEnd = i - 1;
+		if ((unsigned int)(runEnd - runStart + 1) < MAX_SINGLE_TRANSITION)
+		{
+			int mid = runStart + (runEnd - runStart) / 2;
+			output.push_back((uint32_t)(y + mid * stepY) * _tiles->width + (uint32_t)(x + mid * stepX));
+		}
+		else
+		{
+			output.push_back((uint32_t)(y + runStart * stepY) * _tiles->width + (uint32_t)(x + runStart * stepX));
+			output.push_back((uint32_t)(y + runEnd * stepY) * _tiles->width + (uint32_t)(x + runEnd * stepX));
+		}
+		runStart = -1;
+	}
+}
+
+void HierarchicalPathfindingManager::BuildCluster(uint32_t cluster)
+{
+	auto& current = _clusters[cluster];
+	for (auto tile : current.entrances)
+		_entranceIndex[tile] = NO_ENTRANCE;
+	current.entrances.clear();
+
+	auto& bounds = current.bounds;
+	int right = bounds.left + bounds.width - 1;
+	int bottom = bounds.top + bounds.height - 1;
+	if (bounds.left > 0)
+		AddBorderTransitions(current.entrances, bounds.left, bounds.top, 0, 1, -1, 0, bounds.height);
+	if (right < (int)_tiles->width - 1)
+		AddBorderTransitions(current.entrances, right, bounds.top, 0, 1, 1, 0, bounds.height);
+	if (bounds.top > 0)
+		AddBorderTransitions(current.entrances, bounds.left, bounds.top, 1, 0, 0, -1, bounds.width);
+	if (bottom < (int)_tiles->height - 1)
+		AddBorderTransitions(current.entrances, bounds.left, bottom, 1, 0, 0, 1, bounds.width);
+
+	//Corner tiles can be on two borders
+	std::sort(current.entrances.begin(), current.entrances.end());
+	current.entrances.erase(std::unique(current.entrances.begin(), current.entrances.end()), current.entrances.end());
+	for (size_t i = 0; i < current.entrances.size(); i++)
+		_entranceIndex[current.entrances[i]] = (uint16_t)i;
+
+	size_t count = current.entrances.size();
+	current.distances.assign(count * count, INFINITY);
+	for (size_t i = 0; i < count; i++)
+	{
+		SearchCluster(_refineField, bounds, current.entrances[i], NO_TILE);
+		for (size_t j = 0; j < count; j++)
+			current.distances[i * count + j] = GetFieldCost(_refineField, current.entrances[j]);
+	}
+}
+
+bool HierarchicalPathfindingManager::SearchCluster(ClusterField& field, const sf::IntRect& bounds, uint32_t from, uint32_t to)
+{
+	size_t size = (size_t)bounds.width * bounds.height;
+	field.bounds = bounds;
+	field.g.assign(size, INFINITY);
+	field.parent.assign(size, NO_TILE);
+	field.closed.assign(size, 0);
+
+	auto width = _tiles->width;
+	int toX = (int)(to % width);
+	int toY = (int)(to / width);
+	auto heuristic = [&](int x, int y) { return (to == NO_TILE) ? 0.f : GetOctileDistance(x, y, toX, toY); };
+	auto local = [&](int x, int y) { return (size_t)(y - bounds.top) * bounds.width + (size_t)(x - bounds.left); };
+
+	int fromX = (int)(from % width);
+	int fromY = (int)(from / width);
+	field.g[local(fromX, fromY)] = 0.f;
+
+	OpenSet notTestedTiles;
+	notTestedTiles.push(OpenSetEntry(heuristic(fromX, fromY), from));
+	while (!notTestedTiles.empty())
+	{
+		auto current = notTestedTiles.top().second;
+		notTestedTiles.pop();
+		if (current == to) return true;
+
+		int x = (int)(current % width);
+		int y = (int)(current / width);
+		auto currentLocal = local(x, y);
+		if (field.closed[currentLocal]) continue; //Stale entry
+		field.closed[currentLocal] = 1;
+
+		for (int dir = 0; dir < 8; dir++)
+		{
+			int nx = x + TILE_DX[dir];
+			int ny = y + TILE_DY[dir];
+			if (nx < bounds.left || ny < bounds.top || nx > bounds.left + bounds.width - 1 || ny > bounds.top + bounds.height - 1) continue;
+			if (!IsTileFree(nx, ny)) continue;
+			if (dir >= 4 && (!IsTileFree(nx, y) || !IsTileFree(x, ny))) continue; //No corner cutting
+
+			auto neighbourLocal = local(nx, ny);
+			float g = field.g[currentLocal] + TILE_COST[dir];
+			if (g < field.g[neighbourLocal])
+			{
+				field.g[neighbourLocal] = g;
+				field.parent[neighbourLocal] = current;
+				notTestedTiles.push(OpenSetEntry(g + heuristic(nx, ny), (uint32_t)ny * width + (uint32_t)nx));
+			}
+		}
+	}
+	return (to == NO_TILE);
+}
+
+float HierarchicalPathfindingManager::GetFieldCost(const ClusterField& field, uint32_t tile) const
+{
+	int x = (int)(tile % _tiles->width);
+	int y = (int)(tile / _tiles->width);
+	if (!field.bounds.contains(x, y)) return INFINITY;
+	return field.g[(size_t)(y - field.bounds.top) * field.bounds.width + (size_t)(x - field.bounds.left)];
+}
+
+void HierarchicalPathfindingManager::AppendFieldPath(const ClusterField& field, uint32_t from, std::vector<uint32_t>& output, bool reversed) const
+{
+	std::vector<uint32_t> path;
+	auto width = _tiles->width;
+	for (auto tile = from; tile != NO_TILE; )
+	{
+		path.push_back(tile);
+		int x = (int)(tile % width);
+		int y = (int)(tile / width);
+		tile = field.parent[(size_t)(y - field.bounds.top) * field.bounds.width + (size_t)(x - field.bounds.left)];
+	}
+	if (reversed) std::reverse(path.begin(), path.end());
+
+	//First tile is already in output
+	output.insert(output.end(), path.begin() + 1, path.end());
+}
+
+void HierarchicalPathfindingManager::Build(CollisionsManager* collisions, unsigned int clusterSize)
+{
+	Clear();
+
+	auto tiles = collisions->GetCommonMap();
+	if (clusterSize == 0 || tiles->width == 0 || tiles->height == 0 || tiles->tileWidth == 0 || tiles->tileHeight == 0) return;
+
+	_tiles = tiles;
+	_clusterSize = clusterSize;
+	BuildAll();
+}
+
+void HierarchicalPathfindingManager::Clear()
+{
+	_tiles = nullptr;
+	_clusterSize = 0;
+	_clustersX = 0;
+	_clustersY = 0;
+	_clusters.clear();
+	_entranceIndex.clear();
+	_abstract = SearchBuffer();
+}
+
+void HierarchicalPathfindingManager::UpdateTiles(const sf::IntRect& changedTiles)
+{
+	if (_tiles == nullptr) return;
+
+	//Map was resized, nothing to keep
+	if (_entranceIndex.size() != _tiles->data.size())
+	{
+		BuildAll();
+		return;
+	}
+
+	//Tile next to cluster border changes entrances of cluster on the other side too
+	int left = std::max(changedTiles.left - 1, 0);
+	int top = std::max(changedTiles.top - 1, 0);
+	int right = std::min(changedTiles.left + changedTiles.width, (int)_tiles->width - 1);
+	int bottom = std::min(changedTiles.top + changedTiles.height, (int)_tiles->height - 1);
+	if (left > right || top > bottom) return;
+
+	for (int y = top / (int)_clusterSize; y <= bottom / (int)_clusterSize; y++)
+		for (int x = left / (int)_clusterSize; x <= right / (int)_clusterSize; x++)
+			BuildCluster((uint32_t)y * _clustersX + (uint32_t)x);
+}
+
+bool HierarchicalPathfindingManager::IsBuilt() const
+{
+	return _tiles != nullptr;
+}
+
+size_t HierarchicalPathfindingManager::GetClustersCount() const
+{
+	return _clusters.size();
+}
+
+size_t HierarchicalPathfindingManager::GetEntrancesCount() const
+{
+	size_t count = 0;
+	for (auto& cluster : _clusters)
+		count += cluster.entrances.size();
+	return count;
+}
+
+std::vector<sf::Vector2f> HierarchicalPathfindingManager::GetPath(const sf::Vector2f& startPos, const sf::Vector2f& endPos, float clearance, size_t* expandedNodes)
+{
+	std::vector<sf::Vector2f> output;
+	if (expandedNodes != nullptr) *expandedNodes = 0;
+	if (_tiles == nullptr || _entranceIndex.size() != _tiles->data.size()) return output;
+
+	auto start = GetTileOf(startPos);
+	auto end = GetTileOf(endPos);
+	if (!IsTileFree(start.x, start.y) || !IsTileFree(end.x, end.y)) return output;
+	if (start == end)
+	{
+		output.push_back(endPos);
+		return output;
+	}
+
+	auto width = _tiles->width;
+	uint32_t startTile = (uint32_t)start.y * width + (uint32_t)start.x;
+	uint32_t endTile = (uint32_t)end.y * width + (uint32_t)end.x;
+	uint32_t startCluster = GetClusterOf(startTile);
+	uint32_t endCluster = GetClusterOf(endTile);
+
+	std::vector<uint32_t> tilePath;
+	tilePath.push_back(startTile);
+
+	SearchCluster(_startField, _clusters[startCluster].bounds, startTile, NO_TILE);
+	if (startCluster == endCluster && GetFieldCost(_startField, endTile) != INFINITY)
+		AppendFieldPath(_startField, endTile, tilePath, true); //Reachable inside cluster, abstract graph not needed
+	else
+	{
+		SearchCluster(_endField, _clusters[endCluster].bounds, endTile, NO_TILE);
+
+		//Reset scratch
+		for (auto tile : _abstract.touched)
+		{
+			_abstract.g[tile] = INFINITY;
+			_abstract.parent[tile] = NO_TILE;
+			_abstract.closed[tile] = 0;
+		}
+		_abstract.touched.clear();
+
+		//A* on entrances, start and end are linked with entrances of their clusters
+		OpenSet notTestedNodes;
+		auto relax = [&](uint32_t from, uint32_t to, float cost)
+		{
+			if (cost == INFINITY || _abstract.closed[to]) return;
+			float g = _abstract.g[from] + cost;
+			if (g < _abstract.g[to])
+			{
+				if (_abstract.g[to] == INFINITY) _abstract.touched.push_back(to);
+				_abstract.g[to] = g;
+				_abstract.parent[to] = from;
+				notTestedNodes.push(OpenSetEntry(g + GetOctileDistance((int)(to % width), (int)(to / width), end.x, end.y), to));
+			}
+		};
+
+		_abstract.g[startTile] = 0.f;
+		_abstract.touched.push_back(startTile);
+		notTestedNodes.push(OpenSetEntry(GetOctileDistance(start.x, start.y, end.x, end.y), startTile));
+
+		bool found = false;
+		while (!notTestedNodes.empty())
+		{
+			auto current = notTestedNodes.top().second;
+			notTestedNodes.pop();
+			if (_abstract.closed[current]) continue; //Stale entry
+			_abstract.closed[current] = 1;
+			if (expandedNodes != nullptr) (*expandedNodes)++;
+			if (current == endTile)
+			{
+				found = true;
+				break;
+			}
+
+			auto cluster = GetClusterOf(current);
+			auto& clusterData = _clusters[cluster];
+			auto index = _entranceIndex[current];
+			if (current == startTile)
+			{
+				for (auto entrance : clusterData.entrances)
+					relax(current, entrance, GetFieldCost(_startField, entrance));
+			}
+			else if (index != NO_ENTRANCE)
+			{
+				size_t count = clusterData.entrances.size();
+				for (size_t i = 0; i < count; i++)
+					if (i != index)
+						relax(current, clusterData.entrances[i], clusterData.distances[index * count + i]);
+			}
+
+			//Entrances on other side of cluster border
+			if (index != NO_ENTRANCE)
+			{
+				int x = (int)(current % width);
+				int y = (int)(current / width);
+				for (int dir = 0; dir < 4; dir++)
+				{
+					int nx = x + TILE_DX[dir];
+					int ny = y + TILE_DY[dir];
+					if (!IsTileFree(nx, ny)) continue;
+
+					uint32_t neighbour = (uint32_t)ny * width + (uint32_t)nx;
+					if (_entranceIndex[neighbour] != NO_ENTRANCE && GetClusterOf(neighbour) != cluster)
+						relax(current, neighbour, TILE_COST[dir]);
+				}
+			}
+
+			if (cluster == endCluster)
+				relax(current, endTile, GetFieldCost(_endField, current));
+		}
+		if (!found) return output;
+
+		std::vector<uint32_t> abstractPath;
+		for (auto tile = endTile; tile != NO_TILE; tile = _abstract.parent[tile])
+			abstractPath.push_back(tile);
+		std::reverse(abstractPath.begin(), abstractPath.end());
+
+		//Refine every abstract step into tiles
+		for (size_t i = 0; i + 1 < abstractPath.size(); i++)
+		{
+			auto from = abstractPath[i];
+			auto to = abstractPath[i + 1];
+			auto cluster = GetClusterOf(from);
+			if (cluster != GetClusterOf(to))
+				tilePath.push_back(to);
+			else if (to == endTile)
+				AppendFieldPath(_endField, from, tilePath, false);
+			else if (from == startTile)
+				AppendFieldPath(_startField, to, tilePath, true);
+			else
+			{
+				SearchCluster(_refineField, _clusters[cluster].bounds, from, to);
+				AppendFieldPath(_refineField, to, tilePath, true);
+			}
+		}
+	}
+
+	std::vector<sf::Vector2f> waypoints;
+	waypoints.reserve(tilePath.size() + 1);
+	for (auto tile : tilePath)
+		waypoints.push_back(GetTileCenter(tile));
+	waypoints.push_back(endPos);
+
+	//String pulling, walk forward while waypoints can be reached in straight line
+	sf::Vector2f anchor = startPos;
+	for (size_t i = 1; i < waypoints.size(); i++)
+		if (CollisionHelper::GetSegmentTileEntry(anchor, waypoints[i], clearance, _tiles) != INFINITY && anchor != waypoints[i - 1])
+		{
+			anchor = waypoints[i - 1];
+			output.push_back(anchor);
+			i--; //Test same waypoint from new anchor
+		}
+	output.push_back(waypoints.back());
+
+	return output;
+}
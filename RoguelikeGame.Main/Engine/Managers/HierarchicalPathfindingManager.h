@@ -0,0 +1,91 @@
+#pragma once
+
+#include <vector>
+#include <algorithm>
+#include <cstdint>
+#include <queue>
+
+#include "../Managers/CollisionsManager.h"
+#include "../Helpers/CollisionHelper.h"
+
+//HPA* on collision tiles, map is split into square clusters and only
+//entrances between them are searched, then the result is refined inside clusters
+class HierarchicalPathfindingManager
+{
+private:
+	struct Cluster
+	{
+		sf::IntRect bounds; //In tiles
+		std::vector<uint32_t> entrances; //Tile indexes
+		std::vector<float> distances; //entrances x entrances, INFINITY if not connected inside cluster
+	};
+
+	//Per query state indexed by tile, only touched tiles are reset
+	struct SearchBuffer
+	{
+		std::vector<float> g;
+		std::vector<uint32_t> parent;
+		std::vector<uint8_t> closed;
+		std::vector<uint32_t> touched;
+	};
+
+	//Search state inside one cluster, indexed by tile position in cluster bounds
+	struct ClusterField
+	{
+		sf::IntRect bounds;
+		std::vector<float> g;
+		std::vector<uint32_t> parent; //Tile indexes
+		std::vector<uint8_t> closed;
+	};
+
+	typedef std::pair<float, uint32_t> OpenSetEntry;
+	struct OpenSetCompare
+	{
+		bool operator()(const OpenSetEntry& lhs, const OpenSetEntry& rhs) const { return lhs.first > rhs.first; }
+	};
+	typedef std::priority_queue<OpenSetEntry, std::vector<OpenSetEntry>, OpenSetCompare> OpenSet;
+
+	static const uint32_t NO_TILE = UINT32_MAX;
+	static const uint16_t NO_ENTRANCE = UINT16_MAX;
+	static const unsigned int MAX_SINGLE_TRANSITION = 6; //Longer entrances get transition on both ends
+
+	const MapLayerModel<bool>* _tiles;
+	unsigned int _clusterSize;
+	unsigned int _clustersX;
+	unsigned int _clustersY;
+	std::vector<Cluster> _clusters;
+	std::vector<uint16_t> _entranceIndex; //Per tile, index in its cluster entrances
+
+	SearchBuffer _abstract;
+	ClusterField _startField;
+	ClusterField _endField;
+	ClusterField _refineField;
+
+	bool IsTileFree(int x, int y) const;
+	uint32_t GetClusterOf(uint32_t tile) const;
+	sf::Vector2i GetTileOf(const sf::Vector2f& pos) const;
+	sf::Vector2f GetTileCenter(uint32_t tile) const;
+
+	void BuildAll();
+	void AddBorderTransitions(std::vector<uint32_t>& output, int x, int y, int stepX, int stepY, int crossX, int crossY, int length) const;
+	void BuildCluster(uint32_t cluster);
+	bool SearchCluster(ClusterField& field, const sf::IntRect& bounds, uint32_t from, uint32_t to);
+	float GetFieldCost(const ClusterField& field, uint32_t tile) const;
+	void AppendFieldPath(const ClusterField& field, uint32_t from, std::vector<uint32_t>& output, bool reversed) const;
+public:
+	HierarchicalPathfindingManager();
+	~HierarchicalPathfindingManager() = default;
+
+	//Builds all clusters from collisions common map, pointer is kept for later queries
+	void Build(CollisionsManager* collisions, unsigned int clusterSize = 16);
+	void Clear();
+	//Rebuilds only clusters touched by changed tiles (rect in tiles)
+	void UpdateTiles(const sf::IntRect& changedTiles);
+
+	bool IsBuilt() const;
+	size_t GetClustersCount() const;
+	size_t GetEntrancesCount() const;
+
+	//Returns string pulled waypoints from start to end (start excluded), empty if no path
+	std::vector<sf::Vector2f> GetPath(const sf::Vector2f& startPos, const sf::Vector2f& endPos, float clearance = 0.f, size_t* expandedNodes = nullptr);
+};
@@ -116,56 +116,92 @@ ObjectsManager::~ObjectsManager()
 
 
 //Get
-MeleeWeapon* ObjectsManager::GetMeleeWeapon(const std::string& name)
+MeleeWeapon* ObjectsManager::FindMeleeWeapon(const std::string& name)
 {
 	auto found = _meleeWeapons.find(name);
-	if (found != _meleeWeapons.end())
-	{
-		if (found->second == nullptr)
-		{
-			if(name == "sword") found->second = CreateMeleeWeaponSword();
-		}
+	if (found == _meleeWeapons.end())
+		return nullptr;
 
-		auto obj = new MeleeWeapon(*(found->second));
-		obj->GetTransformAnimation()->SetTarget(obj->GetAnimation()->ExternalTransform());
-		return obj;
+	if (found->second == nullptr)
+	{
+		if(name == "sword") found->second = CreateMeleeWeaponSword();
 	}
-	return new MeleeWeapon();
+	return found->second;
 }
 
-HitboxWeapon* ObjectsManager::GetHitboxWeapon(const std::string& name)
+HitboxWeapon* ObjectsManager::FindHitboxWeapon(const std::string& name)
 {
 	auto found = _hitboxWeapons.find(name);
-	if (found != _hitboxWeapons.end())
+	if (found == _hitboxWeapons.end())
+		return nullptr;
+
+	if (found->second == nullptr)
 	{
-		if (found->second == nullptr)
-		{
-			if (name == "bite") found->second = CreateHitboxWeaponBite();
-		}
+		if (name == "bite") found->second = CreateHitboxWeaponBite();
+	}
+	return found->second;
+}
+
+Enemy* ObjectsManager::FindEnemy(const std::string& name)
+{
+	auto found = _enemies.find(name);
+	if (found == _enemies.end())
+		return nullptr;
+
+	if (found->second == nullptr)
+	{
+		if(name == "devil")found->second = CreateEnemyDevil();
+	}
+	return found->second;
+}
 
-		auto obj = new HitboxWeapon(*(found->second));
+MeleeWeapon* ObjectsManager::GetMeleeWeapon(const std::string& name)
+{
+	auto found = FindMeleeWeapon(name);
+	if (found != nullptr)
+	{
+		auto obj = new MeleeWeapon(*found);
+		obj->GetTransformAnimation()->SetTarget(obj->GetAnimation()->ExternalTransform());
 		return obj;
 	}
+	return new MeleeWeapon();
+}
+
+HitboxWeapon* ObjectsManager::GetHitboxWeapon(const std::string& name)
+{
+	auto found = FindHitboxWeapon(name);
+	if (found != nullptr)
+		return new HitboxWeapon(*found);
 	return new HitboxWeapon();
 }
 
 Enemy* ObjectsManager::GetEnemy(const std::string& name)
 {
-	auto found = _enemies.find(name);
-	if (found != _enemies.end())
+	auto found = FindEnemy(name);
+	if (found != nullptr)
 	{
-		if (found->second == nullptr)
-		{
-			if(name == "devil")found->second = CreateEnemyDevil();
-		}
-
-		auto obj = new Enemy(*(found->second));
+		auto obj = new Enemy(*found);
 		obj->GetAnimations()->UpdateCurrentAnimationPtr();
 		return obj;
 	}
 	return new Enemy();
 }
 
+const MeleeWeapon* ObjectsManager::GetMeleeWeaponTemplate(const std::string& name)
+{
+	return FindMeleeWeapon(name);
+}
+
+const HitboxWeapon* ObjectsManager::GetHitboxWeaponTemplate(const std::string& name)
+{
+	return FindHitboxWeapon(name);
+}
+
+const Enemy* ObjectsManager::GetEnemyTemplate(const std::string& name)
+{
+	return FindEnemy(name);
+}
+
 Player* ObjectsManager::GetPlayer(const std::string& name)
 {
 	auto found = _players.find(name);
@@ -59,6 +59,11 @@ private:
 	//Players
 	Player* CreatePlayerMaleElf();
 
+	//Templates are created on first use, nullptr for unknown name
+	MeleeWeapon* FindMeleeWeapon(const std::string& name);
+	HitboxWeapon* FindHitboxWeapon(const std::string& name);
+	Enemy* FindEnemy(const std::string& name);
+
 	//FocusContainers
 	FocusContainer* CreateFocusContainerOptionBar();
 	FocusContainer* CreateFocusContainerOptionCheckBox();
@@ -93,6 +98,10 @@ public:
 	MeleeWeapon* GetMeleeWeapon(const std::string& name);
 	HitboxWeapon* GetHitboxWeapon(const std::string& name);
 	Enemy* GetEnemy(const std::string& name);
+	//Shared template objects, for copying into pools instead of allocating new copy
+	const MeleeWeapon* GetMeleeWeaponTemplate(const std::string& name);
+	const HitboxWeapon* GetHitboxWeaponTemplate(const std::string& name);
+	const Enemy* GetEnemyTemplate(const std::string& name);
 	Player* GetPlayer(const std::string& name);
 
 	FocusContainer* GetFocusContainer(const std::string& name);
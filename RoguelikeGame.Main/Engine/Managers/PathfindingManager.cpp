@@ -1,330 +1,1781 @@
 #include "PathfindingManager.h"
 
-std::vector<sf::Vector2f> PathfindingManager::SolveAStar(Cell* startCell, Cell* endCell)
+const uint32_t PathfindingManager::NO_NODE;
+const uint32_t PathfindingManager::GRAPH_FILE_MAGIC;
+const uint32_t PathfindingManager::GRAPH_FILE_VERSION;
+
+namespace
+{
+	//Tile neighbours, diagonals last
+	const int FLOW_DX[8] = { 1, -1, 0, 0, 1, 1, -1, -1 };
+	const int FLOW_DY[8] = { 0, 0, 1, -1, 1, -1, 1, -1 };
+	const float FLOW_COST[8] = { 1.f, 1.f, 1.f, 1.f, 1.41421356f, 1.41421356f, 1.41421356f, 1.41421356f };
+	const float SHADOW_MARGIN = 0.1f; //Wall runs are shrunk by it, so rays only grazing them aren't counted as blocked
+
+	//Segment gets inside rect, slab test
+	bool SegmentCrossesRect(const sf::Vector2f& start, const sf::Vector2f& end, const sf::FloatRect& rect)
+	{
+		float tMin = 0.f, tMax = 1.f;
+		float p[2] = { start.x, start.y };
+		float d[2] = { end.x - start.x, end.y - start.y };
+		float lo[2] = { rect.left, rect.top };
+		float hi[2] = { rect.left + rect.width, rect.top + rect.height };
+		for (int i = 0; i < 2; i++)
+		{
+			if (d[i] == 0.f)
+			{
+				if (p[i] <= lo[i] || p[i] >= hi[i]) return false;
+				continue;
+			}
+			float t1 = (lo[i] - p[i]) / d[i];
+			float t2 = (hi[i] - p[i]) / d[i];
+			if (t1 > t2) std::swap(t1, t2);
+			tMin = std::max(tMin, t1);
+			tMax = std::min(tMax, t2);
+			if (tMin >= tMax) return false;
+		}
+		return true;
+	}
+
+	//Part of convex polygon on left side of line, one Sutherland-Hodgman step
+	std::vector<sf::Vector2f> ClipPolygon(const std::vector<sf::Vector2f>& polygon, const sf::Vector2f& origin, const sf::Vector2f& direction)
+	{
+		std::vector<sf::Vector2f> output;
+		auto side = [&](const sf::Vector2f& point) { return direction.x * (point.y - origin.y) - direction.y * (point.x - origin.x); };
+		for (size_t i = 0; i < polygon.size(); i++)
+		{
+			auto& from = polygon[i];
+			auto& to = polygon[(i + 1) % polygon.size()];
+			float fromSide = side(from), toSide = side(to);
+			if (fromSide >= 0)
+				output.push_back(from);
+			if ((fromSide < 0) != (toSide < 0))
+				output.push_back(from + (to - from) * (fromSide / (fromSide - toSide)));
+		}
+		return output;
+	}
+
+	//X range of convex polygon part between y0 and y1, false if polygon misses band
+	bool GetPolygonSpan(const std::vector<sf::Vector2f>& polygon, float y0, float y1, float& minX, float& maxX)
+	{
+		minX = INFINITY;
+		maxX = -INFINITY;
+		for (size_t i = 0; i < polygon.size(); i++)
+		{
+			auto& from = polygon[i];
+			auto& to = polygon[(i + 1) % polygon.size()];
+			if (from.y >= y0 && from.y <= y1)
+			{
+				minX = std::min(minX, from.x);
+				maxX = std::max(maxX, from.x);
+			}
+			for (float y : { y0, y1 })
+				if ((from.y - y) * (to.y - y) < 0)
+				{
+					float x = from.x + (to.x - from.x) * (y - from.y) / (to.y - from.y);
+					minX = std::min(minX, x);
+					maxX = std::max(maxX, x);
+				}
+		}
+		return minX <= maxX;
+	}
+}
+
+void PathfindingManager::SearchBuffer::Reset(size_t graphSize)
+{
+	//Two extra slots for temporary start and end nodes
+	size_t size = graphSize + 2;
+	localGoal.assign(size, INFINITY);
+	globalGoal.assign(size, INFINITY);
+	parent.assign(size, NO_NODE);
+	visited.assign(size, 0);
+}
+
+void PathfindingManager::NodeGrid::Build(const std::vector<sf::Vector2f>& points, float size)
+{
+	min = sf::Vector2f(INFINITY, INFINITY);
+	max = sf::Vector2f(-INFINITY, -INFINITY);
+	for (auto& point : points)
+	{
+		min.x = std::min(min.x, point.x);
+		min.y = std::min(min.y, point.y);
+		max.x = std::max(max.x, point.x);
+		max.y = std::max(max.y, point.y);
+	}
+
+	cellSize = size;
+	columns = rows = 1;
+	if (cellSize > 0 && cellSize != INFINITY && !points.empty())
+	{
+		size_t x = (size_t)((max.x - min.x) / cellSize) + 1;
+		size_t y = (size_t)((max.y - min.y) / cellSize) + 1;
+
+		//Too many empty cells, use one cell instead
+		if (x * y <= points.size() * 4 + 16)
+		{
+			columns = (int)x;
+			rows = (int)y;
+		}
+	}
+
+	//Counted first, so nodes of every cell are in one array
+	offsets.assign((size_t)columns * rows + 1, 0);
+	for (auto& point : points)
+	{
+		auto cell = CellOf(point);
+		offsets[(size_t)cell.y * columns + cell.x + 1]++;
+	}
+	for (size_t i = 1; i < offsets.size(); i++)
+		offsets[i] += offsets[i - 1];
+
+	std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+	nodes.resize(points.size());
+	for (size_t i = 0; i < points.size(); i++)
+	{
+		auto cell = CellOf(points[i]);
+		nodes[fill[(size_t)cell.y * columns + cell.x]++] = (uint32_t)i;
+	}
+}
+
+sf::Vector2i PathfindingManager::NodeGrid::CellOf(const sf::Vector2f& point) const
+{
+	if (columns == 1 && rows == 1) return sf::Vector2i(0, 0);
+	return sf::Vector2i((int)((point.x - min.x) / cellSize), (int)((point.y - min.y) / cellSize));
+}
+
+std::vector<uint32_t> PathfindingManager::NodeGrid::GetNodesNear(const sf::FloatRect& area, float distance) const
+{
+	std::vector<uint32_t> output;
+	if ((columns == 1 && rows == 1) || distance == INFINITY)
+		output = nodes;
+	else
+	{
+		int left = std::max(0, (int)floorf((area.left - distance - min.x) / cellSize));
+		int top = std::max(0, (int)floorf((area.top - distance - min.y) / cellSize));
+		int right = std::min(columns - 1, (int)floorf((area.left + area.width + distance - min.x) / cellSize));
+		int bottom = std::min(rows - 1, (int)floorf((area.top + area.height + distance - min.y) / cellSize));
+		for (int y = top; y <= bottom; y++)
+			for (int x = left; x <= right; x++)
+			{
+				size_t cell = (size_t)y * columns + x;
+				output.insert(output.end(), nodes.begin() + offsets[cell], nodes.begin() + offsets[cell + 1]);
+			}
+	}
+
+	std::sort(output.begin(), output.end());
+	return output;
+}
+
+void PathfindingManager::NodeGrid::GetNodesIn(const std::vector<sf::Vector2f>& polygon, std::vector<uint32_t>& output) const
+{
+	output.clear();
+	if (polygon.empty()) return;
+	if (columns == 1 && rows == 1)
+	{
+		output = nodes;
+		return;
+	}
+
+	//Bands are grown a bit, so nodes right on polygon border aren't lost to rounding
+	float margin = cellSize * 0.01f;
+	float top = INFINITY, bottom = -INFINITY;
+	for (auto& point : polygon)
+	{
+		top = std::min(top, point.y);
+		bottom = std::max(bottom, point.y);
+	}
+	int firstRow = std::max(0, (int)floorf((top - margin - min.y) / cellSize));
+	int lastRow = std::min(rows - 1, (int)floorf((bottom + margin - min.y) / cellSize));
+	for (int y = firstRow; y <= lastRow; y++)
+	{
+		float bandTop = min.y + y * cellSize;
+		float left, right;
+		if (!GetPolygonSpan(polygon, bandTop - margin, bandTop + cellSize + margin, left, right)) continue;
+
+		int firstColumn = std::max(0, (int)floorf((left - margin - min.x) / cellSize));
+		int lastColumn = std::min(columns - 1, (int)floorf((right + margin - min.x) / cellSize));
+		for (int x = firstColumn; x <= lastColumn; x++)
+		{
+			size_t cell = (size_t)y * columns + x;
+			output.insert(output.end(), nodes.begin() + offsets[cell], nodes.begin() + offsets[cell + 1]);
+		}
+	}
+}
+
+uint32_t PathfindingManager::StartNode() const
+{
+	return (uint32_t)_baseGraph.Size();
+}
+
+uint32_t PathfindingManager::EndNode() const
+{
+	return (uint32_t)_baseGraph.Size() + 1;
+}
+
+sf::Vector2f PathfindingManager::GetNodePos(uint32_t node) const
+{
+	if (node == StartNode()) return _search.startPos;
+	if (node == EndNode()) return _search.endPos;
+	return sf::Vector2f(_baseGraph.posX[node], _baseGraph.posY[node]);
+}
+
+std::vector<std::pair<uint32_t, float>> PathfindingManager::GetVisibleNodes(const sf::Vector2f& pos, CollisionsManager* collisions, bool rayFromPos) const
+{
+	std::vector<std::pair<uint32_t, float>> output;
+
+	for (size_t i = 0; i < _baseGraph.Size(); i++)
+	{
+		sf::Vector2f nodePos(_baseGraph.posX[i], _baseGraph.posY[i]);
+		float distance = 0;
+		bool hits = (rayFromPos) ? collisions->TileRaycastHitsPoint(pos, nodePos, &distance) : collisions->TileRaycastHitsPoint(nodePos, pos, &distance);
+		if (hits)
+			output.emplace_back((uint32_t)i, distance);
+	}
+
+	return output;
+}
+
+void PathfindingManager::BuildBaseGraph(const std::vector<sf::Vector2f>& points, std::vector<GraphLink> links)
+{
+	_baseGraph.posX.clear();
+	_baseGraph.posY.clear();
+	_baseGraph.posX.reserve(points.size());
+	_baseGraph.posY.reserve(points.size());
+	for (auto& point : points)
+	{
+		_baseGraph.posX.push_back(point.x);
+		_baseGraph.posY.push_back(point.y);
+	}
+
+	//Drop invalid links, keep last one when link is duplicated
+	size_t nodes = points.size();
+	std::vector<GraphLink> valid;
+	valid.reserve(links.size());
+	for (auto& link : links)
+	{
+		if (std::get<0>(link) >= nodes || std::get<1>(link) >= nodes || std::get<0>(link) == std::get<1>(link)) continue;
+		valid.push_back(link);
+	}
+	std::stable_sort(valid.begin(), valid.end(), [](const GraphLink& lhs, const GraphLink& rhs) {
+		if (std::get<0>(lhs) != std::get<0>(rhs)) return std::get<0>(lhs) < std::get<0>(rhs);
+		return std::get<1>(lhs) < std::get<1>(rhs);
+	});
+
+	_baseGraph.offsets.assign(nodes + 1, 0);
+	_baseGraph.neighbours.clear();
+	_baseGraph.weights.clear();
+	_baseGraph.neighbours.reserve(valid.size());
+	_baseGraph.weights.reserve(valid.size());
+	for (size_t i = 0; i < valid.size(); i++)
+	{
+		if (i + 1 < valid.size() && std::get<0>(valid[i]) == std::get<0>(valid[i + 1]) && std::get<1>(valid[i]) == std::get<1>(valid[i + 1]))
+			continue;
+
+		_baseGraph.offsets[std::get<0>(valid[i]) + 1]++;
+		_baseGraph.neighbours.push_back((uint32_t)std::get<1>(valid[i]));
+		_baseGraph.weights.push_back(std::get<2>(valid[i]));
+	}
+	for (size_t i = 0; i < nodes; i++)
+		_baseGraph.offsets[i + 1] += _baseGraph.offsets[i];
+
+	PrepareBaseGraph();
+}
+
+void PathfindingManager::PrepareBaseGraph()
+{
+	size_t nodes = _baseGraph.Size();
+
+	//Reversed links
+	_baseGraph.inOffsets.assign(nodes + 1, 0);
+	_baseGraph.inNeighbours.resize(_baseGraph.neighbours.size());
+	_baseGraph.inWeights.resize(_baseGraph.weights.size());
+	for (auto to : _baseGraph.neighbours)
+		_baseGraph.inOffsets[to + 1]++;
+	for (size_t i = 0; i < nodes; i++)
+		_baseGraph.inOffsets[i + 1] += _baseGraph.inOffsets[i];
+
+	std::vector<uint32_t> fill(_baseGraph.inOffsets.begin(), _baseGraph.inOffsets.end() - 1);
+	for (uint32_t from = 0; from < (uint32_t)nodes; from++)
+		for (auto i = _baseGraph.offsets[from]; i < _baseGraph.offsets[from + 1]; i++)
+		{
+			auto slot = fill[_baseGraph.neighbours[i]]++;
+			_baseGraph.inNeighbours[slot] = from;
+			_baseGraph.inWeights[slot] = _baseGraph.weights[i];
+		}
+
+	//About four nodes per cell
+	float cellSize = 0;
+	if (nodes > 0)
+	{
+		auto rangeX = std::minmax_element(_baseGraph.posX.begin(), _baseGraph.posX.end());
+		auto rangeY = std::minmax_element(_baseGraph.posY.begin(), _baseGraph.posY.end());
+		cellSize = 2.f * std::max(*rangeX.second - *rangeX.first, *rangeY.second - *rangeY.first) / sqrtf((float)nodes);
+	}
+	_baseGraph.grid.Build(GetBaseGraphPoints(), cellSize);
+
+	_search.Reset(nodes);
+	_search.startLinks.clear();
+	_search.endLinks.clear();
+	_search.toEnd.assign(nodes, INFINITY);
+
+	_cache.nodeOfPos.clear();
+	for (uint32_t i = (uint32_t)nodes; i > 0; i--) //First node wins on duplicated positions
+		_cache.nodeOfPos[Vector2MapKey<float>(sf::Vector2f(_baseGraph.posX[i - 1], _baseGraph.posY[i - 1]))] = i - 1;
+	ClearCaches();
+
+	ClearIncrementalTree();
+	InvalidatePathSnapshot();
+}
+
+void PathfindingManager::SpliceLinks(std::vector<uint32_t>& offsets, std::vector<uint32_t>& targets, std::vector<float>& weights, const std::map<uint32_t, std::vector<std::pair<uint32_t, float>>>& changed)
+{
+	if (changed.empty()) return;
+
+	//Lists before first changed node stay where they are
+	uint32_t nodes = (uint32_t)offsets.size() - 1;
+	uint32_t first = changed.begin()->first;
+	uint32_t start = offsets[first];
+	std::vector<uint32_t> tailTargets;
+	std::vector<float> tailWeights;
+	tailTargets.reserve(targets.size() - start);
+	tailWeights.reserve(weights.size() - start);
+
+	auto next = changed.begin();
+	uint32_t oldBegin = start;
+	for (uint32_t node = first; node < nodes; node++)
+	{
+		uint32_t oldEnd = offsets[node + 1];
+		if (next != changed.end() && next->first == node)
+		{
+			for (auto& link : next->second)
+			{
+				tailTargets.push_back(link.first);
+				tailWeights.push_back(link.second);
+			}
+			next++;
+		}
+		else
+		{
+			tailTargets.insert(tailTargets.end(), targets.begin() + oldBegin, targets.begin() + oldEnd);
+			tailWeights.insert(tailWeights.end(), weights.begin() + oldBegin, weights.begin() + oldEnd);
+		}
+		offsets[node + 1] = start + (uint32_t)tailTargets.size();
+		oldBegin = oldEnd;
+	}
+
+	targets.resize(start);
+	weights.resize(start);
+	targets.insert(targets.end(), tailTargets.begin(), tailTargets.end());
+	weights.insert(weights.end(), tailWeights.begin(), tailWeights.end());
+}
+
+std::vector<sf::Vector2f> PathfindingManager::SolveAStar(const BaseGraph& graph, SearchBuffer& search, uint32_t startNode, uint32_t endNode)
 {
 	std::vector<sf::Vector2f> output;
 
-	//Reset alghoritm vars
-	for(auto it = _baseGraph.begin();it!=_baseGraph.end();it++)
+	//Reset alghoritm vars
+	search.Reset(graph.Size());
+
+	//Temporary start and end nodes are placed right after graph nodes
+	uint32_t graphStart = (uint32_t)graph.Size();
+	uint32_t graphEnd = graphStart + 1;
+	auto nodePos = [&graph, &search, graphStart, graphEnd](uint32_t node)
+	{
+		if (node == graphStart) return search.startPos;
+		if (node == graphEnd) return search.endPos;
+		return sf::Vector2f(graph.posX[node], graph.posY[node]);
+	};
+
+	auto endPos = nodePos(endNode);
+	auto heuristic = [&nodePos, &endPos](uint32_t node)
+	{
+		return MathHelper::GetDistanceBetweenPoints(nodePos(node), endPos);
+	};
+
+	// Setup starting conditions
+	search.localGoal[startNode] = 0.0f;
+	search.globalGoal[startNode] = heuristic(startNode);
+
+	OpenSet notTestedNodes;
+	notTestedNodes.push(OpenSetEntry(search.globalGoal[startNode], startNode));
+
+	auto relax = [&search, &notTestedNodes, &heuristic](uint32_t current, uint32_t neighbour, float weight)
+	{
+		if (search.visited[neighbour]) return;
+
+		//Potential lowest parent distance
+		float fPossiblyLowerGoal = search.localGoal[current] + weight;
+
+		if (fPossiblyLowerGoal < search.localGoal[neighbour])
+		{
+			search.parent[neighbour] = current;
+			search.localGoal[neighbour] = fPossiblyLowerGoal;
+
+			search.globalGoal[neighbour] = fPossiblyLowerGoal + heuristic(neighbour);
+			notTestedNodes.push(OpenSetEntry(search.globalGoal[neighbour], neighbour));
+		}
+	};
+
+	while (!notTestedNodes.empty())
+	{
+		// Lowest global goal is always on top
+		auto top = notTestedNodes.top();
+		notTestedNodes.pop();
+
+		auto current = top.second;
+		if (search.visited[current] || top.first > search.globalGoal[current]) continue; //Stale entry
+
+		search.visited[current] = 1;
+		if (current == endNode) break;
+
+		// Check each of this node's neighbours
+		if (current == graphStart)
+		{
+			for (auto& link : search.startLinks)
+				relax(current, link.first, link.second);
+			continue;
+		}
+		if (current == graphEnd) continue;
+
+		for (auto i = graph.offsets[current]; i < graph.offsets[current + 1]; i++)
+			relax(current, graph.neighbours[i], graph.weights[i]);
+		if (search.toEnd[current] != INFINITY)
+			relax(current, graphEnd, search.toEnd[current]);
+	}
+
+	auto p = endNode;
+	while (search.parent[p] != NO_NODE)
+	{
+		output.push_back(nodePos(p));
+		p = search.parent[p];
+	}
+
+	return output;
+}
+
+Paths PathfindingManager::SolveDijkstras(uint32_t startNode)
+{
+	//Reset alghoritm vars
+	_search.Reset(_baseGraph.Size());
+
+	// Setup starting conditions
+	_search.localGoal[startNode] = 0.0f;
+	_search.globalGoal[startNode] = 0.0f;
+
+	OpenSet notTestedNodes;
+	notTestedNodes.push(OpenSetEntry(_search.globalGoal[startNode], startNode));
+
+	auto relax = [this, &notTestedNodes](uint32_t current, uint32_t neighbour, float weight)
+	{
+		if (_search.visited[neighbour]) return;
+
+		//Potential lowest parent distance
+		float fPossiblyLowerGoal = _search.localGoal[current] + weight;
+
+		if (fPossiblyLowerGoal < _search.localGoal[neighbour])
+		{
+			_search.parent[neighbour] = current;
+			_search.localGoal[neighbour] = fPossiblyLowerGoal;
+
+			_search.globalGoal[neighbour] = fPossiblyLowerGoal;
+			notTestedNodes.push(OpenSetEntry(_search.globalGoal[neighbour], neighbour));
+		}
+	};
+
+	while (!notTestedNodes.empty())
+	{
+		// Lowest global goal is always on top
+		auto top = notTestedNodes.top();
+		notTestedNodes.pop();
+
+		auto current = top.second;
+		if (_search.visited[current] || top.first > _search.globalGoal[current]) continue; //Stale entry
+
+		_search.visited[current] = 1;
+
+		// Check each of this node's neighbours
+		if (current == StartNode())
+		{
+			for (auto& link : _search.startLinks)
+				relax(current, link.first, link.second);
+			continue;
+		}
+
+		for (auto i = _baseGraph.offsets[current]; i < _baseGraph.offsets[current + 1]; i++)
+			relax(current, _baseGraph.neighbours[i], _baseGraph.weights[i]);
+	}
+
+	Paths paths;
+	for (uint32_t i = 0; i < (uint32_t)_baseGraph.Size(); i++)
+	{
+		if (_search.parent[i] == NO_NODE) paths[Vector2MapKey<float>(GetNodePos(i))] = sf::Vector2f(INFINITY, INFINITY);
+		else paths[Vector2MapKey<float>(GetNodePos(i))] = GetNodePos(_search.parent[i]);
+	}
+	if (startNode == StartNode())
+		paths[Vector2MapKey<float>(_search.startPos)] = sf::Vector2f(INFINITY, INFINITY);
+	return paths;
+}
+
+PathfindingManager::PathfindingManager()
+{
+	_lastPathRequest = 0;
+	_stopPathWorkers = false;
+	_cache.cellVisibility.SetCapacity(1024);
+
+	BuildBaseGraph(std::vector<sf::Vector2f>(), std::vector<GraphLink>());
+}
+
+PathfindingManager::~PathfindingManager()
+{
+	StopPathWorkers();
+}
+
+void PathfindingManager::GenerateBaseGraph(const std::vector<sf::Vector2f>& points, CollisionsManager* collisions)
+{
+	std::vector<GraphLink> links;
+
+	std::vector<float> distances;
+	std::vector<bool> hits;
+	for (size_t cell = 0; cell < points.size(); cell++)
+	{
+		//Rays to all points are cast together
+		collisions->RaycastHitsPoints(points[cell], points, distances, hits);
+		for (size_t neighbour = 0; neighbour < points.size(); neighbour++)
+			if (cell != neighbour && hits[neighbour])
+				links.emplace_back(cell, neighbour, distances[neighbour]);
+	}
+
+	_baseGraph.maxLinkDistance = INFINITY;
+	BuildBaseGraph(points, std::move(links));
+}
+
+void PathfindingManager::GenerateBaseGraph(const std::vector<sf::Vector2f>& points, CollisionsManager* collisions, const GraphBuildOptions& options)
+{
+	//Uniform grid with max link distance as cell size, single cell if distance is not limited
+	NodeGrid grid;
+	grid.Build(points, options.maxLinkDistance);
+
+	//Links of every node are tested separately, so nodes can be split between threads
+	std::vector<std::vector<GraphLink>> nodeLinks(points.size());
+	std::atomic<size_t> nextNode(0);
+	auto worker = [&]()
+	{
+		size_t node;
+		while ((node = nextNode++) < points.size())
+		{
+			auto cell = grid.CellOf(points[node]);
+			for (int y = cell.y - 1; y <= cell.y + 1; y++)
+				for (int x = cell.x - 1; x <= cell.x + 1; x++)
+				{
+					if (x < 0 || y < 0 || x > grid.columns - 1 || y > grid.rows - 1) continue;
+
+					size_t index = (size_t)y * grid.columns + x;
+					for (auto i = grid.offsets[index]; i < grid.offsets[index + 1]; i++)
+					{
+						auto neighbour = grid.nodes[i];
+						if (neighbour == node) continue;
+						if (MathHelper::GetDistanceBetweenPoints(points[node], points[neighbour]) > options.maxLinkDistance) continue;
+
+						float distance = 0;
+						if (collisions->TileRaycastHitsPoint(points[node], points[neighbour], &distance))
+							nodeLinks[node].emplace_back(node, (size_t)neighbour, distance);
+					}
+				}
+		}
+	};
+
+	unsigned int threads = (options.threads > 0) ? options.threads : std::thread::hardware_concurrency();
+	threads = std::max(1U, std::min(threads, (unsigned int)points.size()));
+
+	std::vector<std::thread> pool;
+	for (unsigned int i = 1; i < threads; i++)
+		pool.emplace_back(worker);
+	worker();
+	for (auto& thread : pool)
+		thread.join();
+
+	//Merge in node order
+	std::vector<GraphLink> links;
+	for (auto& l : nodeLinks)
+		links.insert(links.end(), l.begin(), l.end());
+
+	_baseGraph.maxLinkDistance = options.maxLinkDistance;
+	BuildBaseGraph(points, std::move(links));
+}
+
+void PathfindingManager::LoadBaseGraph(const std::vector<sf::Vector2f>& points, const std::vector<GraphLink>& links)
+{
+	_baseGraph.maxLinkDistance = INFINITY;
+	BuildBaseGraph(points, links);
+}
+
+bool PathfindingManager::UpdateBaseGraphLinks(const sf::FloatRect& area, CollisionsManager* collisions)
+{
+	//Segment is clipped against area slabs
+	auto crossesArea = [&](const sf::Vector2f& start, const sf::Vector2f& end)
+	{
+		float tMin = 0.f, tMax = 1.f;
+		float origin[2] = { start.x, start.y };
+		float dir[2] = { end.x - start.x, end.y - start.y };
+		float min[2] = { area.left, area.top };
+		float max[2] = { area.left + area.width, area.top + area.height };
+		for (int axis = 0; axis < 2; axis++)
+		{
+			if (dir[axis] == 0.f)
+			{
+				if (origin[axis] < min[axis] || origin[axis] > max[axis]) return false;
+				continue;
+			}
+			float t1 = (min[axis] - origin[axis]) / dir[axis];
+			float t2 = (max[axis] - origin[axis]) / dir[axis];
+			tMin = std::max(tMin, std::min(t1, t2));
+			tMax = std::min(tMax, std::max(t1, t2));
+			if (tMin > tMax) return false;
+		}
+		return true;
+	};
+
+	if (_baseGraph.Size() == 0) return false;
+	auto byNeighbour = [](const std::pair<uint32_t, float>& lhs, const std::pair<uint32_t, float>& rhs) { return lhs.first < rhs.first; };
+
+	//Link crossing area is never longer than max link distance, so both of its nodes are near area
+	auto candidates = _baseGraph.grid.GetNodesNear(area, _baseGraph.maxLinkDistance);
+
+	auto& grid = _baseGraph.grid;
+	sf::Vector2f corners[4] = { sf::Vector2f(area.left, area.top), sf::Vector2f(area.left + area.width, area.top),
+		sf::Vector2f(area.left + area.width, area.top + area.height), sf::Vector2f(area.left, area.top + area.height) };
+	auto cross = [](const sf::Vector2f& lhs, const sf::Vector2f& rhs) { return lhs.x * rhs.y - lhs.y * rhs.x; };
+
+	//Old and new links crossing area are compared per node, in neighbour order
+	std::map<uint32_t, std::vector<std::pair<uint32_t, float>>> changed;
+	std::vector<std::pair<uint32_t, float>> before, after;
+	std::vector<uint32_t> shadowNodes;
+	for (auto node : candidates)
+	{
+		auto pos = GetNodePos(node);
+
+		//Segment from outside node crosses area only if it ends in shadow of area, wedge between outermost corners
+		bool outside = pos.x < area.left || pos.x > area.left + area.width || pos.y < area.top || pos.y > area.top + area.height;
+		if (outside)
+		{
+			auto reach = (_baseGraph.maxLinkDistance != INFINITY) ? sf::Vector2f(_baseGraph.maxLinkDistance, _baseGraph.maxLinkDistance) : grid.max - grid.min;
+			sf::Vector2f min(std::max(grid.min.x, pos.x - reach.x), std::max(grid.min.y, pos.y - reach.y));
+			sf::Vector2f max(std::min(grid.max.x, pos.x + reach.x), std::min(grid.max.y, pos.y + reach.y));
+			std::vector<sf::Vector2f> shadow = { min, sf::Vector2f(max.x, min.y), max, sf::Vector2f(min.x, max.y) };
+			for (auto& corner : corners)
+			{
+				bool first = true, last = true;
+				for (auto& other : corners)
+				{
+					float side = cross(corner - pos, other - pos);
+					first = first && side >= 0;
+					last = last && side <= 0;
+				}
+				if (first) shadow = ClipPolygon(shadow, pos, corner - pos);
+				if (last) shadow = ClipPolygon(shadow, pos, pos - corner);
+			}
+			grid.GetNodesIn(shadow, shadowNodes);
+		}
+		else
+			shadowNodes = grid.nodes;
+
+		before.clear();
+		after.clear();
+		auto first = _baseGraph.neighbours.begin() + _baseGraph.offsets[node];
+		auto last = _baseGraph.neighbours.begin() + _baseGraph.offsets[node + 1];
+		for (auto neighbour : shadowNodes)
+		{
+			auto neighbourPos = GetNodePos(neighbour);
+			if (neighbour == node || crossesArea(pos, neighbourPos) == false) continue;
+
+			auto found = std::lower_bound(first, last, neighbour);
+			if (found != last && *found == neighbour)
+				before.emplace_back(neighbour, _baseGraph.weights[found - _baseGraph.neighbours.begin()]);
+
+			if (MathHelper::GetDistanceBetweenPoints(pos, neighbourPos) > _baseGraph.maxLinkDistance) continue;
+
+			float distance = 0;
+			if (collisions->TileRaycastHitsPoint(pos, neighbourPos, &distance))
+				after.emplace_back(neighbour, distance);
+		}
+
+		std::sort(before.begin(), before.end(), byNeighbour);
+		std::sort(after.begin(), after.end(), byNeighbour);
+		if (before == after) continue;
+
+		//Links outside area are kept
+		auto& links = changed[node];
+		for (auto i = _baseGraph.offsets[node]; i < _baseGraph.offsets[node + 1]; i++)
+			if (crossesArea(pos, GetNodePos(_baseGraph.neighbours[i])) == false)
+				links.emplace_back(_baseGraph.neighbours[i], _baseGraph.weights[i]);
+		links.insert(links.end(), after.begin(), after.end());
+		std::sort(links.begin(), links.end(), byNeighbour);
+	}
+	if (changed.empty()) return false;
+
+	//Reversed lists of nodes linked before or after change, ordered by source like in full build
+	std::map<uint32_t, std::vector<std::pair<uint32_t, float>>> changedIn;
+	for (auto& node : changed)
+		for (auto i = _baseGraph.offsets[node.first]; i < _baseGraph.offsets[node.first + 1]; i++)
+			changedIn[_baseGraph.neighbours[i]];
+	for (auto& node : changed)
+		for (auto& link : node.second)
+			changedIn[link.first].emplace_back(node.first, link.second);
+	for (auto& node : changedIn)
+	{
+		auto& links = node.second;
+		for (auto i = _baseGraph.inOffsets[node.first]; i < _baseGraph.inOffsets[node.first + 1]; i++)
+			if (changed.find(_baseGraph.inNeighbours[i]) == changed.end())
+				links.emplace_back(_baseGraph.inNeighbours[i], _baseGraph.inWeights[i]);
+		std::sort(links.begin(), links.end(), byNeighbour);
+	}
+
+	SpliceLinks(_baseGraph.offsets, _baseGraph.neighbours, _baseGraph.weights, changed);
+	SpliceLinks(_baseGraph.inOffsets, _baseGraph.inNeighbours, _baseGraph.inWeights, changedIn);
+
+	//Node positions didn't change, so search buffers and node lookup stay valid
+	ClearCaches();
+	ClearIncrementalTree();
+	InvalidatePathSnapshot();
+	return true;
+}
+
+std::vector<GraphLink> PathfindingManager::GetBaseGraphLinks() const
+{
+	std::vector<GraphLink> output;
+	output.reserve(_baseGraph.neighbours.size());
+
+	for (size_t cell = 0; cell < _baseGraph.Size(); cell++)
+		for (auto i = _baseGraph.offsets[cell]; i < _baseGraph.offsets[cell + 1]; i++)
+			output.emplace_back(cell, (size_t)_baseGraph.neighbours[i], _baseGraph.weights[i]);
+
+	return output;
+}
+
+std::vector<sf::Vector2f> PathfindingManager::GetBaseGraphPoints() const
+{
+	std::vector<sf::Vector2f> output;
+	output.reserve(_baseGraph.Size());
+	for (size_t i = 0; i < _baseGraph.Size(); i++)
+		output.emplace_back(_baseGraph.posX[i], _baseGraph.posY[i]);
+	return output;
+}
+
+uint64_t PathfindingManager::GetBaseGraphHash(const MapLayerModel<bool>* tiles, const std::vector<sf::Vector2f>& points)
+{
+	//FNV-1a
+	uint64_t hash = 14695981039346656037ULL;
+	auto add = [&hash](const void* data, size_t size)
+	{
+		auto bytes = (const unsigned char*)data;
+		for (size_t i = 0; i < size; i++)
+		{
+			hash ^= bytes[i];
+			hash *= 1099511628211ULL;
+		}
+	};
+
+	add(&GRAPH_FILE_VERSION, sizeof(GRAPH_FILE_VERSION));
+	add(&tiles->width, sizeof(tiles->width));
+	add(&tiles->height, sizeof(tiles->height));
+	add(&tiles->tileWidth, sizeof(tiles->tileWidth));
+	add(&tiles->tileHeight, sizeof(tiles->tileHeight));
+	add(&tiles->offsetX, sizeof(tiles->offsetX));
+	add(&tiles->offsetY, sizeof(tiles->offsetY));
+	for (size_t i = 0; i < tiles->data.size(); i++)
+	{
+		unsigned char blocked = (tiles->data[i]) ? 1 : 0;
+		add(&blocked, 1);
+	}
+	for (auto& point : points)
+	{
+		add(&point.x, sizeof(point.x));
+		add(&point.y, sizeof(point.y));
+	}
+
+	return hash;
+}
+
+bool PathfindingManager::SaveBaseGraphToFile(const std::string& path, uint64_t hash) const
+{
+	std::ofstream output;
+	output.open(path, std::ios::out | std::ios::binary | std::ios::trunc);
+	if (!output.is_open() || !output.good())
+	{
+		Logger::GetInstance()->Log(Logger::LogType::ERROR, "Unable to save pathfinding graph to \"" + path + "\"");
+		return false;
+	}
+
+	uint32_t header[4] = { GRAPH_FILE_MAGIC, GRAPH_FILE_VERSION, (uint32_t)_baseGraph.Size(), (uint32_t)_baseGraph.neighbours.size() };
+	output.write((const char*)header, sizeof(header));
+	output.write((const char*)&hash, sizeof(hash));
+	output.write((const char*)_baseGraph.posX.data(), _baseGraph.posX.size() * sizeof(float));
+	output.write((const char*)_baseGraph.posY.data(), _baseGraph.posY.size() * sizeof(float));
+	output.write((const char*)_baseGraph.offsets.data(), _baseGraph.offsets.size() * sizeof(uint32_t));
+	output.write((const char*)_baseGraph.neighbours.data(), _baseGraph.neighbours.size() * sizeof(uint32_t));
+	output.write((const char*)_baseGraph.weights.data(), _baseGraph.weights.size() * sizeof(float));
+
+	bool good = output.good();
+	output.close();
+	return good;
+}
+
+bool PathfindingManager::LoadBaseGraphFromFile(const std::string& path, uint64_t hash)
+{
+	std::ifstream input;
+	input.open(path, std::ios::in | std::ios::binary);
+	if (!input.is_open() || !input.good())
+		return false;
+
+	uint32_t header[4] = { 0, 0, 0, 0 };
+	uint64_t fileHash = 0;
+	input.read((char*)header, sizeof(header));
+	input.read((char*)&fileHash, sizeof(fileHash));
+	if (!input.good() || header[0] != GRAPH_FILE_MAGIC || header[1] != GRAPH_FILE_VERSION || fileHash != hash)
+		return false;
+
+	//Check size before allocating anything
+	size_t nodes = header[2];
+	size_t links = header[3];
+	auto dataStart = input.tellg();
+	input.seekg(0, std::ios::end);
+	auto dataSize = (size_t)(input.tellg() - dataStart);
+	input.seekg(dataStart);
+	if (dataSize != nodes * 2 * sizeof(float) + (nodes + 1) * sizeof(uint32_t) + links * (sizeof(uint32_t) + sizeof(float)))
+	{
+		Logger::GetInstance()->Log(Logger::LogType::WARNING, "Corrupted pathfinding graph file \"" + path + "\"");
+		return false;
+	}
+
+	//Arrays are read straight into graph storage
+	BaseGraph graph;
+	graph.posX.resize(nodes);
+	graph.posY.resize(nodes);
+	graph.offsets.resize(nodes + 1);
+	graph.neighbours.resize(links);
+	graph.weights.resize(links);
+	input.read((char*)graph.posX.data(), nodes * sizeof(float));
+	input.read((char*)graph.posY.data(), nodes * sizeof(float));
+	input.read((char*)graph.offsets.data(), (nodes + 1) * sizeof(uint32_t));
+	input.read((char*)graph.neighbours.data(), links * sizeof(uint32_t));
+	input.read((char*)graph.weights.data(), links * sizeof(float));
+	input.close();
+
+	bool valid = !input.fail() && graph.offsets[0] == 0 && graph.offsets[nodes] == links;
+	for (size_t i = 0; i < nodes && valid; i++)
+		valid = graph.offsets[i] <= graph.offsets[i + 1];
+	for (size_t i = 0; i < links && valid; i++)
+		valid = graph.neighbours[i] < nodes;
+	for (size_t i = 0; i < nodes && valid; i++) //Links of node are sorted, so they can be binary searched
+		for (auto j = graph.offsets[i] + 1; j < graph.offsets[i + 1] && valid; j++)
+			valid = graph.neighbours[j - 1] < graph.neighbours[j];
+	if (!valid)
+	{
+		Logger::GetInstance()->Log(Logger::LogType::WARNING, "Corrupted pathfinding graph file \"" + path + "\"");
+		return false;
+	}
+
+	_baseGraph = std::move(graph);
+	PrepareBaseGraph();
+	return true;
+}
+
+size_t PathfindingManager::GetBaseGraphSize() const
+{
+	return _baseGraph.Size();
+}
+
+std::list<sf::Vector2f> PathfindingManager::GetNodesInSight(const sf::Vector2f& start, CollisionsManager* collisions)
+{
+	std::list<sf::Vector2f> output;
+
+	for (auto& node : GetVisibleNodes(start, collisions, true))
+		output.push_back(GetNodePos(node.first));
+	
+	return output;
+}
+
+std::vector<sf::Vector2f> PathfindingManager::GetAStarPath(const sf::Vector2f& startPos, const sf::Vector2f& endPos, CollisionsManager* collisions)
+{
+	_search.startPos = startPos;
+	_search.endPos = endPos;
+
+	//Connect temporary nodes with graph
+	_search.startLinks = GetVisibleNodes(startPos, collisions, true);
+	_search.endLinks = GetVisibleNodes(endPos, collisions, true);
+	for (auto& link : _search.endLinks)
+		_search.toEnd[link.first] = link.second;
+
+	auto output = SolveAStar(_baseGraph, _search, StartNode(), EndNode());
+
+	//Clean
+	for (auto& link : _search.endLinks)
+		_search.toEnd[link.first] = INFINITY;
+	_search.startLinks.clear();
+	_search.endLinks.clear();
+
+	return output;
+}
+
+Paths PathfindingManager::GetDijkstrasPath(const sf::Vector2f& startPos, CollisionsManager* collisions)
+{
+	_search.startPos = startPos;
+
+	//Check connections with other nodes
+	_search.startLinks = GetVisibleNodes(startPos, collisions, false);
+
+	//Solve
+	auto output = SolveDijkstras(StartNode());
+
+	//Clean
+	_search.startLinks.clear();
+
+	return output;
+}
+
+Paths PathfindingManager::GetDijkstrasPath(size_t startNode)
+{
+	if (startNode >= _baseGraph.Size())
+		return Paths();
+
+	return SolveDijkstras((uint32_t)startNode);
+}
+
+sf::Vector2f PathfindingManager::GetClosestNode(const Paths& paths, const sf::Vector2f& startPos, CollisionsManager* collisions)
+{
+	std::list<std::tuple<sf::Vector2f, float>> nodesDistances;
+	for (auto &p : paths)
+	{
+		std::tuple<sf::Vector2f, float> t(p.first, MathHelper::GetDistanceBetweenPoints(startPos, p.first));
+		nodesDistances.push_back(t);
+	}
+
+	//Sort to make closest ones first
+	auto sort = [](std::tuple<sf::Vector2f, float> first, std::tuple<sf::Vector2f, float> second)
+	{
+		return std::get<1>(first) < std::get<1>(second);
+	};
+	nodesDistances.sort(sort);
+
+	return GetFirstVisibleNode(nodesDistances, startPos, collisions);
+}
+
+sf::Vector2f PathfindingManager::GetClosestVisibleNodeTo(const Paths& paths, const sf::Vector2f& startPos, const sf::Vector2f& endPos, CollisionsManager* collisions)
+{
+	std::list<std::tuple<sf::Vector2f, float>> nodesDistances;
+	for (auto& p : paths)
 	{
-		it->visited = false;
-		it->globalGoal = INFINITY;
-		it->localGoal = INFINITY;
-		it->parent = nullptr;
+		if (p.second.x == INFINITY) continue;
+		std::tuple<sf::Vector2f, float> t(p.first, MathHelper::GetDistanceBetweenPoints(endPos, p.first));
+		nodesDistances.push_back(t);
 	}
 
-	auto heuristic = [](Cell* a, Cell* b)
+	//Sort to make closest ones first
+	auto sort = [](std::tuple<sf::Vector2f, float> first, std::tuple<sf::Vector2f, float> second)
 	{
-		return MathHelper::GetDistanceBetweenPoints(a->pos, b->pos);
+		return std::get<1>(first) < std::get<1>(second);
 	};
+	nodesDistances.sort(sort);
 
-	// Setup starting conditions
-	Cell* currentCell = startCell;
-	startCell->localGoal = 0.0f;
-	startCell->globalGoal = heuristic(startCell, endCell);
+	return GetFirstVisibleNode(nodesDistances, startPos, collisions);
+}
 
-	std::list<Cell*> listNotTestedNodes;
-	listNotTestedNodes.push_back(startCell);
+void PathfindingManager::ValidateCache(const CollisionsManager* collisions)
+{
+	if (_cache.collisions == collisions && _cache.collisionsVersion == collisions->GetVersion()) return;
+
+	ClearCaches();
+	_cache.collisions = collisions;
+	_cache.collisionsVersion = collisions->GetVersion();
+}
+
+std::vector<uint8_t>* PathfindingManager::GetCellVisibility(const sf::Vector2f& pos, CollisionsManager* collisions, sf::FloatRect& cell)
+{
+	ValidateCache(collisions);
+
+	auto tiles = collisions->GetCommonMap();
+	if (_baseGraph.Size() == 0 || tiles->tileWidth == 0 || tiles->tileHeight == 0 || _cache.cellVisibility.GetCapacity() == 0)
+		return nullptr;
+
+	int x = (int)floorf((pos.x - tiles->offsetX) / (float)tiles->tileWidth);
+	int y = (int)floorf((pos.y - tiles->offsetY) / (float)tiles->tileHeight);
+	if (IsTileFree(tiles, x, y) == false) return nullptr; //Rays from walls don't follow shadows
+
+	uint64_t key = ((uint64_t)(uint32_t)y << 32) | (uint64_t)(uint32_t)x;
+	cell = sf::FloatRect((float)x * (float)tiles->tileWidth + tiles->offsetX, (float)y * (float)tiles->tileHeight + tiles->offsetY, (float)tiles->tileWidth, (float)tiles->tileHeight);
 
-	while (!listNotTestedNodes.empty())
+	auto found = _cache.cellVisibility.Get(key);
+	if (found != nullptr && found->size() == _baseGraph.Size())
 	{
-		// Sort Untested nodes by global goal, so lowest is first
-		listNotTestedNodes.sort([](const Cell* lhs, const Cell* rhs) { return lhs->globalGoal < rhs->globalGoal; });
+		_cacheStats.visibilityHits++;
+		return found;
+	}
+	_cacheStats.visibilityMisses++;
 
-		while (!listNotTestedNodes.empty() && listNotTestedNodes.front()->visited)
-			listNotTestedNodes.pop_front();
+	return _cache.cellVisibility.Put(key, std::vector<uint8_t>(_baseGraph.Size(), CELL_NODE_UNKNOWN));
+}
 
-		if (listNotTestedNodes.empty())
-			break;
+bool PathfindingManager::IsNodeHiddenFromCell(uint32_t node, const sf::FloatRect& cell, const MapLayerModel<bool>* tiles) const
+{
+	sf::Vector2f nodePos(_baseGraph.posX[node], _baseGraph.posY[node]);
+	sf::Vector2f corners[4] = {
+		sf::Vector2f(cell.left, cell.top), sf::Vector2f(cell.left + cell.width, cell.top),
+		sf::Vector2f(cell.left, cell.top + cell.height), sf::Vector2f(cell.left + cell.width, cell.top + cell.height) };
 
-		currentCell = listNotTestedNodes.front();
-		currentCell->visited = true;
+	//Shadow of convex wall is convex, so cell is in it when all corners are
+	auto shadows = [&](int left, int top, int right, int bottom) -> bool
+	{
+		sf::FloatRect wall((float)left * (float)tiles->tileWidth + tiles->offsetX + SHADOW_MARGIN, (float)top * (float)tiles->tileHeight + tiles->offsetY + SHADOW_MARGIN,
+						   (float)(right - left + 1) * (float)tiles->tileWidth - 2.f * SHADOW_MARGIN, (float)(bottom - top + 1) * (float)tiles->tileHeight - 2.f * SHADOW_MARGIN);
+		for (auto& corner : corners)
+			if (SegmentCrossesRect(corner, nodePos, wall) == false)
+				return false;
+		return true;
+	};
 
+	//Wall runs through tiles under segment from cell center, quarter tile steps
+	sf::Vector2f center(cell.left + cell.width / 2.f, cell.top + cell.height / 2.f);
+	float step = std::min((float)tiles->tileWidth, (float)tiles->tileHeight) / 4.f;
+	int steps = (int)ceilf(MathHelper::GetDistanceBetweenPoints(center, nodePos) / step);
+	int lastX = INT_MIN, lastY = INT_MIN;
+	for (int i = 1; i < steps; i++)
+	{
+		auto point = center + (nodePos - center) * ((float)i / (float)steps);
+		int x = (int)floorf((point.x - tiles->offsetX) / (float)tiles->tileWidth);
+		int y = (int)floorf((point.y - tiles->offsetY) / (float)tiles->tileHeight);
+		if ((x == lastX && y == lastY) || IsTileFree(tiles, x, y)) continue;
+		lastX = x;
+		lastY = y;
+		if (x < 0 || y < 0 || x >= (int)tiles->width || y >= (int)tiles->height) continue;
 
-		// Check each of this node's neighbours
-		for (auto& nodeNeighbour : currentCell->neighbours)
-		{
-			if (!nodeNeighbour.first->visited)
-				listNotTestedNodes.push_back(nodeNeighbour.first);
+		int left = x, right = x, top = y, bottom = y;
+		while (IsTileFree(tiles, left - 1, y) == false && left > 0) left--;
+		while (IsTileFree(tiles, right + 1, y) == false && right < (int)tiles->width - 1) right++;
+		if (shadows(left, y, right, y)) return true;
 
-			//Potential lowest parent distance
-			float fPossiblyLowerGoal = currentCell->localGoal + nodeNeighbour.second;
+		while (IsTileFree(tiles, x, top - 1) == false && top > 0) top--;
+		while (IsTileFree(tiles, x, bottom + 1) == false && bottom < (int)tiles->height - 1) bottom++;
+		if (shadows(x, top, x, bottom)) return true;
+	}
+	return false;
+}
 
-			if (fPossiblyLowerGoal < nodeNeighbour.first->localGoal)
-			{
-				nodeNeighbour.first->parent = currentCell;
-				nodeNeighbour.first->localGoal = fPossiblyLowerGoal;
+sf::Vector2f PathfindingManager::GetFirstVisibleNode(const std::list<std::tuple<sf::Vector2f, float>>& sortedNodes, const sf::Vector2f& startPos, CollisionsManager* collisions)
+{
+	sf::FloatRect cell;
+	auto visibility = GetCellVisibility(startPos, collisions, cell);
 
-				nodeNeighbour.first->globalGoal = nodeNeighbour.first->localGoal + heuristic(nodeNeighbour.first, endCell);
+	//Every node gets real raycast, cache only skips nodes proven hidden from whole start cell
+	for (auto& p : sortedNodes)
+	{
+		uint8_t* state = nullptr;
+		uint32_t node = NO_NODE;
+		if (visibility != nullptr)
+		{
+			auto found = _cache.nodeOfPos.find(Vector2MapKey<float>(std::get<0>(p)));
+			if (found != _cache.nodeOfPos.end())
+			{
+				node = found->second;
+				state = &(*visibility)[node];
+				if (*state == CELL_NODE_HIDDEN) continue;
 			}
 		}
+
+		float distance = 0.f;
+		if (collisions->TileRaycastHitsPoint(startPos, std::get<0>(p), &distance))
+		{
+			if (state != nullptr) *state = CELL_NODE_SEEN;
+			return std::get<0>(p);
+		}
+
+		//Only nodes walked by queries are classified
+		if (state != nullptr && *state == CELL_NODE_UNKNOWN)
+			*state = IsNodeHiddenFromCell(node, cell, collisions->GetCommonMap()) ? CELL_NODE_HIDDEN : CELL_NODE_SEEN;
 	}
 
-	Cell* p = endCell;
-	while (p->parent != nullptr)
+	return sf::Vector2f(INFINITY, INFINITY);
+}
+
+void PathfindingManager::SetVisibilityCacheCapacity(size_t capacity)
+{
+	_cache.cellVisibility.SetCapacity(capacity);
+}
+
+void PathfindingManager::ClearCaches()
+{
+	_cache.cellVisibility.Clear();
+}
+
+const PathfindingManager::CacheStats& PathfindingManager::GetCacheStats() const
+{
+	return _cacheStats;
+}
+
+void PathfindingManager::ResetCacheStats()
+{
+	_cacheStats = CacheStats();
+}
+
+std::vector<std::pair<uint32_t, float>> PathfindingManager::GetSnapshotVisibleNodes(const PathSnapshot& snapshot, const sf::Vector2f& pos)
+{
+	std::vector<std::pair<uint32_t, float>> output;
+
+	//Same test as GetVisibleNodes, on copies taken with snapshot
+	for (size_t i = 0; i < snapshot.graph.Size(); i++)
 	{
-		output.push_back(p->pos);
-		p = p->parent;
+		sf::Vector2f nodePos(snapshot.graph.posX[i], snapshot.graph.posY[i]);
+		float distance = 0;
+		if (CollisionsManager::TileRaycastHitsPoint(snapshot.tiles, snapshot.edgesGrid, pos, nodePos, &distance))
+			output.emplace_back((uint32_t)i, distance);
 	}
 
 	return output;
 }
 
-Paths PathfindingManager::SolveDijkstras(Cell* startCell)
+std::vector<sf::Vector2f> PathfindingManager::SolveSnapshotPath(const PathSnapshot& snapshot, SearchBuffer& search, const sf::Vector2f& startPos, const sf::Vector2f& endPos)
 {
-	std::vector<sf::Vector2f> output;
+	auto nodes = snapshot.graph.Size();
+	if (search.toEnd.size() != nodes)
+		search.toEnd.assign(nodes, INFINITY);
 
-	//Reset alghoritm vars
-	for (auto it = _baseGraph.begin(); it != _baseGraph.end(); it++)
-	{
-		it->visited = false;
-		it->globalGoal = INFINITY;
-		it->localGoal = INFINITY;
-		it->parent = nullptr;
-	}
+	search.startPos = startPos;
+	search.endPos = endPos;
+	search.startLinks = GetSnapshotVisibleNodes(snapshot, startPos);
+	search.endLinks = GetSnapshotVisibleNodes(snapshot, endPos);
+	for (auto& link : search.endLinks)
+		search.toEnd[link.first] = link.second;
 
-	// Setup starting conditions
-	Cell* currentCell = startCell;
-	startCell->localGoal = 0.0f;
-	startCell->globalGoal = 0.0f;
+	auto output = SolveAStar(snapshot.graph, search, (uint32_t)nodes, (uint32_t)nodes + 1);
 
-	std::list<Cell*> listNotTestedNodes;
-	listNotTestedNodes.push_back(startCell);
+	for (auto& link : search.endLinks)
+		search.toEnd[link.first] = INFINITY;
+	return output;
+}
 
-	while (!listNotTestedNodes.empty())
+void PathfindingManager::PathWorkerLoop()
+{
+	SearchBuffer search;
+	while (true)
 	{
-		// Sort Untested nodes by global goal, so lowest is first
-		listNotTestedNodes.sort([](const Cell* lhs, const Cell* rhs) { return lhs->globalGoal < rhs->globalGoal; });
+		PathRequest request;
+		{
+			std::unique_lock<std::mutex> lock(_pathMutex);
+			_pathCondition.wait(lock, [this]() { return _stopPathWorkers || !_pathRequests.empty(); });
+			if (_stopPathWorkers) return;
 
-		while (!listNotTestedNodes.empty() && listNotTestedNodes.front()->visited)
-			listNotTestedNodes.pop_front();
+			request = std::move(_pathRequests.front());
+			_pathRequests.pop_front();
+			_runningRequests.insert(request.handle);
+		}
 
-		if (listNotTestedNodes.empty())
-			break;
+		auto output = SolveSnapshotPath(*request.snapshot, search, request.startPos, request.endPos);
 
-		currentCell = listNotTestedNodes.front();
-		currentCell->visited = true;
+		std::lock_guard<std::mutex> lock(_pathMutex);
+		_runningRequests.erase(request.handle);
+		if (_cancelledRequests.erase(request.handle) == 0)
+			_pathResults[request.handle] = std::move(output);
+	}
+}
 
-		// Check each of this node's neighbours
-		for (auto nodeNeighbour : currentCell->neighbours)
-		{
-			if (!nodeNeighbour.first->visited)
-				listNotTestedNodes.push_back(nodeNeighbour.first);
+void PathfindingManager::StartPathWorkers(unsigned int threads)
+{
+	if (_pathWorkers.size() > 0) return;
 
-			//Potential lowest parent distance
-			float fPossiblyLowerGoal = currentCell->localGoal + nodeNeighbour.second;
+	if (threads == 0)
+		threads = std::max(std::thread::hardware_concurrency(), 2U) - 1;
 
-			if (fPossiblyLowerGoal < nodeNeighbour.first->localGoal)
-			{
-				nodeNeighbour.first->parent = currentCell;
-				nodeNeighbour.first->localGoal = fPossiblyLowerGoal;
+	_stopPathWorkers = false;
+	for (unsigned int i = 0; i < threads; i++)
+		_pathWorkers.emplace_back(&PathfindingManager::PathWorkerLoop, this);
+}
 
-				nodeNeighbour.first->globalGoal = nodeNeighbour.first->localGoal;
-			}
-		}
+void PathfindingManager::StopPathWorkers()
+{
+	{
+		std::lock_guard<std::mutex> lock(_pathMutex);
+		_stopPathWorkers = true;
 	}
+	_pathCondition.notify_all();
+	for (auto& worker : _pathWorkers)
+		worker.join();
+	_pathWorkers.clear();
+
+	//Unfinished requests are dropped
+	_pathRequests.clear();
+	_runningRequests.clear();
+	_cancelledRequests.clear();
+	_pathResults.clear();
+}
 
-	Paths paths;	
-	for (auto it = _baseGraph.begin(); it != _baseGraph.end(); it++)
+void PathfindingManager::InvalidatePathSnapshot()
+{
+	//Workers keep their own reference to old snapshot
+	_pathSnapshot.reset();
+}
+
+PathRequestHandle PathfindingManager::RequestPath(const sf::Vector2f& startPos, const sf::Vector2f& endPos, CollisionsManager* collisions)
+{
+	StartPathWorkers();
+
+	if (_pathSnapshot == nullptr || _pathSnapshot->collisions != collisions || _pathSnapshot->collisionsVersion != collisions->GetVersion())
 	{
-		if (it->parent == nullptr) paths[Vector2MapKey<float>(it->pos)] = sf::Vector2f(INFINITY, INFINITY);
-		else paths[Vector2MapKey<float>(it->pos)] = it->parent->pos;
+		auto snapshot = std::make_shared<PathSnapshot>();
+		snapshot->graph = _baseGraph;
+		snapshot->tiles = *collisions->GetCommonMap();
+		snapshot->edgesGrid = *collisions->GetEdgesGrid();
+		snapshot->collisions = collisions;
+		snapshot->collisionsVersion = collisions->GetVersion();
+		_pathSnapshot = snapshot;
 	}
-	return paths;
+
+	PathRequest request;
+	request.handle = ++_lastPathRequest;
+	if (request.handle == 0) request.handle = ++_lastPathRequest;
+	request.startPos = startPos;
+	request.endPos = endPos;
+	request.snapshot = _pathSnapshot;
+
+	auto handle = request.handle;
+	{
+		std::lock_guard<std::mutex> lock(_pathMutex);
+		_pathRequests.push_back(std::move(request));
+	}
+	_pathCondition.notify_one();
+	return handle;
 }
 
-PathfindingManager::PathfindingManager()
+bool PathfindingManager::TryGetPathResult(PathRequestHandle handle, std::vector<sf::Vector2f>& output)
 {
-	_baseGraph.clear();
+	std::lock_guard<std::mutex> lock(_pathMutex);
+	auto found = _pathResults.find(handle);
+	if (found == _pathResults.end()) return false;
+
+	output = std::move(found->second);
+	_pathResults.erase(found);
+	return true;
 }
 
-void PathfindingManager::GenerateBaseGraph(const std::vector<sf::Vector2f>& points, CollisionsManager* collisions)
+void PathfindingManager::CancelPathRequest(PathRequestHandle handle)
 {
-	_baseGraph.clear();
-
-	for (auto& point : points)
+	std::lock_guard<std::mutex> lock(_pathMutex);
+	if (_pathResults.erase(handle) > 0) return;
+	if (_runningRequests.count(handle) > 0)
 	{
-		Cell c;
-		c.visited = false;
-		c.pos = point;
-		c.parent = nullptr;
-		c.globalGoal = INFINITY;
-		c.localGoal = INFINITY;
-		c.neighbours.clear();
-		_baseGraph.push_back(c);
+		_cancelledRequests.insert(handle);
+		return;
 	}
 
-	for (auto cell = _baseGraph.begin(); cell != _baseGraph.end(); cell++)
+	auto found = std::find_if(_pathRequests.begin(), _pathRequests.end(), [handle](const PathRequest& request) { return request.handle == handle; });
+	if (found != _pathRequests.end())
+		_pathRequests.erase(found);
+}
+
+size_t PathfindingManager::GetPendingPathRequests()
+{
+	std::lock_guard<std::mutex> lock(_pathMutex);
+	return _pathRequests.size() + _runningRequests.size();
+}
+
+bool PathfindingManager::IsTileFree(const MapLayerModel<bool>* tiles, int x, int y) const
+{
+	if (x < 0 || y < 0 || x > (int)tiles->width - 1 || y > (int)tiles->height - 1) return false;
+	return !tiles->data[(size_t)y * tiles->width + x];
+}
+
+bool PathfindingManager::JumpStraight(const MapLayerModel<bool>* tiles, int& x, int& y, int dx, int dy, int endX, int endY) const
+{
+	while (true)
 	{
-		for (auto neighbour = _baseGraph.begin(); neighbour != _baseGraph.end(); neighbour++)
-		{
-			if (cell == neighbour) continue;
+		x += dx;
+		y += dy;
+		if (!IsTileFree(tiles, x, y)) return false;
+		if (x == endX && y == endY) return true;
 
-			float distance = 0;
-			if (collisions->RaycastHitsPoint(cell->pos, neighbour->pos, &distance))
-				cell->neighbours[&(*neighbour)] = distance;
+		//Forced neighbours, diagonals can't cut corners so side openings matter
+		if (dx != 0)
+		{
+			if ((IsTileFree(tiles, x, y - 1) && !IsTileFree(tiles, x - dx, y - 1)) ||
+				(IsTileFree(tiles, x, y + 1) && !IsTileFree(tiles, x - dx, y + 1)))
+				return true;
+		}
+		else
+		{
+			if ((IsTileFree(tiles, x - 1, y) && !IsTileFree(tiles, x - 1, y - dy)) ||
+				(IsTileFree(tiles, x + 1, y) && !IsTileFree(tiles, x + 1, y - dy)))
+				return true;
 		}
 	}
 }
 
-std::list<sf::Vector2f> PathfindingManager::GetNodesInSight(const sf::Vector2f& start, CollisionsManager* collisions)
+bool PathfindingManager::Jump(const MapLayerModel<bool>* tiles, int& x, int& y, int dx, int dy, int endX, int endY) const
 {
-	std::list<sf::Vector2f> output;
+	if (dx == 0 || dy == 0)
+		return JumpStraight(tiles, x, y, dx, dy, endX, endY);
 
-	for (auto cell = _baseGraph.begin(); cell != _baseGraph.end(); cell++)
+	while (true)
 	{
-		float distance = 0;
-		if (collisions->RaycastHitsPoint(start, cell->pos, &distance))
-			output.push_back(cell->pos);
+		//No corner cutting
+		if (!IsTileFree(tiles, x + dx, y) || !IsTileFree(tiles, x, y + dy)) return false;
+
+		x += dx;
+		y += dy;
+		if (!IsTileFree(tiles, x, y)) return false;
+		if (x == endX && y == endY) return true;
+
+		//Jump point if any straight jump finds something
+		int sx = x, sy = y;
+		if (JumpStraight(tiles, sx, sy, dx, 0, endX, endY)) return true;
+		sx = x; sy = y;
+		if (JumpStraight(tiles, sx, sy, 0, dy, endX, endY)) return true;
 	}
-	
-	return output;
 }
 
-std::vector<sf::Vector2f> PathfindingManager::GetAStarPath(const sf::Vector2f& startPos, const sf::Vector2f& endPos, CollisionsManager* collisions)
+std::vector<sf::Vector2f> PathfindingManager::GetJPSPath(const sf::Vector2f& startPos, const sf::Vector2f& endPos, CollisionsManager* collisions, float clearance, size_t* expandedTiles)
 {
-	Cell start, end;
+	std::vector<sf::Vector2f> output;
+	if (expandedTiles != nullptr) *expandedTiles = 0;
 
-	for (int i = 0; i < 2; i++)
+	auto tiles = collisions->GetCommonMap();
+	if (tiles->width == 0 || tiles->height == 0 || tiles->tileWidth == 0 || tiles->tileHeight == 0) return output;
+
+	auto tileOf = [tiles](const sf::Vector2f& pos)
+	{
+		return sf::Vector2i((int)floorf((pos.x - tiles->offsetX) / (float)tiles->tileWidth), (int)floorf((pos.y - tiles->offsetY) / (float)tiles->tileHeight));
+	};
+	auto start = tileOf(startPos);
+	auto end = tileOf(endPos);
+	if (!IsTileFree(tiles, start.x, start.y) || !IsTileFree(tiles, end.x, end.y)) return output;
+	if (start == end)
 	{
-		Cell* init = nullptr;
-		if (i == 0) init = &start;
-		else init = &end;
+		output.push_back(endPos);
+		return output;
+	}
 
-		init->globalGoal = INFINITY;
-		init->localGoal = INFINITY;
-		init->neighbours.clear();
-		init->parent = nullptr;
-		init->visited = false;
-		init->pos = (i == 0) ? startPos : endPos;
+	//Reset scratch
+	size_t size = tiles->data.size();
+	if (_gridSearch.g.size() != size)
+	{
+		_gridSearch.g.assign(size, INFINITY);
+		_gridSearch.parent.assign(size, NO_NODE);
+		_gridSearch.closed.assign(size, 0);
+		_gridSearch.touched.clear();
+	}
+	for (auto index : _gridSearch.touched)
+	{
+		_gridSearch.g[index] = INFINITY;
+		_gridSearch.parent[index] = NO_NODE;
+		_gridSearch.closed[index] = 0;
 	}
+	_gridSearch.touched.clear();
 
-	_baseGraph.push_back(start);
-	_baseGraph.push_back(end);
+	auto width = tiles->width;
+	auto octile = [](int ax, int ay, int bx, int by)
+	{
+		float dx = (float)abs(ax - bx);
+		float dy = (float)abs(ay - by);
+		return std::max(dx, dy) + 0.41421356f * std::min(dx, dy);
+	};
 
-	auto last = _baseGraph.end();
-	last--;
-	auto endIt = last;
-	last--;
-	auto &startIt = last;
+	uint32_t startIndex = (uint32_t)start.y * width + start.x;
+	uint32_t endIndex = (uint32_t)end.y * width + end.x;
+	_gridSearch.g[startIndex] = 0.f;
+	_gridSearch.touched.push_back(startIndex);
 
-	for (auto cell = _baseGraph.begin(); cell != startIt; cell++)
+	OpenSet notTestedTiles;
+	notTestedTiles.push(OpenSetEntry(octile(start.x, start.y, end.x, end.y), startIndex));
+	bool found = false;
+	while (!notTestedTiles.empty())
 	{
-		for (auto check = startIt; check != _baseGraph.end(); check++)
+		auto top = notTestedTiles.top();
+		notTestedTiles.pop();
+
+		auto current = top.second;
+		if (_gridSearch.closed[current]) continue; //Stale entry
+		_gridSearch.closed[current] = 1;
+		if (expandedTiles != nullptr) (*expandedTiles)++;
+		if (current == endIndex)
 		{
-			float distance = 0;
-			if (collisions->RaycastHitsPoint(check->pos, cell->pos, &distance))
+			found = true;
+			break;
+		}
+
+		int x = (int)(current % width);
+		int y = (int)(current / width);
+
+		//Pruned directions
+		int dirs[8][2];
+		int count = 0;
+		auto addDir = [&](int dx, int dy) { dirs[count][0] = dx; dirs[count][1] = dy; count++; };
+		if (_gridSearch.parent[current] == NO_NODE)
+		{
+			for (int dy = -1; dy <= 1; dy++)
+				for (int dx = -1; dx <= 1; dx++)
+					if (dx != 0 || dy != 0) addDir(dx, dy);
+		}
+		else
+		{
+			int px = (int)(_gridSearch.parent[current] % width);
+			int py = (int)(_gridSearch.parent[current] / width);
+			int dx = (x > px) ? 1 : ((x < px) ? -1 : 0);
+			int dy = (y > py) ? 1 : ((y < py) ? -1 : 0);
+			if (dx != 0 && dy != 0)
 			{
-				cell->neighbours[&(*check)] = distance;
-				check->neighbours[&(*cell)] = distance;
+				addDir(dx, 0);
+				addDir(0, dy);
+				addDir(dx, dy);
+			}
+			else if (dx != 0)
+			{
+				addDir(dx, 0);
+				addDir(0, 1);
+				addDir(0, -1);
+				addDir(dx, 1);
+				addDir(dx, -1);
+			}
+			else
+			{
+				addDir(0, dy);
+				addDir(1, 0);
+				addDir(-1, 0);
+				addDir(1, dy);
+				addDir(-1, dy);
 			}
 		}
-	}
 
-	auto output = SolveAStar(&(*startIt), &(*endIt));
+		for (int i = 0; i < count; i++)
+		{
+			int jx = x, jy = y;
+			if (!Jump(tiles, jx, jy, dirs[i][0], dirs[i][1], end.x, end.y)) continue;
+
+			uint32_t jump = (uint32_t)jy * width + jx;
+			if (_gridSearch.closed[jump]) continue;
+
+			float g = _gridSearch.g[current] + octile(x, y, jx, jy);
+			if (g < _gridSearch.g[jump])
+			{
+				if (_gridSearch.g[jump] == INFINITY) _gridSearch.touched.push_back(jump);
+				_gridSearch.g[jump] = g;
+				_gridSearch.parent[jump] = current;
+				notTestedTiles.push(OpenSetEntry(g + octile(jx, jy, end.x, end.y), jump));
+			}
+		}
+	}
+	if (!found) return output;
 
-	//Remove addresses from neighbours and points
-	for (auto& mapped : startIt->neighbours)
-		mapped.first->neighbours.erase(mapped.first->neighbours.find(&(*startIt)));
-	for (auto &mapped : endIt->neighbours)
-		mapped.first->neighbours.erase(mapped.first->neighbours.find(&(*endIt)));
+	//Tile centers of jump points, start and end tiles are included so every step stays on free tiles
+	std::vector<sf::Vector2f> waypoints;
+	for (auto index = endIndex; index != NO_NODE; index = _gridSearch.parent[index])
+		waypoints.emplace_back(((float)(index % width) + 0.5f) * (float)tiles->tileWidth + tiles->offsetX,
+							   ((float)(index / width) + 0.5f) * (float)tiles->tileHeight + tiles->offsetY);
+	std::reverse(waypoints.begin(), waypoints.end());
+	waypoints.push_back(endPos);
 
-	_baseGraph.erase(startIt, _baseGraph.end());
+	//String pulling, go to furthest waypoint that can be reached in straight line
+	auto clear = [&](const sf::Vector2f& a, const sf::Vector2f& b)
+	{
+		return CollisionHelper::GetSegmentTileEntry(a, b, clearance, tiles) == INFINITY;
+	};
+	sf::Vector2f anchor = startPos;
+	size_t next = 0;
+	while (next < waypoints.size())
+	{
+		size_t furthest = next;
+		for (size_t i = waypoints.size() - 1; i > next; i--)
+			if (clear(anchor, waypoints[i]))
+			{
+				furthest = i;
+				break;
+			}
+		output.push_back(waypoints[furthest]);
+		anchor = waypoints[furthest];
+		next = furthest + 1;
+	}
 
 	return output;
 }
 
-Paths PathfindingManager::GetDijkstrasPath(const sf::Vector2f& startPos, CollisionsManager* collisions)
+void PathfindingManager::SetTreeParent(uint32_t node, uint32_t parent)
 {
-	//Init
-	Cell start;
-	start.globalGoal = INFINITY;
-	start.localGoal = INFINITY;
-	start.neighbours.clear();
-	start.parent = nullptr;
-	start.visited = false;
-	start.pos = startPos;
+	if (_tree.parent[node] == parent) return;
 
-	_baseGraph.push_back(start);
-	
-	//Get var
-	auto startCell = _baseGraph.end();
-	startCell--;
+	_tree.parent[node] = parent;
+	auto& value = _tree.paths[Vector2MapKey<float>(GetNodePos(node))];
+	if (parent == NO_NODE) value = sf::Vector2f(INFINITY, INFINITY);
+	else if (parent == StartNode()) value = _tree.rootPos;
+	else value = GetNodePos(parent);
+}
 
-	//Check connections with other nodes
-	for (auto check = _baseGraph.begin(); check != startCell; check++)
+void PathfindingManager::UpdateTreeNode(uint32_t node)
+{
+	//Best parent from root link and reversed links
+	float best = _tree.rootWeight[node];
+	uint32_t bestParent = (best != INFINITY) ? StartNode() : NO_NODE;
+	for (auto i = _baseGraph.inOffsets[node]; i < _baseGraph.inOffsets[node + 1]; i++)
 	{
-		float distance = 0;
-		if (collisions->RaycastHitsPoint(check->pos, startCell->pos, &distance))
+		float cost = _tree.g[_baseGraph.inNeighbours[i]] + _baseGraph.inWeights[i];
+		if (cost < best)
 		{
-			startCell->neighbours[&(*check)] = distance;
-			check->neighbours[&(*startCell)] = distance;
+			best = cost;
+			bestParent = _baseGraph.inNeighbours[i];
 		}
 	}
 
-	//Solve
-	auto output = SolveDijkstras(&(*startCell));
+	_tree.rhs[node] = best;
+	SetTreeParent(node, (best != INFINITY) ? bestParent : NO_NODE);
 
-	//Clean
-	for (auto &n : startCell->neighbours)
-		n.first->neighbours.erase(n.first->neighbours.find(&(*startCell)));
+	if (_tree.g[node] != _tree.rhs[node])
+		_tree.open.push(OpenSetEntry(std::min(_tree.g[node], _tree.rhs[node]), node));
+}
+
+size_t PathfindingManager::RepairTree()
+{
+	size_t repaired = 0;
+	while (!_tree.open.empty())
+	{
+		auto top = _tree.open.top();
+		_tree.open.pop();
 
-	_baseGraph.erase(startCell);
+		auto node = top.second;
+		if (_tree.g[node] == _tree.rhs[node] || top.first != std::min(_tree.g[node], _tree.rhs[node])) continue; //Stale entry
 
-	return output;
+		repaired++;
+		if (_tree.g[node] > _tree.rhs[node]) //Got closer
+			_tree.g[node] = _tree.rhs[node];
+		else //Got further, recheck itself too
+		{
+			_tree.g[node] = INFINITY;
+			UpdateTreeNode(node);
+		}
+
+		for (auto i = _baseGraph.offsets[node]; i < _baseGraph.offsets[node + 1]; i++)
+			UpdateTreeNode(_baseGraph.neighbours[i]);
+	}
+	return repaired;
 }
 
-sf::Vector2f PathfindingManager::GetClosestNode(const Paths& paths, const sf::Vector2f& startPos, CollisionsManager* collisions)
+size_t PathfindingManager::UpdateIncrementalTree(const sf::Vector2f& rootPos, CollisionsManager* collisions, float weightTolerance)
 {
-	std::list<std::tuple<sf::Vector2f, float>> nodesDistances;
-	for (auto &p : paths)
+	size_t nodes = _baseGraph.Size();
+	if (!_tree.active)
 	{
-		std::tuple<sf::Vector2f, float> t(p.first, MathHelper::GetDistanceBetweenPoints(startPos, p.first));
-		nodesDistances.push_back(t);
+		_tree.g.assign(nodes, INFINITY);
+		_tree.rhs.assign(nodes, INFINITY);
+		_tree.parent.assign(nodes, NO_NODE);
+		_tree.rootWeight.assign(nodes, INFINITY);
+		_tree.visibleWeight.assign(nodes, INFINITY);
+		_tree.rootLinked.clear();
+		_tree.paths.clear();
+		for (uint32_t i = 0; i < (uint32_t)nodes; i++)
+			_tree.paths[Vector2MapKey<float>(GetNodePos(i))] = sf::Vector2f(INFINITY, INFINITY);
+		_tree.rootPos = rootPos;
+		_tree.active = true;
 	}
 
-	//Sort to make closest ones first
-	auto sort = [](std::tuple<sf::Vector2f, float> first, std::tuple<sf::Vector2f, float> second)
+	//Move root
+	_tree.paths.erase(Vector2MapKey<float>(_tree.rootPos));
+	_tree.rootPos = rootPos;
+	for (auto node : _tree.rootLinked)
+		if (_tree.parent[node] == StartNode())
+			_tree.paths[Vector2MapKey<float>(GetNodePos(node))] = rootPos;
+
+	//Apply changed root links only
+	auto visible = GetVisibleNodes(rootPos, collisions, false);
+	for (auto& link : visible)
+		_tree.visibleWeight[link.first] = link.second;
+
+	auto apply = [&](uint32_t node)
 	{
-		return std::get<1>(first) < std::get<1>(second);
+		float now = _tree.visibleWeight[node];
+		float before = _tree.rootWeight[node];
+		bool changed = (now == INFINITY || before == INFINITY) ? now != before : fabsf(now - before) > weightTolerance;
+		if (changed)
+		{
+			_tree.rootWeight[node] = now;
+			UpdateTreeNode(node);
+		}
 	};
-	nodesDistances.sort(sort);
+	for (auto node : _tree.rootLinked)
+		apply(node);
+	for (auto& link : visible)
+		apply(link.first);
 
-	//Check which hits
-	for (auto &p : nodesDistances)
+	_tree.rootLinked.clear();
+	for (auto& link : visible)
 	{
-		float distance = 0.f;
-		if (collisions->RaycastHitsPoint(startPos, std::get<0>(p), &distance))
-			return std::get<0>(p);
+		_tree.rootLinked.push_back(link.first);
+		_tree.visibleWeight[link.first] = INFINITY;
 	}
-	
-	return sf::Vector2f(INFINITY, INFINITY);
+
+	auto repaired = RepairTree();
+	_tree.paths[Vector2MapKey<float>(rootPos)] = sf::Vector2f(INFINITY, INFINITY);
+	return repaired;
 }
 
-sf::Vector2f PathfindingManager::GetClosestVisibleNodeTo(const Paths& paths, const sf::Vector2f& startPos, const sf::Vector2f& endPos, CollisionsManager* collisions)
+void PathfindingManager::ClearIncrementalTree()
 {
-	std::list<std::tuple<sf::Vector2f, float>> nodesDistances;
-	for (auto& p : paths)
+	_tree.active = false;
+	_tree.g.clear();
+	_tree.rhs.clear();
+	_tree.parent.clear();
+	_tree.rootWeight.clear();
+	_tree.rootLinked.clear();
+	_tree.visibleWeight.clear();
+	_tree.open = OpenSet();
+	_tree.paths.clear();
+}
+
+const Paths& PathfindingManager::GetIncrementalPaths() const
+{
+	return _tree.paths;
+}
+
+sf::Vector2i PathfindingManager::GetFlowFieldTile(const sf::Vector2f& pos) const
+{
+	auto tiles = _flowField.tiles;
+	if (tiles == nullptr || tiles->tileWidth == 0 || tiles->tileHeight == 0)
+		return sf::Vector2i(-1, -1);
+
+	int x = (int)floorf((pos.x - tiles->offsetX) / (float)tiles->tileWidth);
+	int y = (int)floorf((pos.y - tiles->offsetY) / (float)tiles->tileHeight);
+	if (x < 0 || y < 0 || x > (int)tiles->width - 1 || y > (int)tiles->height - 1)
+		return sf::Vector2i(-1, -1);
+	return sf::Vector2i(x, y);
+}
+
+bool PathfindingManager::CanFlowBetween(int x, int y, int dir) const
+{
+	auto tiles = _flowField.tiles;
+	int nx = x + FLOW_DX[dir];
+	int ny = y + FLOW_DY[dir];
+	if (nx < 0 || ny < 0 || nx > (int)tiles->width - 1 || ny > (int)tiles->height - 1) return false;
+	if (tiles->data[(size_t)ny * tiles->width + nx]) return false;
+
+	//No corner cutting
+	if (dir >= 4)
+		if (tiles->data[(size_t)y * tiles->width + nx] || tiles->data[(size_t)ny * tiles->width + x])
+			return false;
+	return true;
+}
+
+bool PathfindingManager::UpdateFlowField(const sf::Vector2f& target, const MapLayerModel<bool>* tiles)
+{
+	bool sameMap = (_flowField.tiles == tiles && tiles != nullptr && _flowField.integration.size() == tiles->data.size());
+	_flowField.tiles = tiles;
+
+	auto targetTile = GetFlowFieldTile(target);
+	if (sameMap && targetTile == _flowField.target)
+		return false;
+
+	_flowField.target = targetTile;
+	if (tiles == nullptr) return true;
+
+	size_t size = tiles->data.size();
+	_flowField.integration.assign(size, INFINITY);
+	_flowField.direction.assign(size, -1);
+	if (targetTile.x < 0) return true;
+
+	//Integration field, Dijkstra from target tile
+	auto& integration = _flowField.integration;
+	uint32_t targetIndex = (uint32_t)targetTile.y * tiles->width + targetTile.x;
+	integration[targetIndex] = 0.f;
+
+	OpenSet notTestedTiles;
+	notTestedTiles.push(OpenSetEntry(0.f, targetIndex));
+	while (!notTestedTiles.empty())
 	{
-		if (p.second.x == INFINITY) continue;
-		std::tuple<sf::Vector2f, float> t(p.first, MathHelper::GetDistanceBetweenPoints(endPos, p.first));
-		nodesDistances.push_back(t);
+		auto top = notTestedTiles.top();
+		notTestedTiles.pop();
+		if (top.first > integration[top.second]) continue; //Stale entry
+
+		int x = (int)(top.second % tiles->width);
+		int y = (int)(top.second / tiles->width);
+		for (int dir = 0; dir < 8; dir++)
+		{
+			if (!CanFlowBetween(x, y, dir)) continue;
+
+			uint32_t neighbour = (uint32_t)(y + FLOW_DY[dir]) * tiles->width + (uint32_t)(x + FLOW_DX[dir]);
+			float cost = top.first + FLOW_COST[dir];
+			if (cost < integration[neighbour])
+			{
+				integration[neighbour] = cost;
+				notTestedTiles.push(OpenSetEntry(cost, neighbour));
+			}
+		}
 	}
 
-	//Sort to make closest ones first
-	auto sort = [](std::tuple<sf::Vector2f, float> first, std::tuple<sf::Vector2f, float> second)
-	{
-		return std::get<1>(first) < std::get<1>(second);
-	};
-	nodesDistances.sort(sort);
+	//Direction field, every tile points to its cheapest reachable neighbour
+	for (int y = 0; y < (int)tiles->height; y++)
+		for (int x = 0; x < (int)tiles->width; x++)
+		{
+			size_t index = (size_t)y * tiles->width + x;
+			if (index == targetIndex) continue;
+
+			bool blocked = tiles->data[index];
+			float best = (blocked) ? INFINITY : integration[index];
+			for (int dir = 0; dir < 8; dir++)
+			{
+				//Blocked tiles only need a way out
+				if (blocked)
+				{
+					int nx = x + FLOW_DX[dir];
+					int ny = y + FLOW_DY[dir];
+					if (nx < 0 || ny < 0 || nx > (int)tiles->width - 1 || ny > (int)tiles->height - 1) continue;
+				}
+				else if (!CanFlowBetween(x, y, dir)) continue;
+
+				float cost = integration[(size_t)(y + FLOW_DY[dir]) * tiles->width + (x + FLOW_DX[dir])];
+				if (cost < best)
+				{
+					best = cost;
+					_flowField.direction[index] = (int8_t)dir;
+				}
+			}
+		}
 
-	//Check which hits
-	for (auto &p : nodesDistances)
+	return true;
+}
+
+void PathfindingManager::ClearFlowField()
+{
+	_flowField.tiles = nullptr;
+	_flowField.target = sf::Vector2i(-1, -1);
+	_flowField.integration.clear();
+	_flowField.direction.clear();
+}
+
+sf::Vector2f PathfindingManager::GetFlowFieldNextPoint(const sf::Vector2f& pos) const
+{
+	auto tile = GetFlowFieldTile(pos);
+	if (tile.x < 0 || _flowField.direction.empty())
+		return sf::Vector2f(INFINITY, INFINITY);
+
+	auto tiles = _flowField.tiles;
+	size_t index = (size_t)tile.y * tiles->width + tile.x;
+	if (tile != _flowField.target)
 	{
-		float distance = 0.f;
-		if (collisions->RaycastHitsPoint(startPos, std::get<0>(p), &distance))
-			return std::get<0>(p);
+		auto dir = _flowField.direction[index];
+		if (dir < 0) return sf::Vector2f(INFINITY, INFINITY);
+		tile.x += FLOW_DX[dir];
+		tile.y += FLOW_DY[dir];
 	}
 
-	return sf::Vector2f(INFINITY, INFINITY);
+	//Center of next tile
+	return sf::Vector2f((float)tile.x * (float)tiles->tileWidth + (float)tiles->tileWidth / 2.f + tiles->offsetX,
+						(float)tile.y * (float)tiles->tileHeight + (float)tiles->tileHeight / 2.f + tiles->offsetY);
+}
+
+float PathfindingManager::GetFlowFieldDistance(const sf::Vector2f& pos) const
+{
+	auto tile = GetFlowFieldTile(pos);
+	if (tile.x < 0 || _flowField.integration.empty())
+		return INFINITY;
+
+	auto tiles = _flowField.tiles;
+	size_t index = (size_t)tile.y * tiles->width + tile.x;
+	if (tiles->data[index] && _flowField.direction[index] >= 0)
+	{
+		auto dir = _flowField.direction[index];
+		return FLOW_COST[dir] + _flowField.integration[(size_t)(tile.y + FLOW_DY[dir]) * tiles->width + (tile.x + FLOW_DX[dir])];
+	}
+	return _flowField.integration[index];
 }
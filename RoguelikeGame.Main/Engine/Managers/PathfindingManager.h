@@ -1,38 +1,248 @@
 #pragma once
 
+#include <fstream>
 #include <vector>
+#include <algorithm>
+#include <cstdint>
 #include <list>
+#include <map>
+#include <queue>
+#include <tuple>
 #include <unordered_map>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <memory>
+#include <deque>
+#include <unordered_set>
 
 #include "../Managers/CollisionsManager.h"
 #include "../Utilities/Utilities.h"
+#include "../Utilities/LruCache.hpp"
 
 typedef std::unordered_map<Vector2MapKey<float>, sf::Vector2f, Vector2MapKeyHasher<float>> Paths;
+typedef std::tuple<size_t, size_t, float> GraphLink; //From node, to node, distance
+typedef uint32_t PathRequestHandle; //0 is never given out
 
 class PathfindingManager
 {
+public:
+	struct CacheStats
+	{
+		size_t visibilityHits = 0;
+		size_t visibilityMisses = 0;
+	};
 private:
-	struct Cell
+	//Nodes bucketed in uniform cells, single cell if cell size is not limited
+	struct NodeGrid
+	{
+		float cellSize = INFINITY;
+		sf::Vector2f min;
+		sf::Vector2f max;
+		int columns = 1;
+		int rows = 1;
+		std::vector<uint32_t> offsets; //Nodes of cell i are in [offsets[i], offsets[i + 1])
+		std::vector<uint32_t> nodes;
+
+		void Build(const std::vector<sf::Vector2f>& points, float size);
+		sf::Vector2i CellOf(const sf::Vector2f& point) const;
+		//Sorted nodes of cells touching area grown by distance
+		std::vector<uint32_t> GetNodesNear(const sf::FloatRect& area, float distance) const;
+		//Nodes of cells touching convex polygon
+		void GetNodesIn(const std::vector<sf::Vector2f>& polygon, std::vector<uint32_t>& output) const;
+	};
+
+	//Graph nodes stored in compressed sparse row form
+	struct BaseGraph
+	{
+		std::vector<float> posX;
+		std::vector<float> posY;
+
+		std::vector<uint32_t> offsets; //Links of node i are in [offsets[i], offsets[i + 1])
+		std::vector<uint32_t> neighbours;
+		std::vector<float> weights;
+
+		//Reversed links, built from the ones above
+		std::vector<uint32_t> inOffsets;
+		std::vector<uint32_t> inNeighbours;
+		std::vector<float> inWeights;
+
+		float maxLinkDistance = INFINITY; //Used by build, links are tested again with it after map changes
+		NodeGrid grid; //Few nodes per cell, for finding nodes in part of map
+
+		size_t Size() const { return posX.size(); }
+	};
+
+	//Per query state, kept outside of the graph and reused between queries
+	struct SearchBuffer
+	{
+		std::vector<float> localGoal;
+		std::vector<float> globalGoal;
+		std::vector<uint32_t> parent;
+		std::vector<uint8_t> visited;
+
+		//Temporary start and end nodes, placed right after graph nodes
+		sf::Vector2f startPos;
+		sf::Vector2f endPos;
+		std::vector<std::pair<uint32_t, float>> startLinks;
+		std::vector<std::pair<uint32_t, float>> endLinks;
+		std::vector<float> toEnd;
+
+		void Reset(size_t graphSize);
+	};
+
+	//Open set as binary heap, outdated entries are skipped when popped
+	typedef std::pair<float, uint32_t> OpenSetEntry;
+	struct OpenSetCompare
+	{
+		bool operator()(const OpenSetEntry& lhs, const OpenSetEntry& rhs) const { return lhs.first > rhs.first; }
+	};
+	typedef std::priority_queue<OpenSetEntry, std::vector<OpenSetEntry>, OpenSetCompare> OpenSet;
+
+	static const uint32_t NO_NODE = UINT32_MAX;
+	static const uint32_t GRAPH_FILE_MAGIC = 0x47504752; //"RGPG"
+	static const uint32_t GRAPH_FILE_VERSION = 1;
+	enum CellNode : uint8_t { CELL_NODE_UNKNOWN = 0, CELL_NODE_SEEN = 1, CELL_NODE_HIDDEN = 2 }; //Seen means not proven hidden
+
+	//Tile resolution integration and direction fields towards one target tile
+	struct FlowField
+	{
+		const MapLayerModel<bool>* tiles = nullptr;
+		sf::Vector2i target = sf::Vector2i(-1, -1);
+		std::vector<float> integration; //Distance to target in tiles
+		std::vector<int8_t> direction; //Index of next tile neighbour, -1 if none
+	};
+
+	//Shortest path tree from moving root, repaired LPA* style when root links change
+	struct IncrementalTree
+	{
+		bool active = false;
+		sf::Vector2f rootPos;
+		std::vector<float> g;
+		std::vector<float> rhs;
+		std::vector<uint32_t> parent;
+		std::vector<float> rootWeight; //INFINITY if node is not linked with root
+		std::vector<uint32_t> rootLinked;
+		std::vector<float> visibleWeight;
+		OpenSet open;
+		Paths paths;
+	};
+
+	//Per query state for tile grid searches, only touched tiles are reset
+	struct GridSearchBuffer
 	{
-		bool visited = false;
+		std::vector<float> g;
+		std::vector<uint32_t> parent;
+		std::vector<uint8_t> closed;
+		std::vector<uint32_t> touched;
+	};
 
-		sf::Vector2f pos;
-		float localGoal = INFINITY;
-		float globalGoal = INFINITY;
+	//Immutable copy of graph and collision tiles, shared with path workers
+	struct PathSnapshot
+	{
+		BaseGraph graph;
+		MapLayerModel<bool> tiles;
+		EdgeGrid edgesGrid; //With tiles gives same visibility as TileRaycastHitsPoint of manager
+		const CollisionsManager* collisions = nullptr; //Only compared, never used by workers
+		uint64_t collisionsVersion = 0;
+	};
+
+	struct PathRequest
+	{
+		PathRequestHandle handle = 0;
+		sf::Vector2f startPos;
+		sf::Vector2f endPos;
+		std::shared_ptr<const PathSnapshot> snapshot;
+	};
 
-		Cell* parent = nullptr;
-		std::map<Cell*, float> neighbours;
+	//Cache, dropped when graph or collisions change
+	struct QueryCache
+	{
+		const CollisionsManager* collisions = nullptr;
+		uint64_t collisionsVersion = 0;
+		LruCache<uint64_t, std::vector<uint8_t>> cellVisibility; //Tile cell -> CellNode per node, filled only for nodes queries walked
+		std::unordered_map<Vector2MapKey<float>, uint32_t, Vector2MapKeyHasher<float>> nodeOfPos;
 	};
 
-	std::list<Cell> _baseGraph;
+	BaseGraph _baseGraph;
+	SearchBuffer _search;
+	FlowField _flowField;
+	IncrementalTree _tree;
+	GridSearchBuffer _gridSearch;
+	QueryCache _cache;
+	CacheStats _cacheStats;
+
+	//Path request service
+	std::shared_ptr<const PathSnapshot> _pathSnapshot;
+	std::vector<std::thread> _pathWorkers;
+	std::mutex _pathMutex;
+	std::condition_variable _pathCondition;
+	std::deque<PathRequest> _pathRequests;
+	std::unordered_set<PathRequestHandle> _runningRequests;
+	std::unordered_set<PathRequestHandle> _cancelledRequests;
+	std::unordered_map<PathRequestHandle, std::vector<sf::Vector2f>> _pathResults;
+	PathRequestHandle _lastPathRequest;
+	bool _stopPathWorkers;
+
+	uint32_t StartNode() const;
+	uint32_t EndNode() const;
+	sf::Vector2f GetNodePos(uint32_t node) const;
+	std::vector<std::pair<uint32_t, float>> GetVisibleNodes(const sf::Vector2f& pos, CollisionsManager* collisions, bool rayFromPos) const;
+	void BuildBaseGraph(const std::vector<sf::Vector2f>& points, std::vector<GraphLink> links);
+	void PrepareBaseGraph();
+	//Lists of changed nodes are replaced, lists of other nodes are only moved
+	static void SpliceLinks(std::vector<uint32_t>& offsets, std::vector<uint32_t>& targets, std::vector<float>& weights, const std::map<uint32_t, std::vector<std::pair<uint32_t, float>>>& changed);
+
+	static std::vector<sf::Vector2f> SolveAStar(const BaseGraph& graph, SearchBuffer& search, uint32_t startNode, uint32_t endNode);
+	Paths SolveDijkstras(uint32_t startNode);
+
+	void UpdateTreeNode(uint32_t node);
+	void SetTreeParent(uint32_t node, uint32_t parent);
+	size_t RepairTree();
+
+	bool IsTileFree(const MapLayerModel<bool>* tiles, int x, int y) const;
+	bool JumpStraight(const MapLayerModel<bool>* tiles, int& x, int& y, int dx, int dy, int endX, int endY) const;
+	bool Jump(const MapLayerModel<bool>* tiles, int& x, int& y, int dx, int dy, int endX, int endY) const;
 
-	std::vector<sf::Vector2f> SolveAStar(Cell* startCell, Cell* endCell);
-	Paths SolveDijkstras(Cell* startCell);
+	void ValidateCache(const CollisionsManager* collisions);
+	//Nullptr if cache is off or pos is in blocked tile
+	std::vector<uint8_t>* GetCellVisibility(const sf::Vector2f& pos, CollisionsManager* collisions, sf::FloatRect& cell);
+	//True only if whole cell is in shadow of one straight wall run, so raycast from any point of cell misses node
+	bool IsNodeHiddenFromCell(uint32_t node, const sf::FloatRect& cell, const MapLayerModel<bool>* tiles) const;
+	sf::Vector2f GetFirstVisibleNode(const std::list<std::tuple<sf::Vector2f, float>>& sortedNodes, const sf::Vector2f& startPos, CollisionsManager* collisions);
+
+	sf::Vector2i GetFlowFieldTile(const sf::Vector2f& pos) const;
+	bool CanFlowBetween(int x, int y, int dir) const;
+
+	static std::vector<std::pair<uint32_t, float>> GetSnapshotVisibleNodes(const PathSnapshot& snapshot, const sf::Vector2f& pos);
+	static std::vector<sf::Vector2f> SolveSnapshotPath(const PathSnapshot& snapshot, SearchBuffer& search, const sf::Vector2f& startPos, const sf::Vector2f& endPos);
+	void PathWorkerLoop();
 public:
+	//Base graph build settings, defaults give the same graph as all-pairs build
+	struct GraphBuildOptions
+	{
+		float maxLinkDistance = INFINITY; //Longer links are not tested
+		unsigned int threads = 0; //0 means all cores
+	};
+
 	PathfindingManager();
-	~PathfindingManager() = default;
+	~PathfindingManager();
 
 	void GenerateBaseGraph(const std::vector<sf::Vector2f>& points, CollisionsManager* collisions);
+	void GenerateBaseGraph(const std::vector<sf::Vector2f>& points, CollisionsManager* collisions, const GraphBuildOptions& options);
+	void LoadBaseGraph(const std::vector<sf::Vector2f>& points, const std::vector<GraphLink>& links);
+	std::vector<GraphLink> GetBaseGraphLinks() const;
+	std::vector<sf::Vector2f> GetBaseGraphPoints() const;
+	size_t GetBaseGraphSize() const;
+	//Links crossing area are tested again after tiles in it changed, returns true if graph changed
+	bool UpdateBaseGraphLinks(const sf::FloatRect& area, CollisionsManager* collisions);
+
+	//Baked graph, hash tells if it still matches collision map and points
+	static uint64_t GetBaseGraphHash(const MapLayerModel<bool>* tiles, const std::vector<sf::Vector2f>& points);
+	bool SaveBaseGraphToFile(const std::string& path, uint64_t hash) const;
+	bool LoadBaseGraphFromFile(const std::string& path, uint64_t hash);
+
 	std::list<sf::Vector2f> GetNodesInSight(const sf::Vector2f& start, CollisionsManager* collisions);
 
 	//A* algh
@@ -40,7 +250,38 @@ public:
 
 	//Dijkstra's algh
 	Paths GetDijkstrasPath(const sf::Vector2f& startPos, CollisionsManager* collisions);
+	Paths GetDijkstrasPath(size_t startNode);
 	sf::Vector2f GetClosestNode(const Paths& paths, const sf::Vector2f& startPos, CollisionsManager* collisions);
 	sf::Vector2f GetClosestVisibleNodeTo(const Paths& paths, const sf::Vector2f& startPos, const sf::Vector2f& endPos, CollisionsManager* collisions);
-};
 
+	//Query cache, capacity is number of cells
+	void SetVisibilityCacheCapacity(size_t capacity);
+	void ClearCaches();
+	const CacheStats& GetCacheStats() const;
+	void ResetCacheStats();
+
+	//Jump Point Search on collision tiles, no graph needed
+	//Returns string pulled waypoints from start to end (start excluded), empty if no path
+	std::vector<sf::Vector2f> GetJPSPath(const sf::Vector2f& startPos, const sf::Vector2f& endPos, CollisionsManager* collisions, float clearance = 0.f, size_t* expandedTiles = nullptr);
+
+	//Asynchronous A*, solved by worker threads on snapshot of graph and collision tiles
+	//Results are the same as GetAStarPath at request time and are kept until collected or cancelled
+	void StartPathWorkers(unsigned int threads = 0); //0 means all cores but one
+	void StopPathWorkers();
+	void InvalidatePathSnapshot();
+	PathRequestHandle RequestPath(const sf::Vector2f& startPos, const sf::Vector2f& endPos, CollisionsManager* collisions);
+	bool TryGetPathResult(PathRequestHandle handle, std::vector<sf::Vector2f>& output);
+	void CancelPathRequest(PathRequestHandle handle);
+	size_t GetPendingPathRequests();
+
+	//Incremental Dijkstra's, returns number of repaired nodes
+	size_t UpdateIncrementalTree(const sf::Vector2f& rootPos, CollisionsManager* collisions, float weightTolerance = 0.f);
+	void ClearIncrementalTree();
+	const Paths& GetIncrementalPaths() const;
+
+	//Flow field, rebuilt only when target moves to other tile
+	bool UpdateFlowField(const sf::Vector2f& target, const MapLayerModel<bool>* tiles);
+	void ClearFlowField();
+	sf::Vector2f GetFlowFieldNextPoint(const sf::Vector2f& pos) const;
+	float GetFlowFieldDistance(const sf::Vector2f& pos) const;
+};
@@ -0,0 +1,100 @@
+#include "VisibilityManager.h"
+
+VisibilityManager::VisibilityManager()
+{
+	_collisions = nullptr;
+	_tick = 0;
+}
+
+void VisibilityManager::ComputePolygon(FieldOfView& fov, const sf::Vector2f& origin, float radius)
+{
+	const float nearAngle = 0.01F;
+
+	_rays.clear();
+	for (unsigned int i = 0; i < POLYGON_BASE_RAYS; i++)
+		_rays.emplace_back(origin, 360.f * (float)i / (float)POLYGON_BASE_RAYS, radius);
+
+	auto edges = _collisions->GetEdges();
+	_collisions->GetEdgesInRect(sf::FloatRect(origin.x - radius, origin.y - radius, radius * 2.f, radius * 2.f), _edgesInRange);
+
+	//Neighbour edges share ends, every point gets rays only once
+	_corners.clear();
+	auto addCorner = [&](const sf::Vector2f& point) { _corners.emplace_back(point.x, point.y); };
+
+	for (auto id : _edgesInRange)
+	{
+		auto& start = std::get<0>(edges->at(id));
+		auto& end = std::get<1>(edges->at(id));
+		if (MathHelper::GetDistanceBetweenPoints(origin, start) <= radius) addCorner(start);
+		if (MathHelper::GetDistanceBetweenPoints(origin, end) <= radius) addCorner(end);
+
+		//Long walls also end polygon where they leave radius
+		auto dir = end - start;
+		auto diff = start - origin;
+		float a = dir.x * dir.x + dir.y * dir.y;
+		float b = diff.x * dir.x + diff.y * dir.y;
+		float c = diff.x * diff.x + diff.y * diff.y - radius * radius;
+		float discriminant = b * b - a * c;
+		if (a == 0.f || discriminant <= 0.f) continue;
+
+		for (float t : { (-b - std::sqrt(discriminant)) / a, (-b + std::sqrt(discriminant)) / a })
+			if (t > 0.f && t < 1.f)
+				addCorner(start + dir * t);
+	}
+
+	std::sort(_corners.begin(), _corners.end());
+	_corners.erase(std::unique(_corners.begin(), _corners.end()), _corners.end());
+	for (auto& corner : _corners)
+	{
+		auto angle = MathHelper::GetAngleBetweenPoints(origin, sf::Vector2f(corner.first, corner.second));
+		_rays.emplace_back(origin, angle - nearAngle, radius);
+		_rays.emplace_back(origin, angle, radius);
+		_rays.emplace_back(origin, angle + nearAngle, radius);
+	}
+
+	_collisions->GetRayHitpoints(_rays, _hitpoints);
+	fov.SetPolygon(origin, radius, _hitpoints);
+}
+
+void VisibilityManager::SetCollisionsManager(CollisionsManager* manager)
+{
+	_collisions = manager;
+	_cache.clear();
+}
+
+void VisibilityManager::NextTick()
+{
+	_tick++;
+}
+
+const FieldOfView* VisibilityManager::GetFieldOfView(const Entity* observer, float radius)
+{
+	if (_collisions == nullptr || observer == nullptr) return nullptr;
+
+	auto found = _cache.find(observer);
+	if (found != _cache.end() && found->second.tick == _tick && found->second.collisionsVersion == _collisions->GetVersion() && found->second.fov.GetRadius() == radius)
+		return &found->second.fov;
+
+	auto& cached = _cache[observer];
+	auto origin = ViewHelper::GetRectCenter(observer->GetCollisionBox());
+	cached.fov.ComputeTiles(origin, radius, _collisions->GetCommonMap());
+	ComputePolygon(cached.fov, origin, radius);
+	cached.tick = _tick;
+	cached.collisionsVersion = _collisions->GetVersion();
+	return &cached.fov;
+}
+
+void VisibilityManager::Forget(const Entity* observer)
+{
+	_cache.erase(observer);
+}
+
+void VisibilityManager::Clear()
+{
+	_cache.clear();
+}
+
+uint64_t VisibilityManager::GetTick() const
+{
+	return _tick;
+}
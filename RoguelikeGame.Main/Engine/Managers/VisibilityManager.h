@@ -0,0 +1,49 @@
+#pragma once
+
+#include <unordered_map>
+#include <algorithm>
+#include <cstdint>
+
+#include "../Managers/CollisionsManager.h"
+#include "../Helpers/ViewHelper.h"
+#include "../Utilities/FieldOfView.h"
+#include "../Models/Entity.h"
+
+//Field of view per observer, computed at most once per tick
+class VisibilityManager
+{
+private:
+	struct CachedView
+	{
+		FieldOfView fov;
+		uint64_t tick;
+		uint64_t collisionsVersion;
+	};
+
+	CollisionsManager* _collisions;
+	std::unordered_map<const Entity*, CachedView> _cache;
+	uint64_t _tick;
+
+	std::vector<size_t> _edgesInRange;
+	std::vector<std::pair<float, float>> _corners;
+	std::vector<std::tuple<sf::Vector2f, float, float>> _rays;
+	std::vector<sf::Vector2f> _hitpoints;
+
+	static const unsigned int POLYGON_BASE_RAYS = 64; //Spread evenly, they close polygon where nothing is hit
+
+	//Rays go at every edge end in range and just by it, so polygon follows wall corners
+	void ComputePolygon(FieldOfView& fov, const sf::Vector2f& origin, float radius);
+public:
+	VisibilityManager();
+	~VisibilityManager() = default;
+
+	void SetCollisionsManager(CollisionsManager* manager);
+	//Fields from previous ticks are recomputed when asked for again
+	void NextTick();
+	//Origin is center of observer collision box, nullptr without collisions
+	const FieldOfView* GetFieldOfView(const Entity* observer, float radius);
+	void Forget(const Entity* observer);
+	void Clear();
+
+	uint64_t GetTick() const;
+};
@@ -20,14 +20,27 @@ Enemy::Enemy()
 	_avoidanceRadius = 0.0F;
 
 	_weapon = nullptr;
+	_ownsWeapon = true;
 }
 
 Enemy::~Enemy()
 {
-	if (_weapon != nullptr)
+	if (_weapon != nullptr && _ownsWeapon)
 		delete _weapon;
 }
 
+void Enemy::ResetFrom(const Enemy& other)
+{
+	Entity::ResetFrom(other);
+	SetWeapon(nullptr);
+
+	_tmpSpeed = other._tmpSpeed;
+	_inAttack = other._inAttack;
+	_tmpStop = other._tmpStop;
+	_aiEnabled = other._aiEnabled;
+	_avoidanceRadius = other._avoidanceRadius;
+}
+
 void Enemy::Update(bool tick, float delta)
 {
 	Entity::UpdateEntity(tick);
@@ -36,6 +49,8 @@ void Enemy::Update(bool tick, float delta)
 
 	if (GetHealth() <= 0)
 	{
+		if (_weapon != nullptr && _ownsWeapon)
+			delete _weapon;
 		_weapon = nullptr;
 		SetSpeed(0.f);
 	}
@@ -108,12 +123,21 @@ Weapon* Enemy::GetWeapon()
 	return _weapon;
 }
 
-void Enemy::SetWeapon(Weapon* weapon)
+void Enemy::SetWeapon(Weapon* weapon, bool owned)
 {
-	if (_weapon != nullptr)
+	if (_weapon != nullptr && _ownsWeapon)
 		delete _weapon;
 
 	_weapon = weapon;
+	_ownsWeapon = owned;
+}
+
+Weapon* Enemy::DetachWeapon()
+{
+	auto weapon = _weapon;
+	_weapon = nullptr;
+	_ownsWeapon = true;
+	return weapon;
 }
 
 void Enemy::draw(sf::RenderTarget& target, sf::RenderStates states) const
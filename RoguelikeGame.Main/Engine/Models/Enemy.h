@@ -7,6 +7,7 @@ class Enemy : public Entity
 {
 private:
 	Weapon* _weapon;
+	bool _ownsWeapon; //Pooled weapons are returned by whoever gave them
 
 	float _tmpSpeed;
 	bool _inAttack;
@@ -20,6 +21,8 @@ private:
 public:
 	Enemy();
 	~Enemy() override;
+	//Weapon is not copied, this enemy drops its own one
+	void ResetFrom(const Enemy& other);
 
 	void Update(bool tick, float delta);
 	void Attack();
@@ -35,5 +38,7 @@ public:
 
 	//Weapon
 	Weapon* GetWeapon();
-	void SetWeapon(Weapon* weapon);
+	void SetWeapon(Weapon* weapon, bool owned = true);
+	//Weapon is not deleted, caller gets it
+	Weapon* DetachWeapon();
 };
\ No newline at end of file
@@ -48,6 +48,24 @@ Entity::Entity(Entity& other) : sf::Collision(other)
 	_takingDmgSounds = other._takingDmgSounds;
 }
 
+void Entity::ResetFrom(const Entity& other)
+{
+	sf::Collision::ResetFrom(other);
+	_animations.ResetFrom(other._animations);
+	_dmgColor = other._dmgColor;
+	_dmgColorCounter = other._dmgColorCounter;
+	_dmgColorTick = other._dmgColorTick;
+	_health = other._health;
+	_isVisible = other._isVisible;
+	_speed = other._speed;
+	_state = other._state;
+	_step = other._step;
+	_transform = other._transform;
+	_viewRect = other._viewRect;
+	_sounds = other._sounds;
+	_takingDmgSounds = other._takingDmgSounds;
+}
+
 void Entity::TakeDmg(float dmg)
 {
 	_health -= dmg;
@@ -35,6 +35,8 @@ public:
 	Entity();
 	Entity(Entity& other);
 	~Entity() override = default;
+	//Copy of other which reuses containers of this entity
+	void ResetFrom(const Entity& other);
 
 	void TakeDmg(float dmg);
 	bool IsDead() const;
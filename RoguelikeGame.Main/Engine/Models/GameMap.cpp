@@ -13,6 +13,8 @@ GameMap<T>::GameMap()
 	_noTexture = Utilities::GetInstance()->NoTexture16x16();
 	_showGrid = false;
 	_actionMapGridColor = sf::Color(0, 0, 0, 255);
+	_dirtyActionMap = sf::IntRect(0, 0, 0, 0);
+	_changedActionTiles = sf::IntRect(0, 0, 0, 0);
 }
 
 template<typename T>
@@ -442,41 +444,13 @@ void GameMap<T>::PrepareFrame()
 		auto tileWidth = layer->second.tileWidth;
 		auto tileHeight = layer->second.tileHeight;
 
-		auto tilesName = layer->second.tilesName;
 		sf::Color opacity = sf::Color(255, 255, 255, (sf::Uint8)(layer->second.opacity * 255));
-
-		sf::Texture* texture = nullptr;
-		if (_tilesTextures.find(tilesName) == _tilesTextures.end() || _tilesTextures[tilesName]->getSize() == sf::Vector2u(0, 0))
-			texture = _noTexture;
-		else
-			texture = _tilesTextures[tilesName];
+		auto texture = GetTilesTexture(layer->second.tilesName);
 
 		vertex->resize((size_t)height * (size_t)width * 4);
-		for (size_t no = 0; no < _map[id].data.size(); no++)
-		{
-			if (layer->second.data[no] == 0) continue; //if empty tile
-
-			vertex->operator[]((no * 4) + 0).position = sf::Vector2f((float)((no % width) * tileWidth), (float)((no / width) * tileHeight));
-			vertex->operator[]((no * 4) + 1).position = sf::Vector2f((float)((no % width) * tileWidth + tileWidth), (float)((no / width) * tileHeight));
-			vertex->operator[]((no * 4) + 2).position = sf::Vector2f((float)((no % width) * tileWidth + tileWidth), (float)((no / width) * tileHeight + tileHeight));
-			vertex->operator[]((no * 4) + 3).position = sf::Vector2f((float)((no % width) * tileWidth), (float)((no / width) * tileHeight + tileHeight));
-
-			sf::IntRect rect;
-			if (texture == _noTexture)
-				rect = TilesHelper::GetTileRect(sf::Vector2u(16, 16), 16, 16, 0);
-			else
-				rect = TilesHelper::GetTileRect(texture->getSize(), layer->second.tileWidth, layer->second.tileHeight, layer->second.data[no] - 1);
-
-			vertex->operator[]((no * 4) + 0).texCoords = sf::Vector2f((float)rect.left, (float)rect.top);
-			vertex->operator[]((no * 4) + 1).texCoords = sf::Vector2f((float)rect.left + (float)rect.width, (float)rect.top);
-			vertex->operator[]((no * 4) + 2).texCoords = sf::Vector2f((float)rect.left + (float)rect.width, (float)rect.top + (float)rect.height);
-			vertex->operator[]((no * 4) + 3).texCoords = sf::Vector2f((float)rect.left, (float)rect.top + (float)rect.height);
-
-			vertex->operator[]((no * 4) + 0).color = opacity;
-			vertex->operator[]((no * 4) + 1).color = opacity;
-			vertex->operator[]((no * 4) + 2).color = opacity;
-			vertex->operator[]((no * 4) + 3).color = opacity;
-		}
+		for (size_t no = 0; no < layer->second.data.size(); no++)
+			PrepareTileVertices(*vertex, no, width, tileWidth, tileHeight, (int)layer->second.data[no], texture, opacity);
+		_dirtyLayers.erase(id);
 		_layerTransform[id].setPosition(offsetX, offsetY);
 	}
 
@@ -502,41 +476,13 @@ void GameMap<T>::PrepareActionMapLayer()
 	auto tileWidth = layer->tileWidth;
 	auto tileHeight = layer->tileHeight;
 
-	auto& tilesName = layer->tilesName;
 	sf::Color opacity = sf::Color(255, 255, 255, (sf::Uint8)(layer->opacity * 255));
-
-	sf::Texture* texture = nullptr;
-	if (_tilesTextures.find(tilesName) == _tilesTextures.end() || _tilesTextures[tilesName]->getSize() == sf::Vector2u(0, 0))
-		texture = _noTexture;
-	else
-		texture = _tilesTextures[tilesName];
+	auto texture = GetTilesTexture(layer->tilesName);
 
 	vertex->resize((size_t)height * (size_t)width * 4);
 	for (size_t no = 0; no < _actionMap.data.size(); no++)
-	{
-		if (layer->data[no] == 0) continue; //if empty tile
-
-		vertex->operator[]((no * 4) + 0).position = sf::Vector2f((float)((no % width) * tileWidth), (float)((no / width) * tileHeight));
-		vertex->operator[]((no * 4) + 1).position = sf::Vector2f((float)((no % width) * tileWidth + tileWidth), (float)((no / width) * tileHeight));
-		vertex->operator[]((no * 4) + 2).position = sf::Vector2f((float)((no % width) * tileWidth + tileWidth), (float)((no / width) * tileHeight + tileHeight));
-		vertex->operator[]((no * 4) + 3).position = sf::Vector2f((float)((no % width) * tileWidth), (float)((no / width) * tileHeight + tileHeight));
-
-		sf::IntRect rect;
-		if (texture == _noTexture)
-			rect = TilesHelper::GetTileRect(sf::Vector2u(16, 16), 16, 16, 0);
-		else
-			rect = TilesHelper::GetTileRect(texture->getSize(), layer->tileWidth, layer->tileHeight, layer->data[no] - 1);
-
-		vertex->operator[]((no * 4) + 0).texCoords = sf::Vector2f((float)rect.left, (float)rect.top);
-		vertex->operator[]((no * 4) + 1).texCoords = sf::Vector2f((float)rect.left + (float)rect.width, (float)rect.top);
-		vertex->operator[]((no * 4) + 2).texCoords = sf::Vector2f((float)rect.left + (float)rect.width, (float)rect.top + (float)rect.height);
-		vertex->operator[]((no * 4) + 3).texCoords = sf::Vector2f((float)rect.left, (float)rect.top + (float)rect.height);
-
-		vertex->operator[]((no * 4) + 0).color = opacity;
-		vertex->operator[]((no * 4) + 1).color = opacity;
-		vertex->operator[]((no * 4) + 2).color = opacity;
-		vertex->operator[]((no * 4) + 3).color = opacity;
-	}
+		PrepareTileVertices(*vertex, no, width, tileWidth, tileHeight, (int)layer->data[no], texture, opacity);
+	_dirtyActionMap = sf::IntRect(0, 0, 0, 0);
 	_actionMapTransform.setPosition(layer->offsetX, layer->offsetY);
 }
 
@@ -578,6 +524,162 @@ void GameMap<T>::PrepareActionMapGrid()
 	}
 }
 
+template<typename T>
+void GameMap<T>::PrepareTileVertices(sf::VertexArray& vertex, size_t no, unsigned int width, unsigned int tileWidth, unsigned int tileHeight, int tile, const sf::Texture* texture, const sf::Color& color) const
+{
+	//Empty tile gets degenerate quad
+	if (tile == 0)
+	{
+		for (size_t i = 0; i < 4; i++)
+			vertex[(no * 4) + i] = sf::Vertex();
+		return;
+	}
+
+	auto left = (float)((no % width) * tileWidth);
+	auto top = (float)((no / width) * tileHeight);
+	vertex[(no * 4) + 0].position = sf::Vector2f(left, top);
+	vertex[(no * 4) + 1].position = sf::Vector2f(left + (float)tileWidth, top);
+	vertex[(no * 4) + 2].position = sf::Vector2f(left + (float)tileWidth, top + (float)tileHeight);
+	vertex[(no * 4) + 3].position = sf::Vector2f(left, top + (float)tileHeight);
+
+	sf::IntRect rect;
+	if (texture == _noTexture)
+		rect = TilesHelper::GetTileRect(sf::Vector2u(16, 16), 16, 16, 0);
+	else
+		rect = TilesHelper::GetTileRect(texture->getSize(), tileWidth, tileHeight, tile - 1);
+
+	vertex[(no * 4) + 0].texCoords = sf::Vector2f((float)rect.left, (float)rect.top);
+	vertex[(no * 4) + 1].texCoords = sf::Vector2f((float)rect.left + (float)rect.width, (float)rect.top);
+	vertex[(no * 4) + 2].texCoords = sf::Vector2f((float)rect.left + (float)rect.width, (float)rect.top + (float)rect.height);
+	vertex[(no * 4) + 3].texCoords = sf::Vector2f((float)rect.left, (float)rect.top + (float)rect.height);
+
+	for (size_t i = 0; i < 4; i++)
+		vertex[(no * 4) + i].color = color;
+}
+
+template<typename T>
+sf::Texture* GameMap<T>::GetTilesTexture(const std::string& tilesName)
+{
+	auto found = _tilesTextures.find(tilesName);
+	if (found == _tilesTextures.end() || found->second == nullptr || found->second->getSize() == sf::Vector2u(0, 0))
+		return _noTexture;
+	return found->second;
+}
+
+template<typename T>
+void GameMap<T>::ExtendDirtyRect(sf::IntRect& rect, int x, int y)
+{
+	if (rect.width == 0)
+	{
+		rect = sf::IntRect(x, y, 1, 1);
+		return;
+	}
+
+	int right = std::max(rect.left + rect.width, x + 1);
+	int bottom = std::max(rect.top + rect.height, y + 1);
+	rect.left = std::min(rect.left, x);
+	rect.top = std::min(rect.top, y);
+	rect.width = right - rect.left;
+	rect.height = bottom - rect.top;
+}
+
+template<typename T>
+void GameMap<T>::PrepareDirtyTiles()
+{
+	for (auto& dirty : _dirtyLayers)
+	{
+		auto layer = _map.find(dirty.first);
+		auto vertex = _layerVertices.find(dirty.first);
+		if (layer == _map.end() || vertex == _layerVertices.end()) continue;
+
+		//Hidden layer has no vertices, PrepareFrame builds it whole
+		auto& tiles = layer->second;
+		if (vertex->second.getVertexCount() != tiles.data.size() * 4) continue;
+
+		sf::Color opacity = sf::Color(255, 255, 255, (sf::Uint8)(tiles.opacity * 255));
+		auto texture = GetTilesTexture(tiles.tilesName);
+		auto& rect = dirty.second;
+		for (int y = rect.top; y < rect.top + rect.height; y++)
+			for (int x = rect.left; x < rect.left + rect.width; x++)
+			{
+				size_t no = (size_t)y * tiles.width + x;
+				PrepareTileVertices(vertex->second, no, tiles.width, tiles.tileWidth, tiles.tileHeight, (int)tiles.data[no], texture, opacity);
+			}
+	}
+	_dirtyLayers.clear();
+
+	if (_dirtyActionMap.width > 0 && _actionMapVertices.getVertexCount() == _actionMap.data.size() * 4)
+	{
+		sf::Color opacity = sf::Color(255, 255, 255, (sf::Uint8)(_actionMap.opacity * 255));
+		auto texture = GetTilesTexture(_actionMap.tilesName);
+		for (int y = _dirtyActionMap.top; y < _dirtyActionMap.top + _dirtyActionMap.height; y++)
+			for (int x = _dirtyActionMap.left; x < _dirtyActionMap.left + _dirtyActionMap.width; x++)
+			{
+				size_t no = (size_t)y * _actionMap.width + x;
+				PrepareTileVertices(_actionMapVertices, no, _actionMap.width, _actionMap.tileWidth, _actionMap.tileHeight, (int)_actionMap.data[no], texture, opacity);
+			}
+	}
+	_dirtyActionMap = sf::IntRect(0, 0, 0, 0);
+}
+
+template<typename T>
+bool GameMap<T>::SetTile(unsigned int layerId, unsigned int x, unsigned int y, T value)
+{
+	auto found = _map.find(layerId);
+	if (found == _map.end()) return false;
+
+	auto& layer = found->second;
+	if (x >= layer.width || y >= layer.height) return false;
+
+	auto& tile = layer.data[(size_t)y * layer.width + x];
+	if (tile == value) return true;
+
+	tile = value;
+	ExtendDirtyRect(_dirtyLayers[layerId], (int)x, (int)y);
+	return true;
+}
+
+template<typename T>
+T GameMap<T>::GetTile(unsigned int layerId, unsigned int x, unsigned int y) const
+{
+	auto found = _map.find(layerId);
+	if (found == _map.end() || x >= found->second.width || y >= found->second.height) return T();
+	return found->second.data[(size_t)y * found->second.width + x];
+}
+
+template<typename T>
+bool GameMap<T>::SetActionTile(unsigned int x, unsigned int y, unsigned char value)
+{
+	if (x >= _actionMap.width || y >= _actionMap.height) return false;
+
+	auto& tile = _actionMap.data[(size_t)y * _actionMap.width + x];
+	if (tile == value) return true;
+
+	tile = value;
+	ExtendDirtyRect(_dirtyActionMap, (int)x, (int)y);
+	ExtendDirtyRect(_changedActionTiles, (int)x, (int)y);
+	return true;
+}
+
+template<typename T>
+unsigned char GameMap<T>::GetActionTile(unsigned int x, unsigned int y) const
+{
+	if (x >= _actionMap.width || y >= _actionMap.height) return 0;
+	return _actionMap.data[(size_t)y * _actionMap.width + x];
+}
+
+template<typename T>
+const sf::IntRect& GameMap<T>::GetChangedActionTiles() const
+{
+	return _changedActionTiles;
+}
+
+template<typename T>
+void GameMap<T>::ClearChangedActionTiles()
+{
+	_changedActionTiles = sf::IntRect(0, 0, 0, 0);
+}
+
 template<typename T>
 void GameMap<T>::SetLayerVertexOpacity(unsigned int layerId, float opacity)
 {
@@ -635,6 +737,13 @@ template void GameMap<int>::SetActionMapGridColor(const sf::Color& col);
 template void GameMap<int>::SetActionMapGridVisibility(bool visible);
 template void GameMap<int>::ToggleGridVisibility();
 template void GameMap<int>::ToggleActionMapVisibility();
+template void GameMap<int>::PrepareDirtyTiles();
+template bool GameMap<int>::SetTile(unsigned int layerId, unsigned int x, unsigned int y, int value);
+template int GameMap<int>::GetTile(unsigned int layerId, unsigned int x, unsigned int y) const;
+template bool GameMap<int>::SetActionTile(unsigned int x, unsigned int y, unsigned char value);
+template unsigned char GameMap<int>::GetActionTile(unsigned int x, unsigned int y) const;
+template const sf::IntRect& GameMap<int>::GetChangedActionTiles() const;
+template void GameMap<int>::ClearChangedActionTiles();
 
 template void GameMap<char>::draw(sf::RenderTarget& target, sf::RenderStates states) const;
 template GameMap<char>::GameMap();
@@ -671,6 +780,13 @@ template void GameMap<char>::SetActionMapGridColor(const sf::Color& col);
 template void GameMap<char>::SetActionMapGridVisibility(bool visible);
 template void GameMap<char>::ToggleGridVisibility();
 template void GameMap<char>::ToggleActionMapVisibility();
+template void GameMap<char>::PrepareDirtyTiles();
+template bool GameMap<char>::SetTile(unsigned int layerId, unsigned int x, unsigned int y, char value);
+template char GameMap<char>::GetTile(unsigned int layerId, unsigned int x, unsigned int y) const;
+template bool GameMap<char>::SetActionTile(unsigned int x, unsigned int y, unsigned char value);
+template unsigned char GameMap<char>::GetActionTile(unsigned int x, unsigned int y) const;
+template const sf::IntRect& GameMap<char>::GetChangedActionTiles() const;
+template void GameMap<char>::ClearChangedActionTiles();
 
 template void GameMap<short>::draw(sf::RenderTarget& target, sf::RenderStates states) const;
 template GameMap<short>::GameMap();
@@ -707,6 +823,13 @@ template void GameMap<short>::SetActionMapGridColor(const sf::Color& col);
 template void GameMap<short>::SetActionMapGridVisibility(bool visible);
 template void GameMap<short>::ToggleGridVisibility();
 template void GameMap<short>::ToggleActionMapVisibility();
+template void GameMap<short>::PrepareDirtyTiles();
+template bool GameMap<short>::SetTile(unsigned int layerId, unsigned int x, unsigned int y, short value);
+template short GameMap<short>::GetTile(unsigned int layerId, unsigned int x, unsigned int y) const;
+template bool GameMap<short>::SetActionTile(unsigned int x, unsigned int y, unsigned char value);
+template unsigned char GameMap<short>::GetActionTile(unsigned int x, unsigned int y) const;
+template const sf::IntRect& GameMap<short>::GetChangedActionTiles() const;
+template void GameMap<short>::ClearChangedActionTiles();
 #pragma endregion
 
 #pragma region TemplateImplementationUnsigned
@@ -745,6 +868,13 @@ template void GameMap<unsigned int>::SetActionMapGridColor(const sf::Color& col)
 template void GameMap<unsigned int>::SetActionMapGridVisibility(bool visible);
 template void GameMap<unsigned int>::ToggleGridVisibility();
 template void GameMap<unsigned int>::ToggleActionMapVisibility();
+template void GameMap<unsigned int>::PrepareDirtyTiles();
+template bool GameMap<unsigned int>::SetTile(unsigned int layerId, unsigned int x, unsigned int y, unsigned int value);
+template unsigned int GameMap<unsigned int>::GetTile(unsigned int layerId, unsigned int x, unsigned int y) const;
+template bool GameMap<unsigned int>::SetActionTile(unsigned int x, unsigned int y, unsigned char value);
+template unsigned char GameMap<unsigned int>::GetActionTile(unsigned int x, unsigned int y) const;
+template const sf::IntRect& GameMap<unsigned int>::GetChangedActionTiles() const;
+template void GameMap<unsigned int>::ClearChangedActionTiles();
 
 template void GameMap<unsigned char>::draw(sf::RenderTarget& target, sf::RenderStates states) const;
 template GameMap<unsigned char>::GameMap();
@@ -781,6 +911,13 @@ template void GameMap<unsigned char>::SetActionMapGridColor(const sf::Color& col
 template void GameMap<unsigned char>::SetActionMapGridVisibility(bool visible);
 template void GameMap<unsigned char>::ToggleGridVisibility();
 template void GameMap<unsigned char>::ToggleActionMapVisibility();
+template void GameMap<unsigned char>::PrepareDirtyTiles();
+template bool GameMap<unsigned char>::SetTile(unsigned int layerId, unsigned int x, unsigned int y, unsigned char value);
+template unsigned char GameMap<unsigned char>::GetTile(unsigned int layerId, unsigned int x, unsigned int y) const;
+template bool GameMap<unsigned char>::SetActionTile(unsigned int x, unsigned int y, unsigned char value);
+template unsigned char GameMap<unsigned char>::GetActionTile(unsigned int x, unsigned int y) const;
+template const sf::IntRect& GameMap<unsigned char>::GetChangedActionTiles() const;
+template void GameMap<unsigned char>::ClearChangedActionTiles();
 
 template void GameMap<unsigned short>::draw(sf::RenderTarget& target, sf::RenderStates states) const;
 template GameMap<unsigned short>::GameMap();
@@ -817,4 +954,11 @@ template void GameMap<unsigned short>::SetActionMapGridColor(const sf::Color& co
 template void GameMap<unsigned short>::SetActionMapGridVisibility(bool visible);
 template void GameMap<unsigned short>::ToggleGridVisibility();
 template void GameMap<unsigned short>::ToggleActionMapVisibility();
+template void GameMap<unsigned short>::PrepareDirtyTiles();
+template bool GameMap<unsigned short>::SetTile(unsigned int layerId, unsigned int x, unsigned int y, unsigned short value);
+template unsigned short GameMap<unsigned short>::GetTile(unsigned int layerId, unsigned int x, unsigned int y) const;
+template bool GameMap<unsigned short>::SetActionTile(unsigned int x, unsigned int y, unsigned char value);
+template unsigned char GameMap<unsigned short>::GetActionTile(unsigned int x, unsigned int y) const;
+template const sf::IntRect& GameMap<unsigned short>::GetChangedActionTiles() const;
+template void GameMap<unsigned short>::ClearChangedActionTiles();
 #pragma endregion
@@ -39,6 +39,11 @@ private:
 	sf::Color _actionMapGridColor;
 	bool _showGrid;
 
+	//Tiles changed since vertices were prepared, zero width if none
+	std::unordered_map<unsigned int, sf::IntRect> _dirtyLayers;
+	sf::IntRect _dirtyActionMap;
+	sf::IntRect _changedActionTiles; //Kept until collisions take them
+
 	sf::Vector2u _mapSize;
 
 	Logger* _logger;
@@ -51,6 +56,9 @@ private:
 
 	void PrepareActionMapLayer();
 	void PrepareActionMapGrid();
+	void PrepareTileVertices(sf::VertexArray& vertex, size_t no, unsigned int width, unsigned int tileWidth, unsigned int tileHeight, int tile, const sf::Texture* texture, const sf::Color& color) const;
+	sf::Texture* GetTilesTexture(const std::string& tilesName);
+	static void ExtendDirtyRect(sf::IntRect& rect, int x, int y);
 public:
 
 	GameMap();
@@ -59,6 +67,8 @@ public:
 	bool LoadFromFile(const std::string& path);
 
 	void PrepareFrame();
+	//Updates vertices of tiles changed since last call only
+	void PrepareDirtyTiles();
 
 	void SetTilesTexture(const std::string& tilesName, sf::Texture* texture);
 	bool AutoSetTilesTextures(TexturesManager* manager);
@@ -94,6 +104,15 @@ public:
 	void SetActionMapGridColor(const sf::Color& col);
 	void SetActionMapGridVisibility(bool visible);
 
+	//Tiles changes, vertices are updated in PrepareDirtyTiles
+	bool SetTile(unsigned int layerId, unsigned int x, unsigned int y, T value);
+	T GetTile(unsigned int layerId, unsigned int x, unsigned int y) const;
+	bool SetActionTile(unsigned int x, unsigned int y, unsigned char value);
+	unsigned char GetActionTile(unsigned int x, unsigned int y) const;
+	//Action map tiles changed since last clear, zero width if none
+	const sf::IntRect& GetChangedActionTiles() const;
+	void ClearChangedActionTiles();
+
 	void ToggleGridVisibility();
 	void ToggleActionMapVisibility();
 };
@@ -10,6 +10,12 @@ HitboxWeapon::HitboxWeapon(HitboxWeapon& other) : Weapon(other)
 	_hitSounds = other._hitSounds;
 }
 
+void HitboxWeapon::ResetFrom(const HitboxWeapon& other)
+{
+	Weapon::ResetFrom(other);
+	_hitSounds = other._hitSounds;
+}
+
 bool HitboxWeapon::CanAttack() const
 {
     return (_cooldownCounter >= GetWeaponCooldown());
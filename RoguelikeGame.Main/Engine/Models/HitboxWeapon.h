@@ -12,6 +12,7 @@ public:
 	HitboxWeapon();
 	HitboxWeapon(HitboxWeapon& other);
 	~HitboxWeapon() override = default;
+	void ResetFrom(const HitboxWeapon& other);
 
 	// Inherited via Weapon
 	bool CanAttack() const override;
@@ -48,6 +48,15 @@ MeleeWeapon::MeleeWeapon(MeleeWeapon& other) : Weapon(other)
 	_swingSounds = other._swingSounds;
 }
 
+void MeleeWeapon::ResetFrom(const MeleeWeapon& other)
+{
+	Weapon::ResetFrom(other);
+	_angle = other._angle;
+	_range = other._range;
+	_hitboxAccuracy = other._hitboxAccuracy;
+	_swingSounds = other._swingSounds;
+}
+
 bool MeleeWeapon::CanAttack() const
 {
 	return (_cooldownCounter >= GetWeaponCooldown());
@@ -21,6 +21,7 @@ public:
 	MeleeWeapon();
 	MeleeWeapon(MeleeWeapon& other);
 	~MeleeWeapon() override = default;
+	void ResetFrom(const MeleeWeapon& other);
 
 	// Inherited via Weapon
 	bool CanAttack() const override;
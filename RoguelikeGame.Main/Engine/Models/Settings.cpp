@@ -22,6 +22,9 @@ Settings::Settings()
 	MOVE_DOWN = sf::Keyboard::Down;
 	MOVE_LEFT = sf::Keyboard::Left;
 	MOVE_RIGHT = sf::Keyboard::Right;
+
+	AI_WORKERS = 0;
+	AI_BUDGET_US = 2000;
 }
 
 Settings* Settings::GetInstance()
@@ -64,6 +67,9 @@ bool Settings::LoadSettings(const std::string& path)
 	IF_EXIST_ASSIGN(doc, "MOVE_LEFT", MOVE_LEFT.data);
 	IF_EXIST_ASSIGN(doc, "MOVE_RIGHT", MOVE_RIGHT.data);
 
+	IF_EXIST_ASSIGN(doc, "AI_WORKERS", AI_WORKERS.data);
+	IF_EXIST_ASSIGN(doc, "AI_BUDGET_US", AI_BUDGET_US.data);
+
 	SCALE_RATIO = float(WINDOW_SIZE.data.x) / 1024.f;
 
 	return true;
@@ -84,7 +90,9 @@ bool Settings::SaveSettings(const std::string& path)
 		{"MOVE_UP", MOVE_UP.data},
 		{"MOVE_DOWN", MOVE_DOWN.data},
 		{"MOVE_LEFT", MOVE_LEFT.data},
-		{"MOVE_RIGHT", MOVE_RIGHT.data}
+		{"MOVE_RIGHT", MOVE_RIGHT.data},
+		{"AI_WORKERS", AI_WORKERS.data},
+		{"AI_BUDGET_US", AI_BUDGET_US.data}
 	};
 
 	std::ofstream stream;
@@ -52,5 +52,8 @@ public:
 	Option<sf::Keyboard::Key> MOVE_DOWN;
 	Option<sf::Keyboard::Key> MOVE_LEFT;
 	Option<sf::Keyboard::Key> MOVE_RIGHT;
+
+	Option<uint32_t> AI_WORKERS; //Threads updating enemies, 0 means all cores
+	Option<uint32_t> AI_BUDGET_US; //Microseconds per update for enemies thinking off screen
 };
 
@@ -44,6 +44,31 @@ Weapon::Weapon(Weapon& other) : Weapon(other._weaponType)
 	setScale(other.getScale());
 }
 
+void Weapon::ResetFrom(const Weapon& other)
+{
+	_cooldownCounter = other._cooldownCounter;
+	_weapon = other._weapon;
+	_attackAnimation.ResetFrom(other._attackAnimation);
+	_attackAnimation.SetTarget(_weapon.ExternalTransform());
+	_currentAngle = other._currentAngle;
+	_hitbox = other._hitbox;
+	_raycast = other._raycast;
+	_dmg = other._dmg;
+	_attackCooldown = other._attackCooldown;
+	_isVisible = other._isVisible;
+	_showHitbox = other._showHitbox;
+	_showRaycast = other._showRaycast;
+	_hitboxColor = other._hitboxColor;
+	_raycastColor = other._raycastColor;
+	_weaponType = other._weaponType;
+	_sounds = other._sounds;
+
+	setPosition(other.getPosition());
+	setOrigin(other.getOrigin());
+	setRotation(other.getRotation());
+	setScale(other.getScale());
+}
+
 void Weapon::ResetCooldown()
 {
 	_cooldownCounter = 0;
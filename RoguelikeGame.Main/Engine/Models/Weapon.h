@@ -39,6 +39,8 @@ public:
 	Weapon(WeaponType type);
 	Weapon(Weapon& other);
 	virtual ~Weapon() { ; }
+	//Copy of other which reuses buffers, attack animation moves this weapon
+	void ResetFrom(const Weapon& other);
 	virtual Weapon* clone() = 0;
 
 	virtual bool CanAttack() const = 0;
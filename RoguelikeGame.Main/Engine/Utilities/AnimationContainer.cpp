@@ -57,6 +57,31 @@ namespace sf
 			_currentAnimation = &((*it).second);
 	}
 
+	void AnimationContainer::ResetFrom(const AnimationContainer& other)
+	{
+		bool sameStates = (_animationStates.size() == other._animationStates.size());
+		auto otherIt = other._animationStates.begin();
+		for (auto it = _animationStates.begin(); sameStates && it != _animationStates.end(); it++, otherIt++)
+			sameStates = (it->first == otherIt->first);
+
+		if (sameStates) //Assigned in place, so frames keep their buffers
+		{
+			auto it = _animationStates.begin();
+			for (auto& state : other._animationStates)
+				(it++)->second = state.second;
+		}
+		else
+			_animationStates = other._animationStates;
+
+		_currentState = other._currentState;
+		_smoothChangeState = other._smoothChangeState;
+		_smoothChangePrevLoop = other._smoothChangePrevLoop;
+		_noTexture = other._noTexture;
+		_noTextureVertex = other._noTextureVertex;
+		_noTextureTransform = other._noTextureTransform;
+		UpdateCurrentAnimationPtr();
+	}
+
 	void AnimationContainer::SetStateAnimation(const std::string& state, const sf::Animation& animation)
 	{
 		_animationStates[state] = animation;
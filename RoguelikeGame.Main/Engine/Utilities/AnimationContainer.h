@@ -30,6 +30,8 @@ namespace sf
 
 		void Tick(bool tick);
 		void UpdateCurrentAnimationPtr();
+		//Copy of other which reuses animations of same states, current animation points into this container
+		void ResetFrom(const AnimationContainer& other);
 
 		//AnimationContainer setters
 		void SetStateAnimation(const std::string& state, const sf::Animation& animation);
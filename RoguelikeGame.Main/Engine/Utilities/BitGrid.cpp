@@ -0,0 +1,140 @@
+#include "BitGrid.h"
+
+BitGrid::BitGrid()
+{
+	_width = 0;
+	_height = 0;
+	_wordsPerRow = 0;
+}
+
+unsigned int BitGrid::LowestBit(uint64_t word)
+{
+#if defined(_MSC_VER) && defined(_M_X64)
+	unsigned long index = 0;
+	_BitScanForward64(&index, word);
+	return (unsigned int)index;
+#elif defined(__GNUC__)
+	return (unsigned int)__builtin_ctzll(word);
+#else
+	unsigned int index = 0;
+	while ((word & 1) == 0)
+	{
+		word >>= 1;
+		index++;
+	}
+	return index;
+#endif
+}
+
+uint64_t BitGrid::GetMask(unsigned int first, unsigned int last)
+{
+	uint64_t upper = (last >= 63) ? UINT64_MAX : ((uint64_t)1 << (last + 1)) - 1;
+	return upper & (UINT64_MAX << first);
+}
+
+bool BitGrid::ClipRect(const sf::IntRect& rect, int& left, int& top, int& right, int& bottom) const
+{
+	left = std::max(rect.left, 0);
+	top = std::max(rect.top, 0);
+	right = std::min(rect.left + rect.width - 1, (int)_width - 1);
+	bottom = std::min(rect.top + rect.height - 1, (int)_height - 1);
+	return (left <= right && top <= bottom);
+}
+
+void BitGrid::Resize(unsigned int width, unsigned int height)
+{
+	_width = width;
+	_height = height;
+	_wordsPerRow = (width + 63) / 64;
+	_words.assign((size_t)_wordsPerRow * height, 0);
+}
+
+void BitGrid::Clear()
+{
+	std::fill(_words.begin(), _words.end(), 0);
+}
+
+void BitGrid::Set(int x, int y, bool value)
+{
+	if (x < 0 || y < 0 || x >= (int)_width || y >= (int)_height) return;
+
+	auto& word = _words[(size_t)y * _wordsPerRow + (unsigned int)x / 64];
+	uint64_t bit = (uint64_t)1 << ((unsigned int)x % 64);
+	if (value) word |= bit;
+	else word &= ~bit;
+}
+
+bool BitGrid::Get(int x, int y) const
+{
+	if (x < 0 || y < 0 || x >= (int)_width || y >= (int)_height) return false;
+	return ((_words[(size_t)y * _wordsPerRow + (unsigned int)x / 64] >> ((unsigned int)x % 64)) & 1) != 0;
+}
+
+void BitGrid::Merge(const BitGrid& other)
+{
+	unsigned int rows = std::min(_height, other._height);
+	unsigned int words = std::min(_wordsPerRow, other._wordsPerRow);
+	uint64_t lastMask = (_width % 64 == 0) ? UINT64_MAX : GetMask(0, _width % 64 - 1);
+	for (unsigned int y = 0; y < rows; y++)
+	{
+		auto row = &_words[(size_t)y * _wordsPerRow];
+		auto otherRow = &other._words[(size_t)y * other._wordsPerRow];
+		for (unsigned int w = 0; w < words; w++)
+			row[w] |= otherRow[w];
+
+		//Wider rows of other would leave bits past width
+		if (words == _wordsPerRow && words > 0)
+			row[words - 1] &= lastMask;
+	}
+}
+
+void BitGrid::CopyTo(std::vector<bool>& output) const
+{
+	output.assign((size_t)_width * _height, false);
+	FindInRect(sf::IntRect(0, 0, (int)_width, (int)_height), [&](int x, int y)
+	{
+		output[(size_t)y * _width + x] = true;
+		return false;
+	});
+}
+
+bool BitGrid::AnyInRect(const sf::IntRect& rect) const
+{
+	int left, top, right, bottom;
+	if (ClipRect(rect, left, top, right, bottom) == false) return false;
+
+	unsigned int firstWord = (unsigned int)left / 64;
+	unsigned int lastWord = (unsigned int)right / 64;
+	uint64_t firstMask = GetMask((unsigned int)left % 64, (firstWord == lastWord) ? (unsigned int)right % 64 : 63);
+	uint64_t lastMask = GetMask(0, (unsigned int)right % 64);
+	for (int y = top; y <= bottom; y++)
+	{
+		auto row = &_words[(size_t)y * _wordsPerRow];
+		if (row[firstWord] & firstMask) return true;
+		for (unsigned int w = firstWord + 1; w < lastWord; w++)
+			if (row[w] != 0) return true;
+		if (lastWord != firstWord && (row[lastWord] & lastMask)) return true;
+	}
+	return false;
+}
+
+unsigned int BitGrid::GetWidth() const
+{
+	return _width;
+}
+
+unsigned int BitGrid::GetHeight() const
+{
+	return _height;
+}
+
+const uint64_t* BitGrid::GetRow(int y) const
+{
+	if (y < 0 || y >= (int)_height) return nullptr;
+	return &_words[(size_t)y * _wordsPerRow];
+}
+
+unsigned int BitGrid::GetWordsPerRow() const
+{
+	return _wordsPerRow;
+}
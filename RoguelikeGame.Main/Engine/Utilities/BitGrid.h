@@ -0,0 +1,78 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+
+#include "SFML/Graphics/Rect.hpp"
+
+#if defined(_MSC_VER) && defined(_M_X64)
+#include <intrin.h>
+#endif
+
+//Grid of flags packed 64 per word, every row starts at new word
+class BitGrid
+{
+private:
+	unsigned int _width;
+	unsigned int _height;
+	unsigned int _wordsPerRow;
+	std::vector<uint64_t> _words;
+
+	static unsigned int LowestBit(uint64_t word);
+	//Mask of bits from first to last (both included) in one word
+	static uint64_t GetMask(unsigned int first, unsigned int last);
+	//Clips rect to grid, returns false if nothing is left
+	bool ClipRect(const sf::IntRect& rect, int& left, int& top, int& right, int& bottom) const;
+public:
+	BitGrid();
+	~BitGrid() = default;
+
+	//All flags are cleared
+	void Resize(unsigned int width, unsigned int height);
+	void Clear();
+
+	void Set(int x, int y, bool value);
+	bool Get(int x, int y) const; //False outside grid
+
+	//OR-merges other grid, rows are aligned to left edge
+	void Merge(const BitGrid& other);
+	//Writes flags into row-major vector of width * height
+	void CopyTo(std::vector<bool>& output) const;
+
+	//Rect in tiles, parts outside grid are ignored
+	bool AnyInRect(const sf::IntRect& rect) const;
+	//Calls callback(x, y) for every set flag in rect, row by row, stops when callback returns true
+	template<typename F>
+	bool FindInRect(const sf::IntRect& rect, F callback) const;
+
+	unsigned int GetWidth() const;
+	unsigned int GetHeight() const;
+	const uint64_t* GetRow(int y) const;
+	unsigned int GetWordsPerRow() const;
+};
+
+template<typename F>
+inline bool BitGrid::FindInRect(const sf::IntRect& rect, F callback) const
+{
+	int left, top, right, bottom;
+	if (ClipRect(rect, left, top, right, bottom) == false) return false;
+
+	unsigned int firstWord = (unsigned int)left / 64;
+	unsigned int lastWord = (unsigned int)right / 64;
+	for (int y = top; y <= bottom; y++)
+	{
+		auto row = &_words[(size_t)y * _wordsPerRow];
+		for (unsigned int w = firstWord; w <= lastWord; w++)
+		{
+			auto word = row[w] & GetMask((w == firstWord) ? (unsigned int)left % 64 : 0, (w == lastWord) ? (unsigned int)right % 64 : 63);
+			while (word != 0)
+			{
+				if (callback((int)(w * 64 + LowestBit(word)), y))
+					return true;
+				word &= word - 1;
+			}
+		}
+	}
+	return false;
+}
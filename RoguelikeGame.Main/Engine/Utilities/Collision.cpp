@@ -18,6 +18,13 @@ sf::Collision::Collision(Collision& other)
 	_showHitbox = other._showHitbox;
 }
 
+void sf::Collision::ResetFrom(const Collision& other)
+{
+	_hitboxOffset = other._hitboxOffset;
+	_hitboxRecangle = other._hitboxRecangle;
+	_showHitbox = other._showHitbox;
+}
+
 sf::FloatRect sf::Collision::GetCollisionBox() const
 {
 	return _hitboxRecangle.getGlobalBounds();
@@ -24,6 +24,7 @@ namespace sf
 		Collision();
 		Collision(Collision& other);
 		~Collision() override = default;
+		void ResetFrom(const Collision& other);
 
 		sf::FloatRect GetCollisionBox() const;
 		sf::FloatRect GetCollisionBoxOffset() const;
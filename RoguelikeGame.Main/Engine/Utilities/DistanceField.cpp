@@ -0,0 +1,314 @@
+#include "DistanceField.h"
+
+const uint32_t DistanceField::NO_SITE;
+
+DistanceField::DistanceField()
+{
+	_blocked = nullptr;
+	_width = 0;
+	_height = 0;
+}
+
+bool DistanceField::IsSite(const Transform& transform, int x, int y) const
+{
+	bool blocked = _blocked->Get(x, y);
+	return (&transform == &_toBlocked) ? blocked : !blocked;
+}
+
+bool DistanceField::ColumnPass(Transform& transform, int x, std::vector<uint8_t>* changedRows)
+{
+	//Closest site above, then closest below
+	std::vector<uint32_t> above(_height, NO_SITE);
+	uint32_t last = NO_SITE;
+	for (unsigned int y = 0; y < _height; y++)
+	{
+		if (IsSite(transform, x, (int)y)) last = y;
+		above[y] = last;
+	}
+
+	bool changed = false;
+	float tileHeightSq = _tileSize.y * _tileSize.y;
+	last = NO_SITE;
+	for (int y = (int)_height - 1; y >= 0; y--)
+	{
+		if (IsSite(transform, x, y)) last = (uint32_t)y;
+
+		uint32_t site = above[y];
+		if (last != NO_SITE && (site == NO_SITE || last - (uint32_t)y < (uint32_t)y - site))
+			site = last;
+
+		float distance = INFINITY;
+		if (site != NO_SITE)
+		{
+			float rows = (float)((int)site - y);
+			distance = rows * rows * tileHeightSq;
+		}
+
+		size_t index = (size_t)y * _width + x;
+		if (transform.columnDistance[index] != distance || transform.columnSite[index] != site)
+		{
+			transform.columnDistance[index] = distance;
+			transform.columnSite[index] = site;
+			changed = true;
+			if (changedRows != nullptr) (*changedRows)[y] = 1;
+		}
+	}
+	return changed;
+}
+
+void DistanceField::RowPass(Transform& transform, int y)
+{
+	//Lower envelope of parabolas w * (q - v)^2 + f(v), only columns that have any site are used
+	const float* f = &transform.columnDistance[(size_t)y * _width];
+	double weight = (double)_tileSize.x * _tileSize.x;
+
+	_envelope.resize(_width);
+	_bounds.resize((size_t)_width + 1);
+	int k = -1;
+	for (int q = 0; q < (int)_width; q++)
+	{
+		if (f[q] == INFINITY) continue;
+
+		double s = -INFINITY;
+		while (k >= 0)
+		{
+			int v = _envelope[k];
+			s = (((double)f[q] + weight * q * q) - ((double)f[v] + weight * v * v)) / (2.0 * weight * (q - v));
+			if (s > _bounds[k]) break;
+			k--;
+		}
+		if (k < 0) s = -INFINITY;
+
+		k++;
+		_envelope[k] = q;
+		_bounds[k] = s;
+		_bounds[(size_t)k + 1] = INFINITY;
+	}
+
+	uint32_t* site = &transform.site[(size_t)y * _width];
+	if (k < 0)
+	{
+		std::fill(site, site + _width, NO_SITE);
+		return;
+	}
+
+	int current = 0;
+	for (int q = 0; q < (int)_width; q++)
+	{
+		while (_bounds[(size_t)current + 1] < (double)q)
+			current++;
+		int v = _envelope[current];
+		site[q] = transform.columnSite[(size_t)y * _width + v] * _width + (uint32_t)v;
+	}
+}
+
+void DistanceField::BuildTransform(Transform& transform)
+{
+	size_t size = (size_t)_width * _height;
+	transform.columnDistance.assign(size, INFINITY);
+	transform.columnSite.assign(size, NO_SITE);
+	transform.site.assign(size, NO_SITE);
+
+	for (unsigned int x = 0; x < _width; x++)
+		ColumnPass(transform, (int)x, nullptr);
+	for (unsigned int y = 0; y < _height; y++)
+		RowPass(transform, (int)y);
+}
+
+void DistanceField::UpdateClearance(int y)
+{
+	//Same candidates as point queries, so this is the smallest distance any point of tile can get
+	for (int x = 0; x < (int)_width; x++)
+	{
+		float best = INFINITY;
+		if (_blocked->Get(x, y))
+			best = 0.f;
+		else
+			for (int ny = std::max(y - 1, 0); ny <= std::min(y + 1, (int)_height - 1); ny++)
+				for (int nx = std::max(x - 1, 0); nx <= std::min(x + 1, (int)_width - 1); nx++)
+				{
+					uint32_t site = _toBlocked.site[(size_t)ny * _width + nx];
+					if (site == NO_SITE) continue;
+
+					float gapX = std::max(std::abs((float)((int)(site % _width) - x)) - 1.f, 0.f) * _tileSize.x;
+					float gapY = std::max(std::abs((float)((int)(site / _width) - y)) - 1.f, 0.f) * _tileSize.y;
+					best = std::min(best, gapX * gapX + gapY * gapY);
+				}
+		_clearance[(size_t)y * _width + x] = (best == INFINITY) ? INFINITY : std::sqrt(best);
+	}
+}
+
+sf::Vector2i DistanceField::GetTileOf(const sf::Vector2f& pos) const
+{
+	return sf::Vector2i((int)floor((pos.x - _offset.x) / _tileSize.x), (int)floor((pos.y - _offset.y) / _tileSize.y));
+}
+
+sf::FloatRect DistanceField::GetTileRect(uint32_t tile) const
+{
+	return sf::FloatRect((float)(tile % _width) * _tileSize.x + _offset.x, (float)(tile / _width) * _tileSize.y + _offset.y, _tileSize.x, _tileSize.y);
+}
+
+float DistanceField::GetClosestSitePoint(const Transform& transform, const sf::Vector2f& pos, sf::Vector2f& closest) const
+{
+	//Closest site of neighbour tiles may be closer to pos than site of its own tile
+	auto tile = GetTileOf(pos);
+	tile.x = std::min(std::max(tile.x, 0), (int)_width - 1);
+	tile.y = std::min(std::max(tile.y, 0), (int)_height - 1);
+
+	float best = INFINITY;
+	uint32_t lastSite = NO_SITE;
+	for (int y = std::max(tile.y - 1, 0); y <= std::min(tile.y + 1, (int)_height - 1); y++)
+		for (int x = std::max(tile.x - 1, 0); x <= std::min(tile.x + 1, (int)_width - 1); x++)
+		{
+			uint32_t site = transform.site[(size_t)y * _width + x];
+			if (site == NO_SITE || site == lastSite) continue;
+			lastSite = site;
+
+			auto rect = GetTileRect(site);
+			sf::Vector2f point(std::max(rect.left, std::min(pos.x, rect.left + rect.width)), std::max(rect.top, std::min(pos.y, rect.top + rect.height)));
+			auto diff = pos - point;
+			float distance = diff.x * diff.x + diff.y * diff.y;
+			if (distance < best)
+			{
+				best = distance;
+				closest = point;
+			}
+		}
+	return best;
+}
+
+void DistanceField::Build(const BitGrid* blocked, const MapLayerModel<bool>* tiles)
+{
+	Clear();
+	if (blocked == nullptr || blocked->GetWidth() == 0 || blocked->GetHeight() == 0 || tiles->tileWidth == 0 || tiles->tileHeight == 0)
+		return;
+
+	_blocked = blocked;
+	_width = blocked->GetWidth();
+	_height = blocked->GetHeight();
+	_tileSize = sf::Vector2f((float)tiles->tileWidth, (float)tiles->tileHeight);
+	_offset = sf::Vector2f(tiles->offsetX, tiles->offsetY);
+
+	BuildTransform(_toBlocked);
+	BuildTransform(_toFree);
+
+	_clearance.assign((size_t)_width * _height, INFINITY);
+	for (unsigned int y = 0; y < _height; y++)
+		UpdateClearance((int)y);
+}
+
+void DistanceField::Clear()
+{
+	_blocked = nullptr;
+	_width = 0;
+	_height = 0;
+	_toBlocked = Transform();
+	_toFree = Transform();
+	_clearance.clear();
+}
+
+void DistanceField::UpdateTiles(const sf::IntRect& changedTiles)
+{
+	if (IsBuilt() == false) return;
+
+	//Changed tiles affect only their columns in first pass, rows are redone only where column values changed
+	int left = std::max(changedTiles.left, 0);
+	int right = std::min(changedTiles.left + changedTiles.width, (int)_width);
+	std::vector<uint8_t> clearanceRows(_height, 0);
+	for (auto transform : { &_toBlocked, &_toFree })
+	{
+		std::vector<uint8_t> changedRows(_height, 0);
+		for (int x = left; x < right; x++)
+			ColumnPass(*transform, x, &changedRows);
+		for (unsigned int y = 0; y < _height; y++)
+			if (changedRows[y])
+			{
+				RowPass(*transform, (int)y);
+				for (int row = std::max((int)y - 1, 0); row <= std::min((int)y + 1, (int)_height - 1); row++)
+					clearanceRows[row] = 1;
+			}
+	}
+
+	//Clearance uses closest walls of neighbour tiles
+	for (int y = std::max(changedTiles.top - 1, 0); y < std::min(changedTiles.top + changedTiles.height + 1, (int)_height); y++)
+		clearanceRows[y] = 1;
+	for (unsigned int y = 0; y < _height; y++)
+		if (clearanceRows[y])
+			UpdateClearance((int)y);
+}
+
+bool DistanceField::IsBuilt() const
+{
+	return _blocked != nullptr;
+}
+
+float DistanceField::DistanceToWall(const sf::Vector2f& pos) const
+{
+	if (IsBuilt() == false) return INFINITY;
+
+	sf::Vector2f closest;
+	auto tile = GetTileOf(pos);
+	if (_blocked->Get(tile.x, tile.y) == false)
+	{
+		auto distance = GetClosestSitePoint(_toBlocked, pos, closest);
+		return (distance == INFINITY) ? INFINITY : std::sqrt(distance);
+	}
+
+	//Inside wall, space outside map counts as free
+	auto border = std::min(std::min(pos.x - _offset.x, _offset.x + (float)_width * _tileSize.x - pos.x),
+		std::min(pos.y - _offset.y, _offset.y + (float)_height * _tileSize.y - pos.y));
+	auto distance = GetClosestSitePoint(_toFree, pos, closest);
+	return -std::min(std::sqrt(distance), border);
+}
+
+float DistanceField::GetClearance(const sf::Vector2f& pos) const
+{
+	if (IsBuilt() == false) return INFINITY;
+
+	auto tile = GetTileOf(pos);
+	if (tile.x < 0 || tile.y < 0 || tile.x >= (int)_width || tile.y >= (int)_height) return 0.f;
+	return _clearance[(size_t)tile.y * _width + tile.x];
+}
+
+sf::Vector2f DistanceField::GradientAwayFromWall(const sf::Vector2f& pos) const
+{
+	if (IsBuilt() == false) return sf::Vector2f(0.f, 0.f);
+
+	sf::Vector2f closest;
+	sf::Vector2f direction;
+	auto tile = GetTileOf(pos);
+	if (_blocked->Get(tile.x, tile.y) == false)
+	{
+		if (GetClosestSitePoint(_toBlocked, pos, closest) == INFINITY)
+			return sf::Vector2f(0.f, 0.f);
+		direction = pos - closest;
+
+		//Exactly on wall side, move away from tile center
+		if (direction.x == 0.f && direction.y == 0.f)
+		{
+			auto center = sf::Vector2f(((float)tile.x + 0.5f) * _tileSize.x + _offset.x, ((float)tile.y + 0.5f) * _tileSize.y + _offset.y);
+			direction = center - closest;
+		}
+	}
+	else
+	{
+		//Towards closest free tile or map border
+		float left = pos.x - _offset.x;
+		float right = _offset.x + (float)_width * _tileSize.x - pos.x;
+		float top = pos.y - _offset.y;
+		float bottom = _offset.y + (float)_height * _tileSize.y - pos.y;
+		float border = std::min(std::min(left, right), std::min(top, bottom));
+
+		auto distance = GetClosestSitePoint(_toFree, pos, closest);
+		if (distance != INFINITY && std::sqrt(distance) <= border)
+			direction = closest - pos;
+		else if (border == left) direction = sf::Vector2f(-1.f, 0.f);
+		else if (border == right) direction = sf::Vector2f(1.f, 0.f);
+		else if (border == top) direction = sf::Vector2f(0.f, -1.f);
+		else direction = sf::Vector2f(0.f, 1.f);
+	}
+
+	float length = std::sqrt(direction.x * direction.x + direction.y * direction.y);
+	if (length == 0.f) return sf::Vector2f(0.f, 0.f);
+	return direction / length;
+}
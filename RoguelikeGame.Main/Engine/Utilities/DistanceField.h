@@ -0,0 +1,72 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <cmath>
+#include <algorithm>
+
+#include "BitGrid.h"
+#include "../Models/MapLayerModel.h"
+
+#include "SFML/System/Vector2.hpp"
+
+//Distance from any position to closest blocked tile (negative inside walls, then it is distance to closest free tile).
+//Closest tiles are found with Felzenszwalb distance transform between tile centers, then exact distance to tiles
+//around is measured
+class DistanceField
+{
+private:
+	//Closest site for every tile, found by column pass then row pass
+	struct Transform
+	{
+		std::vector<float> columnDistance; //Squared, to closest site in same column
+		std::vector<uint32_t> columnSite; //Row of that site
+		std::vector<uint32_t> site; //Tile index of closest site
+	};
+
+	static const uint32_t NO_SITE = UINT32_MAX;
+
+	const BitGrid* _blocked;
+	unsigned int _width;
+	unsigned int _height;
+	sf::Vector2f _tileSize;
+	sf::Vector2f _offset;
+
+	Transform _toBlocked; //Sites are blocked tiles
+	Transform _toFree; //Sites are free tiles
+	std::vector<float> _clearance; //Per tile, distance from any point of tile to closest wall
+
+	//Scratch for lower envelope of parabolas
+	std::vector<int> _envelope;
+	std::vector<double> _bounds;
+
+	bool IsSite(const Transform& transform, int x, int y) const;
+	//Returns true if any value in column changed
+	bool ColumnPass(Transform& transform, int x, std::vector<uint8_t>* changedRows);
+	void RowPass(Transform& transform, int y);
+	void BuildTransform(Transform& transform);
+	void UpdateClearance(int y);
+
+	sf::Vector2i GetTileOf(const sf::Vector2f& pos) const;
+	sf::FloatRect GetTileRect(uint32_t tile) const;
+	//Closest point of closest site among sites of tiles around pos, returns squared distance
+	float GetClosestSitePoint(const Transform& transform, const sf::Vector2f& pos, sf::Vector2f& closest) const;
+public:
+	DistanceField();
+	~DistanceField() = default;
+
+	//Pointer to blocked tiles is kept for updates, tiles give size and offset
+	void Build(const BitGrid* blocked, const MapLayerModel<bool>* tiles);
+	void Clear();
+	//Blocked tiles inside rect (in tiles) changed, only columns and rows that changed are recomputed
+	void UpdateTiles(const sf::IntRect& changedTiles);
+
+	bool IsBuilt() const;
+
+	//Negative inside walls, INFINITY when map has no walls
+	float DistanceToWall(const sf::Vector2f& pos) const;
+	//Lower bound of DistanceToWall shared by whole tile, single lookup (0 in walls and outside map)
+	float GetClearance(const sf::Vector2f& pos) const;
+	//Unit vector pointing away from closest wall (out of it when inside), zero when there are no walls
+	sf::Vector2f GradientAwayFromWall(const sf::Vector2f& pos) const;
+};
@@ -0,0 +1,290 @@
+#include "EdgeGrid.h"
+
+EdgeGrid::EdgeGrid()
+{
+	_bucketsX = 0;
+	_bucketsY = 0;
+}
+
+sf::Vector2i EdgeGrid::GetBucketOf(const sf::Vector2f& pos) const
+{
+	int x = (int)floor((pos.x - _bounds.left) / _bucketSize.x);
+	int y = (int)floor((pos.y - _bounds.top) / _bucketSize.y);
+	return sf::Vector2i(std::min(std::max(x, 0), _bucketsX - 1), std::min(std::max(y, 0), _bucketsY - 1));
+}
+
+void EdgeGrid::ClosestHitInBucket(int bucket, const sf::Vector2f& startPos, const sf::Vector2f& dir, float& closest) const
+{
+	//Same test as MathHelper::GetLinesIntersection, ends of both segments included
+	uint32_t i = _bucketStart[bucket];
+	uint32_t end = _bucketStart[(size_t)bucket + 1];
+
+#ifdef EDGE_GRID_SSE
+	//Same operations in same order as scalar code below, so results are equal
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 one = _mm_set1_ps(1.f);
+	const __m128 startX = _mm_set1_ps(startPos.x);
+	const __m128 startY = _mm_set1_ps(startPos.y);
+	const __m128 dirX = _mm_set1_ps(dir.x);
+	const __m128 dirY = _mm_set1_ps(dir.y);
+	const __m128 negDirY = _mm_set1_ps(-dir.y);
+	const __m128 sign = _mm_set1_ps(-0.f);
+	__m128 best = _mm_set1_ps(closest);
+	for (; i + 4 <= end; i += 4)
+	{
+		__m128 edgeDirX = _mm_loadu_ps(&_bucketDirX[i]);
+		__m128 edgeDirY = _mm_loadu_ps(&_bucketDirY[i]);
+		__m128 diffX = _mm_sub_ps(startX, _mm_loadu_ps(&_bucketX[i]));
+		__m128 diffY = _mm_sub_ps(startY, _mm_loadu_ps(&_bucketY[i]));
+
+		__m128 denominator = _mm_add_ps(_mm_mul_ps(_mm_xor_ps(edgeDirX, sign), dirY), _mm_mul_ps(dirX, edgeDirY));
+		__m128 s = _mm_div_ps(_mm_add_ps(_mm_mul_ps(negDirY, diffX), _mm_mul_ps(dirX, diffY)), denominator);
+		__m128 t = _mm_div_ps(_mm_sub_ps(_mm_mul_ps(edgeDirX, diffY), _mm_mul_ps(edgeDirY, diffX)), denominator);
+
+		__m128 hit = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(s, zero), _mm_cmple_ps(s, one)), _mm_and_ps(_mm_cmpge_ps(t, zero), _mm_cmple_ps(t, one)));
+		best = _mm_min_ps(best, _mm_or_ps(_mm_and_ps(hit, t), _mm_andnot_ps(hit, best)));
+	}
+	best = _mm_min_ps(best, _mm_shuffle_ps(best, best, _MM_SHUFFLE(1, 0, 3, 2)));
+	best = _mm_min_ps(best, _mm_shuffle_ps(best, best, _MM_SHUFFLE(2, 3, 0, 1)));
+	closest = _mm_cvtss_f32(best);
+#endif
+
+	for (; i < end; i++)
+	{
+		sf::Vector2f edgeDir(_bucketDirX[i], _bucketDirY[i]);
+		sf::Vector2f diff = startPos - sf::Vector2f(_bucketX[i], _bucketY[i]);
+
+		float denominator = -edgeDir.x * dir.y + dir.x * edgeDir.y;
+		float s = (-dir.y * diff.x + dir.x * diff.y) / denominator;
+		float t = (edgeDir.x * diff.y - edgeDir.y * diff.x) / denominator;
+		if (s >= 0 && s <= 1 && t >= 0 && t <= 1 && t < closest)
+			closest = t;
+	}
+}
+
+void EdgeGrid::Build(const std::vector<Edge>& edges, const sf::FloatRect& bounds, const sf::Vector2f& bucketSize)
+{
+	Clear();
+	if (bounds.width <= 0.f || bounds.height <= 0.f || bucketSize.x <= 0.f || bucketSize.y <= 0.f)
+		return;
+
+	_edges = edges;
+	_bounds = bounds;
+	_bucketSize = bucketSize;
+	_bucketsX = std::max((int)ceil(bounds.width / bucketSize.x), 1);
+	_bucketsY = std::max((int)ceil(bounds.height / bucketSize.y), 1);
+
+	//Counting pass then filling pass, buckets are stored one after another
+	_bucketStart.assign((size_t)_bucketsX * _bucketsY + 1, 0);
+	for (auto& edge : _edges)
+		ForEachBucket(edge, [this](int bucket) { _bucketStart[(size_t)bucket + 1]++; });
+	for (size_t i = 1; i < _bucketStart.size(); i++)
+		_bucketStart[i] += _bucketStart[i - 1];
+
+	std::vector<uint32_t> fill(_bucketStart.begin(), _bucketStart.end() - 1);
+	_bucketEdges.resize(_bucketStart.back());
+	for (size_t i = 0; i < _edges.size(); i++)
+		ForEachBucket(_edges[i], [&](int bucket) { _bucketEdges[fill[bucket]++] = (uint32_t)i; });
+
+	_bucketX.reserve(_bucketEdges.size());
+	_bucketY.reserve(_bucketEdges.size());
+	_bucketDirX.reserve(_bucketEdges.size());
+	_bucketDirY.reserve(_bucketEdges.size());
+	for (auto id : _bucketEdges)
+		PushBucketData(_edges[id]);
+}
+
+void EdgeGrid::PushBucketData(const Edge& edge)
+{
+	auto edgeDir = std::get<1>(edge) - std::get<0>(edge);
+	_bucketX.push_back(std::get<0>(edge).x);
+	_bucketY.push_back(std::get<0>(edge).y);
+	_bucketDirX.push_back(edgeDir.x);
+	_bucketDirY.push_back(edgeDir.y);
+}
+
+void EdgeGrid::Update(const std::vector<Edge>& edges, const std::vector<size_t>& changed)
+{
+	if (!IsBuilt()) return;
+
+	//Buckets of old and new place of every changed edge
+	std::vector<uint8_t> dirty(GetBucketsCount(), 0);
+	std::vector<std::pair<uint32_t, uint32_t>> fresh; //Bucket, edge
+	for (auto id : changed)
+	{
+		if (id < _edges.size())
+			ForEachBucket(_edges[id], [&](int bucket) { dirty[bucket] = 1; });
+		if (id < edges.size())
+			ForEachBucket(edges[id], [&](int bucket) { dirty[bucket] = 1; fresh.emplace_back((uint32_t)bucket, (uint32_t)id); });
+	}
+	std::sort(fresh.begin(), fresh.end());
+
+	_edges.resize(edges.size());
+	for (auto id : changed)
+		if (id < edges.size())
+			_edges[id] = edges[id];
+
+	//Clean buckets are copied, dirty ones lose changed edges and get their new versions
+	std::vector<uint32_t> oldStart, oldEdges;
+	std::vector<float> oldX, oldY, oldDirX, oldDirY;
+	oldStart.swap(_bucketStart);
+	oldEdges.swap(_bucketEdges);
+	oldX.swap(_bucketX);
+	oldY.swap(_bucketY);
+	oldDirX.swap(_bucketDirX);
+	oldDirY.swap(_bucketDirY);
+
+	_bucketStart.resize(oldStart.size());
+	_bucketEdges.reserve(oldEdges.size() + fresh.size());
+	size_t next = 0;
+	for (size_t bucket = 0; bucket + 1 < oldStart.size(); bucket++)
+	{
+		_bucketStart[bucket] = (uint32_t)_bucketEdges.size();
+		uint32_t from = oldStart[bucket];
+		uint32_t to = oldStart[bucket + 1];
+		if (dirty[bucket] == 0)
+		{
+			_bucketEdges.insert(_bucketEdges.end(), oldEdges.begin() + from, oldEdges.begin() + to);
+			_bucketX.insert(_bucketX.end(), oldX.begin() + from, oldX.begin() + to);
+			_bucketY.insert(_bucketY.end(), oldY.begin() + from, oldY.begin() + to);
+			_bucketDirX.insert(_bucketDirX.end(), oldDirX.begin() + from, oldDirX.begin() + to);
+			_bucketDirY.insert(_bucketDirY.end(), oldDirY.begin() + from, oldDirY.begin() + to);
+			continue;
+		}
+
+		for (uint32_t i = from; i < to; i++)
+			if (std::binary_search(changed.begin(), changed.end(), (size_t)oldEdges[i]) == false)
+			{
+				_bucketEdges.push_back(oldEdges[i]);
+				PushBucketData(_edges[oldEdges[i]]);
+			}
+		for (; next < fresh.size() && fresh[next].first == bucket; next++)
+		{
+			_bucketEdges.push_back(fresh[next].second);
+			PushBucketData(_edges[fresh[next].second]);
+		}
+	}
+	_bucketStart.back() = (uint32_t)_bucketEdges.size();
+}
+
+void EdgeGrid::Clear()
+{
+	_edges.clear();
+	_bucketStart.clear();
+	_bucketEdges.clear();
+	_bucketX.clear();
+	_bucketY.clear();
+	_bucketDirX.clear();
+	_bucketDirY.clear();
+	_bucketsX = 0;
+	_bucketsY = 0;
+}
+
+void EdgeGrid::GetEdgesInRect(const sf::FloatRect& rect, std::vector<size_t>& output) const
+{
+	output.clear();
+	if (!IsBuilt()) return;
+
+	auto from = GetBucketOf(sf::Vector2f(rect.left, rect.top));
+	auto to = GetBucketOf(sf::Vector2f(rect.left + rect.width, rect.top + rect.height));
+	for (int y = from.y; y <= to.y; y++)
+		for (int x = from.x; x <= to.x; x++)
+		{
+			int bucket = y * _bucketsX + x;
+			for (uint32_t i = _bucketStart[bucket]; i < _bucketStart[(size_t)bucket + 1]; i++)
+			{
+				auto& edge = _edges[_bucketEdges[i]];
+				if (std::max(std::get<0>(edge).x, std::get<1>(edge).x) >= rect.left && std::min(std::get<0>(edge).x, std::get<1>(edge).x) <= rect.left + rect.width &&
+					std::max(std::get<0>(edge).y, std::get<1>(edge).y) >= rect.top && std::min(std::get<0>(edge).y, std::get<1>(edge).y) <= rect.top + rect.height)
+					output.push_back(_bucketEdges[i]);
+			}
+		}
+
+	std::sort(output.begin(), output.end());
+	output.erase(std::unique(output.begin(), output.end()), output.end());
+}
+
+float EdgeGrid::GetSegmentHit(const sf::Vector2f& startPos, const sf::Vector2f& endPos) const
+{
+	if (!IsBuilt()) return INFINITY;
+
+	//Segment in bucket units, clipped to grid bounds
+	double sx = ((double)startPos.x - _bounds.left) / _bucketSize.x;
+	double sy = ((double)startPos.y - _bounds.top) / _bucketSize.y;
+	double dx = ((double)endPos.x - startPos.x) / _bucketSize.x;
+	double dy = ((double)endPos.y - startPos.y) / _bucketSize.y;
+
+	double tEnter = 0.0, tExit = 1.0;
+	double p[2] = { sx, sy };
+	double d[2] = { dx, dy };
+	double hi[2] = { (double)_bucketsX, (double)_bucketsY };
+	for (int i = 0; i < 2; i++)
+	{
+		if (d[i] == 0.0)
+		{
+			if (p[i] < 0.0 || p[i] > hi[i]) return INFINITY;
+			continue;
+		}
+		double t1 = -p[i] / d[i];
+		double t2 = (hi[i] - p[i]) / d[i];
+		if (t1 > t2) std::swap(t1, t2);
+		tEnter = std::max(tEnter, t1);
+		tExit = std::min(tExit, t2);
+		if (tEnter > tExit) return INFINITY;
+	}
+
+	int x = std::min(std::max((int)floor(sx + dx * tEnter), 0), _bucketsX - 1);
+	int y = std::min(std::max((int)floor(sy + dy * tEnter), 0), _bucketsY - 1);
+	int stepX = (dx > 0) ? 1 : ((dx < 0) ? -1 : 0);
+	int stepY = (dy > 0) ? 1 : ((dy < 0) ? -1 : 0);
+	double tDeltaX = (dx != 0) ? 1.0 / fabs(dx) : INFINITY;
+	double tDeltaY = (dy != 0) ? 1.0 / fabs(dy) : INFINITY;
+	double tMaxX = (dx > 0) ? ((double)x + 1.0 - sx) / dx : ((dx < 0) ? (sx - (double)x) / -dx : INFINITY);
+	double tMaxY = (dy > 0) ? ((double)y + 1.0 - sy) / dy : ((dy < 0) ? (sy - (double)y) / -dy : INFINITY);
+
+	//Buckets are visited in ray order, hit inside current bucket can't be beaten by later ones
+	float closest = INFINITY;
+	sf::Vector2f dir = endPos - startPos;
+	while (x >= 0 && y >= 0 && x < _bucketsX && y < _bucketsY)
+	{
+		ClosestHitInBucket(y * _bucketsX + x, startPos, dir, closest);
+
+		double bucketExit = std::min(tMaxX, tMaxY);
+		if ((double)closest <= bucketExit || bucketExit > tExit)
+			break;
+
+		if (tMaxX < tMaxY)
+		{
+			x += stepX;
+			tMaxX += tDeltaX;
+		}
+		else
+		{
+			y += stepY;
+			tMaxY += tDeltaY;
+		}
+	}
+	return closest;
+}
+
+void EdgeGrid::GetSegmentHits(const std::vector<Edge>& segments, std::vector<float>& output) const
+{
+	output.resize(segments.size());
+	for (size_t i = 0; i < segments.size(); i++)
+		output[i] = GetSegmentHit(std::get<0>(segments[i]), std::get<1>(segments[i]));
+}
+
+bool EdgeGrid::IsBuilt() const
+{
+	return _bucketsX > 0 && _bucketsY > 0;
+}
+
+size_t EdgeGrid::GetBucketsCount() const
+{
+	return (size_t)_bucketsX * _bucketsY;
+}
+
+const std::vector<EdgeGrid::Edge>* EdgeGrid::GetEdges() const
+{
+	return &_edges;
+}
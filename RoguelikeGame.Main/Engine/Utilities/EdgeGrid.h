@@ -0,0 +1,73 @@
+#pragma once
+
+#include <vector>
+#include <tuple>
+#include <cstdint>
+#include <cmath>
+#include <algorithm>
+
+#include "SFML/Graphics/Rect.hpp"
+
+#if defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__)
+#define EDGE_GRID_SSE
+#include <emmintrin.h>
+#endif
+
+//Uniform bucket grid over line segments, every bucket lists segments whose bounding box overlaps it
+class EdgeGrid
+{
+public:
+	typedef std::tuple<sf::Vector2f, sf::Vector2f> Edge;
+private:
+	std::vector<Edge> _edges;
+	sf::FloatRect _bounds;
+	sf::Vector2f _bucketSize;
+	int _bucketsX;
+	int _bucketsY;
+	std::vector<uint32_t> _bucketStart; //Offsets into _bucketEdges, one more than buckets count
+	std::vector<uint32_t> _bucketEdges;
+	//Copy of edges in bucket order (start and direction), tested 4 at once when SSE is available
+	std::vector<float> _bucketX;
+	std::vector<float> _bucketY;
+	std::vector<float> _bucketDirX;
+	std::vector<float> _bucketDirY;
+
+	sf::Vector2i GetBucketOf(const sf::Vector2f& pos) const;
+	//Calls callback(bucket) for every bucket edge bounding box overlaps
+	template<typename F>
+	void ForEachBucket(const Edge& edge, F callback) const;
+	void PushBucketData(const Edge& edge);
+	void ClosestHitInBucket(int bucket, const sf::Vector2f& startPos, const sf::Vector2f& dir, float& closest) const;
+public:
+	EdgeGrid();
+	~EdgeGrid() = default;
+
+	//Copies edges, bounds should cover all of them
+	void Build(const std::vector<Edge>& edges, const sf::FloatRect& bounds, const sf::Vector2f& bucketSize);
+	void Clear();
+	//Edges are whole new list, changed are sorted indexes that differ from stored list (including added and removed ones)
+	void Update(const std::vector<Edge>& edges, const std::vector<size_t>& changed);
+
+	//Indexes of edges which bounding box overlaps rect, sorted and unique
+	void GetEdgesInRect(const sf::FloatRect& rect, std::vector<size_t>& output) const;
+	//Part of segment (0-1) where it first intersects any edge, INFINITY if none
+	float GetSegmentHit(const sf::Vector2f& startPos, const sf::Vector2f& endPos) const;
+	//GetSegmentHit for every segment
+	void GetSegmentHits(const std::vector<Edge>& segments, std::vector<float>& output) const;
+
+	bool IsBuilt() const;
+	size_t GetBucketsCount() const;
+	const std::vector<Edge>* GetEdges() const;
+};
+
+template<typename F>
+inline void EdgeGrid::ForEachBucket(const Edge& edge, F callback) const
+{
+	//Edges lying on bucket border go to buckets on both sides
+	const float border = 0.001f;
+	auto from = GetBucketOf(sf::Vector2f(std::min(std::get<0>(edge).x, std::get<1>(edge).x) - border, std::min(std::get<0>(edge).y, std::get<1>(edge).y) - border));
+	auto to = GetBucketOf(sf::Vector2f(std::max(std::get<0>(edge).x, std::get<1>(edge).x) + border, std::max(std::get<0>(edge).y, std::get<1>(edge).y) + border));
+	for (int y = from.y; y <= to.y; y++)
+		for (int x = from.x; x <= to.x; x++)
+			callback(y * _bucketsX + x);
+}
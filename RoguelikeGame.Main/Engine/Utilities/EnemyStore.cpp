@@ -0,0 +1,270 @@
+#include "EnemyStore.h"
+
+uint8_t EnemyStore::GetStateId(const std::string& state)
+{
+	if (state == "idle") return STATE_IDLE;
+	if (state == "move") return STATE_MOVE;
+	if (state == "attack") return STATE_ATTACK;
+	return STATE_OTHER;
+}
+
+const char* EnemyStore::GetStateName(uint8_t state)
+{
+	switch (state)
+	{
+	case STATE_IDLE: return "idle";
+	case STATE_MOVE: return "move";
+	case STATE_ATTACK: return "attack";
+	default: return "";
+	}
+}
+
+void EnemyStore::SetFlag(size_t index, uint8_t flag, bool value)
+{
+	if (value)
+		_flags[index] |= flag;
+	else
+		_flags[index] &= (uint8_t)~flag;
+}
+
+EnemyHandle EnemyStore::Add(Enemy* enemy)
+{
+	if (enemy == nullptr) return EnemyHandle();
+
+	uint32_t slot;
+	if (_freeSlots.empty())
+	{
+		slot = (uint32_t)_slots.size();
+		_slots.emplace_back();
+	}
+	else
+	{
+		slot = _freeSlots.back();
+		_freeSlots.pop_back();
+	}
+
+	_slots[slot].dense = (uint32_t)_enemies.size();
+	_slotOfDense.push_back(slot);
+
+	_enemies.push_back(enemy);
+	_centerX.push_back(0.f);
+	_centerY.push_back(0.f);
+	_velocityX.push_back(0.f);
+	_velocityY.push_back(0.f);
+	_boxSize.emplace_back();
+	_hitboxOffset.emplace_back();
+	_health.push_back(0.f);
+	_moveSpeed.push_back(0.f);
+	_avoidanceRadius.push_back(0.f);
+	_state.push_back(STATE_OTHER);
+	_flags.push_back(0);
+	Gather(_enemies.size() - 1);
+
+	EnemyHandle handle;
+	handle.slot = slot;
+	handle.generation = _slots[slot].generation;
+	return handle;
+}
+
+bool EnemyStore::Remove(EnemyHandle handle)
+{
+	if (IsValid(handle) == false) return false;
+
+	auto index = _slots[handle.slot].dense;
+	_slots[handle.slot].dense = UINT32_MAX;
+	_slots[handle.slot].generation++;
+	_freeSlots.push_back(handle.slot);
+
+	SwapAndPop(index);
+	return true;
+}
+
+void EnemyStore::SwapAndPop(size_t index)
+{
+	size_t last = _enemies.size() - 1;
+	if (index != last)
+	{
+		auto slot = _slotOfDense[last];
+		_slotOfDense[index] = slot;
+		_enemies[index] = _enemies[last];
+		_centerX[index] = _centerX[last];
+		_centerY[index] = _centerY[last];
+		_velocityX[index] = _velocityX[last];
+		_velocityY[index] = _velocityY[last];
+		_boxSize[index] = _boxSize[last];
+		_hitboxOffset[index] = _hitboxOffset[last];
+		_health[index] = _health[last];
+		_moveSpeed[index] = _moveSpeed[last];
+		_avoidanceRadius[index] = _avoidanceRadius[last];
+		_state[index] = _state[last];
+		_flags[index] = _flags[last];
+		_slots[slot].dense = (uint32_t)index;
+	}
+
+	_slotOfDense.pop_back();
+	_enemies.pop_back();
+	_centerX.pop_back();
+	_centerY.pop_back();
+	_velocityX.pop_back();
+	_velocityY.pop_back();
+	_boxSize.pop_back();
+	_hitboxOffset.pop_back();
+	_health.pop_back();
+	_moveSpeed.pop_back();
+	_avoidanceRadius.pop_back();
+	_state.pop_back();
+	_flags.pop_back();
+}
+
+void EnemyStore::Clear()
+{
+	//Generations are kept, so old handles stay invalid
+	_freeSlots.clear();
+	for (uint32_t slot = 0; slot < (uint32_t)_slots.size(); slot++)
+	{
+		if (_slots[slot].dense != UINT32_MAX)
+			_slots[slot].generation++;
+		_slots[slot].dense = UINT32_MAX;
+		_freeSlots.push_back(slot);
+	}
+
+	_slotOfDense.clear();
+	_enemies.clear();
+	_centerX.clear();
+	_centerY.clear();
+	_velocityX.clear();
+	_velocityY.clear();
+	_boxSize.clear();
+	_hitboxOffset.clear();
+	_health.clear();
+	_moveSpeed.clear();
+	_avoidanceRadius.clear();
+	_state.clear();
+	_flags.clear();
+}
+
+size_t EnemyStore::GetSize() const
+{
+	return _enemies.size();
+}
+
+bool EnemyStore::IsValid(EnemyHandle handle) const
+{
+	return (handle.slot < _slots.size() && _slots[handle.slot].generation == handle.generation && _slots[handle.slot].dense != UINT32_MAX);
+}
+
+size_t EnemyStore::GetIndex(EnemyHandle handle) const
+{
+	if (IsValid(handle) == false) return SIZE_MAX;
+	return _slots[handle.slot].dense;
+}
+
+EnemyHandle EnemyStore::GetHandle(size_t index) const
+{
+	EnemyHandle handle;
+	if (index >= _enemies.size()) return handle;
+
+	handle.slot = _slotOfDense[index];
+	handle.generation = _slots[handle.slot].generation;
+	return handle;
+}
+
+Enemy* EnemyStore::Get(EnemyHandle handle) const
+{
+	auto index = GetIndex(handle);
+	return (index == SIZE_MAX) ? nullptr : _enemies[index];
+}
+
+void EnemyStore::Gather(size_t index)
+{
+	auto enemy = _enemies[index];
+	auto box = enemy->GetCollisionBox();
+	auto center = ViewHelper::GetRectCenter(box);
+	auto& position = enemy->GetPosition();
+
+	_centerX[index] = center.x;
+	_centerY[index] = center.y;
+	_boxSize[index] = sf::Vector2f(box.width, box.height);
+	_hitboxOffset[index] = sf::Vector2f(box.left - position.x, box.top - position.y);
+	_health[index] = enemy->GetHealth();
+	_moveSpeed[index] = enemy->GetStep() * enemy->GetSpeed();
+	_avoidanceRadius[index] = enemy->GetAvoidanceRadius();
+	_state[index] = GetStateId(enemy->GetAnimations()->GetCurrentState());
+
+	SetFlag(index, FLAG_AI, enemy->IsAiEnabled());
+	SetFlag(index, FLAG_ATTACKING, enemy->IsAttacking());
+	SetFlag(index, FLAG_DEAD, enemy->GetHealth() <= 0);
+	SetFlag(index, FLAG_HAS_WEAPON, enemy->GetWeapon() != nullptr);
+}
+
+void EnemyStore::GatherAll()
+{
+	for (size_t i = 0; i < _enemies.size(); i++)
+		Gather(i);
+}
+
+void EnemyStore::SetCenter(size_t index, const sf::Vector2f& center)
+{
+	_centerX[index] = center.x;
+	_centerY[index] = center.y;
+
+	auto& size = _boxSize[index];
+	auto& offset = _hitboxOffset[index];
+	_enemies[index]->SetPosition(center.x - size.x / 2.f - offset.x, center.y - size.y / 2.f - offset.y);
+}
+
+void EnemyStore::SetVelocity(size_t index, const sf::Vector2f& velocity)
+{
+	_velocityX[index] = velocity.x;
+	_velocityY[index] = velocity.y;
+}
+
+void EnemyStore::SetAI(size_t index, bool enable)
+{
+	SetFlag(index, FLAG_AI, enable);
+	_enemies[index]->SetAI(enable);
+}
+
+void EnemyStore::SetState(size_t index, State state)
+{
+	if (_state[index] == state) return;
+
+	_state[index] = state;
+	_enemies[index]->SetState(GetStateName(state));
+}
+
+void EnemyStore::SetDirect(size_t index, bool direct)
+{
+	SetFlag(index, FLAG_DIRECT, direct);
+}
+
+sf::FloatRect EnemyStore::GetBox(size_t index) const
+{
+	auto& size = _boxSize[index];
+	return sf::FloatRect(_centerX[index] - size.x / 2.f, _centerY[index] - size.y / 2.f, size.x, size.y);
+}
+
+const std::vector<Enemy*>* EnemyStore::GetEnemies() const
+{
+	return &_enemies;
+}
+
+const std::vector<float>& EnemyStore::GetCentersX() const
+{
+	return _centerX;
+}
+
+const std::vector<float>& EnemyStore::GetCentersY() const
+{
+	return _centerY;
+}
+
+const std::vector<float>& EnemyStore::GetAvoidanceRadiuses() const
+{
+	return _avoidanceRadius;
+}
+
+const std::vector<uint8_t>& EnemyStore::GetFlags() const
+{
+	return _flags;
+}
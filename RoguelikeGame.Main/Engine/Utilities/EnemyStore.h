@@ -0,0 +1,100 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <climits>
+
+#include "../Models/Enemy.h"
+#include "../Helpers/ViewHelper.h"
+
+//Stays valid until its enemy is removed, even when other enemies are removed
+struct EnemyHandle
+{
+	uint32_t slot = UINT32_MAX;
+	uint32_t generation = 0;
+
+	bool operator==(const EnemyHandle& other) const { return slot == other.slot && generation == other.generation; }
+	bool operator!=(const EnemyHandle& other) const { return !(*this == other); }
+	bool operator<(const EnemyHandle& other) const { return (slot != other.slot) ? slot < other.slot : generation < other.generation; }
+};
+
+//Hot data of enemies in dense arrays, enemy objects are kept only for animations, weapons and drawing
+//Removed enemy is replaced by last one, so dense index of last enemy changes on every removal
+class EnemyStore
+{
+public:
+	enum Flag : uint8_t { FLAG_AI = 1, FLAG_ATTACKING = 2, FLAG_DEAD = 4, FLAG_HAS_WEAPON = 8, FLAG_DIRECT = 16 }; //Direct is set by AI, not gathered
+	enum State : uint8_t { STATE_OTHER = 0, STATE_IDLE = 1, STATE_MOVE = 2, STATE_ATTACK = 3 };
+private:
+	//Handle slot -> dense index
+	struct Slot
+	{
+		uint32_t dense = UINT32_MAX;
+		uint32_t generation = 0;
+	};
+	std::vector<Slot> _slots;
+	std::vector<uint32_t> _freeSlots;
+	std::vector<uint32_t> _slotOfDense;
+
+	std::vector<Enemy*> _enemies;
+	std::vector<float> _centerX; //Collision box center
+	std::vector<float> _centerY;
+	std::vector<float> _velocityX; //Last move per second
+	std::vector<float> _velocityY;
+	std::vector<sf::Vector2f> _boxSize;
+	std::vector<sf::Vector2f> _hitboxOffset; //Collision box corner relative to position
+	std::vector<float> _health;
+	std::vector<float> _moveSpeed; //Step * speed
+	std::vector<float> _avoidanceRadius;
+	std::vector<uint8_t> _state;
+	std::vector<uint8_t> _flags;
+
+	static uint8_t GetStateId(const std::string& state);
+	static const char* GetStateName(uint8_t state);
+	void SetFlag(size_t index, uint8_t flag, bool value);
+	//Moves last enemy into index and drops last row of every column
+	void SwapAndPop(size_t index);
+public:
+	EnemyStore() = default;
+	~EnemyStore() = default;
+
+	EnemyHandle Add(Enemy* enemy);
+	//Enemy object is not deleted
+	bool Remove(EnemyHandle handle);
+	void Clear();
+
+	size_t GetSize() const;
+	bool IsValid(EnemyHandle handle) const;
+	size_t GetIndex(EnemyHandle handle) const; //SIZE_MAX if handle is not valid
+	EnemyHandle GetHandle(size_t index) const;
+	Enemy* Get(EnemyHandle handle) const;
+
+	//Copies hot data from enemy object
+	void Gather(size_t index);
+	void GatherAll();
+
+	//Setters change enemy object too
+	void SetCenter(size_t index, const sf::Vector2f& center);
+	void SetVelocity(size_t index, const sf::Vector2f& velocity);
+	void SetAI(size_t index, bool enable);
+	void SetState(size_t index, State state);
+	void SetDirect(size_t index, bool direct);
+
+	//Per index getters for hot loops
+	Enemy* GetEnemy(size_t index) const { return _enemies[index]; }
+	sf::Vector2f GetCenter(size_t index) const { return sf::Vector2f(_centerX[index], _centerY[index]); }
+	sf::Vector2f GetVelocity(size_t index) const { return sf::Vector2f(_velocityX[index], _velocityY[index]); }
+	sf::FloatRect GetBox(size_t index) const;
+	float GetHealth(size_t index) const { return _health[index]; }
+	float GetMoveSpeed(size_t index) const { return _moveSpeed[index]; }
+	float GetAvoidanceRadius(size_t index) const { return _avoidanceRadius[index]; }
+	uint8_t GetState(size_t index) const { return _state[index]; }
+	bool HasFlag(size_t index, uint8_t flag) const { return (_flags[index] & flag) != 0; }
+
+	//Whole columns
+	const std::vector<Enemy*>* GetEnemies() const;
+	const std::vector<float>& GetCentersX() const;
+	const std::vector<float>& GetCentersY() const;
+	const std::vector<float>& GetAvoidanceRadiuses() const;
+	const std::vector<uint8_t>& GetFlags() const;
+};
@@ -0,0 +1,186 @@
+#include "FieldOfView.h"
+
+FieldOfView::FieldOfView()
+{
+	_radius = 0.f;
+	_tilesRadius = 0;
+	_hasTiles = false;
+}
+
+void FieldOfView::CastLight(const MapLayerModel<bool>* tiles, int row, float start, float end, int xx, int xy, int yx, int yy)
+{
+	if (start < end) return;
+
+	float newStart = 0.f;
+	for (int j = row; j <= _tilesRadius; j++)
+	{
+		int dx = -j - 1;
+		int dy = -j;
+		bool blocked = false;
+		while (dx <= 0)
+		{
+			dx++;
+			int x = _originTile.x + dx * xx + dy * xy;
+			int y = _originTile.y + dx * yx + dy * yy;
+
+			float leftSlope = ((float)dx - 0.5f) / ((float)dy + 0.5f);
+			float rightSlope = ((float)dx + 0.5f) / ((float)dy - 0.5f);
+			if (start < rightSlope) continue;
+			else if (end > leftSlope) break;
+
+			bool onMap = (x >= 0 && y >= 0 && x < (int)tiles->width && y < (int)tiles->height);
+			if (onMap && dx * dx + dy * dy <= _tilesRadius * _tilesRadius)
+				SetTileVisible(x, y);
+
+			bool wall = (onMap == false || tiles->data[(size_t)y * tiles->width + x]);
+			if (blocked)
+			{
+				if (wall)
+				{
+					newStart = rightSlope;
+					continue;
+				}
+				blocked = false;
+				start = newStart;
+			}
+			else if (wall && j < _tilesRadius)
+			{
+				//Light above wall goes on in next rows
+				blocked = true;
+				CastLight(tiles, j + 1, start, leftSlope, xx, xy, yx, yy);
+				newStart = rightSlope;
+			}
+		}
+		if (blocked) break;
+	}
+}
+
+void FieldOfView::SetTileVisible(int x, int y)
+{
+	_visibleTiles.Set(x - _originTile.x + _tilesRadius, y - _originTile.y + _tilesRadius, true);
+}
+
+void FieldOfView::Clear()
+{
+	_radius = 0.f;
+	_tilesRadius = 0;
+	_hasTiles = false;
+	_visibleTiles.Clear();
+	_polygon.clear();
+	_polygonAngles.clear();
+}
+
+void FieldOfView::ComputeTiles(const sf::Vector2f& origin, float radius, const MapLayerModel<bool>* tiles)
+{
+	_origin = origin;
+	_radius = radius;
+	_hasTiles = false;
+	if (tiles == nullptr || tiles->tileWidth == 0 || tiles->tileHeight == 0) return;
+
+	_tileSize = sf::Vector2f((float)tiles->tileWidth, (float)tiles->tileHeight);
+	_tilesOffset = sf::Vector2f(tiles->offsetX, tiles->offsetY);
+	_originTile = sf::Vector2i((int)floor((origin.x - _tilesOffset.x) / _tileSize.x), (int)floor((origin.y - _tilesOffset.y) / _tileSize.y));
+	_tilesRadius = std::max((int)ceil(radius / std::min(_tileSize.x, _tileSize.y)), 0);
+
+	auto size = (unsigned int)(_tilesRadius * 2 + 1);
+	_visibleTiles.Resize(size, size);
+	_hasTiles = true;
+
+	if (_originTile.x < 0 || _originTile.y < 0 || _originTile.x >= (int)tiles->width || _originTile.y >= (int)tiles->height) return;
+	SetTileVisible(_originTile.x, _originTile.y);
+
+	//Transforms of first octant into all 8
+	static const int multipliers[4][8] = {
+		{ 1, 0, 0, -1, -1, 0, 0, 1 },
+		{ 0, 1, -1, 0, 0, -1, 1, 0 },
+		{ 0, 1, 1, 0, 0, -1, -1, 0 },
+		{ 1, 0, 0, 1, -1, 0, 0, -1 }
+	};
+	for (int octant = 0; octant < 8; octant++)
+		CastLight(tiles, 1, 1.f, 0.f, multipliers[0][octant], multipliers[1][octant], multipliers[2][octant], multipliers[3][octant]);
+}
+
+void FieldOfView::SetPolygon(const sf::Vector2f& origin, float radius, const std::vector<sf::Vector2f>& points)
+{
+	_origin = origin;
+	_radius = radius;
+
+	std::vector<std::pair<float, sf::Vector2f>> sorted;
+	sorted.reserve(points.size());
+	for (auto& p : points)
+	{
+		if (p == origin) continue; //Ray started in wall
+		sorted.emplace_back(atan2f(p.y - origin.y, p.x - origin.x), p);
+	}
+	std::sort(sorted.begin(), sorted.end(), [](const std::pair<float, sf::Vector2f>& a, const std::pair<float, sf::Vector2f>& b) { return a.first < b.first; });
+
+	_polygon.resize(sorted.size());
+	_polygonAngles.resize(sorted.size());
+	for (size_t i = 0; i < sorted.size(); i++)
+	{
+		_polygonAngles[i] = sorted[i].first;
+		_polygon[i] = sorted[i].second;
+	}
+}
+
+bool FieldOfView::IsTileVisible(int x, int y) const
+{
+	if (_hasTiles == false) return false;
+
+	int localX = x - _originTile.x + _tilesRadius;
+	int localY = y - _originTile.y + _tilesRadius;
+	if (localX < 0 || localY < 0 || localX > _tilesRadius * 2 || localY > _tilesRadius * 2) return false;
+	return _visibleTiles.Get(localX, localY);
+}
+
+bool FieldOfView::IsVisible(const sf::Vector2f& pos) const
+{
+	auto diff = pos - _origin;
+	float distance = diff.x * diff.x + diff.y * diff.y;
+	if (distance > _radius * _radius) return false;
+	if (distance == 0.f) return true;
+
+	if (_polygon.size() < 3)
+		return _hasTiles && IsTileVisible((int)floor((pos.x - _tilesOffset.x) / _tileSize.x), (int)floor((pos.y - _tilesOffset.y) / _tileSize.y));
+
+	//Find points around pos angle, pos is visible if it is not behind line between them
+	float angle = atan2f(diff.y, diff.x);
+	size_t next = (size_t)(std::upper_bound(_polygonAngles.begin(), _polygonAngles.end(), angle) - _polygonAngles.begin());
+	if (next == _polygon.size()) next = 0;
+	size_t prev = (next == 0) ? _polygon.size() - 1 : next - 1;
+
+	auto& first = _polygon[prev];
+	auto& second = _polygon[next];
+	auto line = second - first;
+	float posSide = line.x * (pos.y - first.y) - line.y * (pos.x - first.x);
+	float originSide = line.x * (_origin.y - first.y) - line.y * (_origin.x - first.x);
+
+	float tolerance = 0.01f * sqrt(line.x * line.x + line.y * line.y);
+	if (fabs(originSide) <= tolerance) //Both points on one ray, only closer part is visible
+	{
+		auto a = first - _origin;
+		auto b = second - _origin;
+		return distance <= std::min(a.x * a.x + a.y * a.y, b.x * b.x + b.y * b.y);
+	}
+	return (fabs(posSide) <= tolerance || (posSide > 0.f) == (originSide > 0.f));
+}
+
+const sf::Vector2f& FieldOfView::GetOrigin() const
+{
+	return _origin;
+}
+
+float FieldOfView::GetRadius() const
+{
+	return _radius;
+}
+
+bool FieldOfView::HasTiles() const
+{
+	return _hasTiles;
+}
+
+const std::vector<sf::Vector2f>& FieldOfView::GetPolygon() const
+{
+	return _polygon;
+}
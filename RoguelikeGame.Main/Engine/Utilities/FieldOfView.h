@@ -0,0 +1,53 @@
+#pragma once
+
+#include <vector>
+#include <cmath>
+#include <algorithm>
+
+#include "BitGrid.h"
+#include "../Models/MapLayerModel.h"
+
+#include "SFML/System/Vector2.hpp"
+
+//Area seen from one point, tiles come from shadowcasting and polygon from rays cast at collision edges
+class FieldOfView
+{
+private:
+	sf::Vector2f _origin;
+	float _radius;
+
+	//Visible tiles in window around origin tile
+	BitGrid _visibleTiles;
+	sf::Vector2i _originTile;
+	int _tilesRadius;
+	sf::Vector2f _tileSize;
+	sf::Vector2f _tilesOffset;
+	bool _hasTiles;
+
+	//Polygon points sorted by angle around origin
+	std::vector<sf::Vector2f> _polygon;
+	std::vector<float> _polygonAngles;
+
+	//One octant of recursive shadowcasting, slopes go from start down to end
+	void CastLight(const MapLayerModel<bool>* tiles, int row, float start, float end, int xx, int xy, int yx, int yy);
+	void SetTileVisible(int x, int y);
+public:
+	FieldOfView();
+	~FieldOfView() = default;
+
+	void Clear();
+	//Tiles outside map block sight, walls are visible
+	void ComputeTiles(const sf::Vector2f& origin, float radius, const MapLayerModel<bool>* tiles);
+	//Points are ray hitpoints around origin in any order, rays that hit nothing should end on radius
+	void SetPolygon(const sf::Vector2f& origin, float radius, const std::vector<sf::Vector2f>& points);
+
+	//O(1), tile coords of map
+	bool IsTileVisible(int x, int y) const;
+	//Uses polygon if it is set, tiles otherwise
+	bool IsVisible(const sf::Vector2f& pos) const;
+
+	const sf::Vector2f& GetOrigin() const;
+	float GetRadius() const;
+	bool HasTiles() const;
+	const std::vector<sf::Vector2f>& GetPolygon() const;
+};
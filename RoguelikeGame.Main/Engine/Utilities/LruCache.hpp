@@ -0,0 +1,71 @@
+#pragma once
+
+#include <list>
+#include <unordered_map>
+
+//Key-value cache that drops least recently used entries when full
+template<typename K, typename V, typename H = std::hash<K>>
+class LruCache
+{
+private:
+	typedef std::pair<K, V> Entry;
+
+	size_t _capacity;
+	std::list<Entry> _entries; //Most recently used first
+	std::unordered_map<K, typename std::list<Entry>::iterator, H> _lookup;
+public:
+	LruCache(size_t capacity = 256) { _capacity = capacity; }
+	~LruCache() = default;
+
+	//Returns nullptr if key is not stored, pointer is valid until next Put or Clear
+	V* Get(const K& key)
+	{
+		auto found = _lookup.find(key);
+		if (found == _lookup.end()) return nullptr;
+
+		_entries.splice(_entries.begin(), _entries, found->second);
+		return &found->second->second;
+	}
+
+	V* Put(const K& key, V value)
+	{
+		if (_capacity == 0) return nullptr;
+
+		auto found = _lookup.find(key);
+		if (found != _lookup.end())
+		{
+			found->second->second = std::move(value);
+			_entries.splice(_entries.begin(), _entries, found->second);
+			return &found->second->second;
+		}
+
+		while (_entries.size() >= _capacity)
+		{
+			_lookup.erase(_entries.back().first);
+			_entries.pop_back();
+		}
+
+		_entries.emplace_front(key, std::move(value));
+		_lookup[key] = _entries.begin();
+		return &_entries.front().second;
+	}
+
+	void Clear()
+	{
+		_entries.clear();
+		_lookup.clear();
+	}
+
+	void SetCapacity(size_t capacity)
+	{
+		_capacity = capacity;
+		while (_entries.size() > _capacity)
+		{
+			_lookup.erase(_entries.back().first);
+			_entries.pop_back();
+		}
+	}
+
+	size_t GetCapacity() const { return _capacity; }
+	size_t GetSize() const { return _entries.size(); }
+};
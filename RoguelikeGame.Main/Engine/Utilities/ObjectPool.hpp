@@ -0,0 +1,131 @@
+#pragma once
+
+#include <deque>
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+#include <climits>
+
+//Released objects stay allocated and are reused by later acquires, so spawning many objects doesn't allocate them again
+//Addresses never change, handles of released objects become invalid
+//T needs ResetFrom(const T&), which turns reused object into copy of prototype without new allocations
+template<typename T>
+class ObjectPool
+{
+public:
+	struct Handle
+	{
+		uint32_t index = UINT32_MAX;
+		uint32_t generation = 0;
+
+		bool operator==(const Handle& other) const { return index == other.index && generation == other.generation; }
+		bool operator!=(const Handle& other) const { return !(*this == other); }
+	};
+private:
+	std::deque<T> _objects; //Growing deque doesn't move objects already in it
+	std::vector<uint32_t> _generations;
+	std::vector<uint8_t> _used;
+	std::vector<uint32_t> _freeIndexes;
+	std::unordered_map<const T*, uint32_t> _indexes; //Filled once per object, for releasing by pointer
+	size_t _usedCount;
+
+	uint32_t Grow()
+	{
+		auto index = (uint32_t)_objects.size();
+		_objects.emplace_back();
+		_generations.push_back(0);
+		_used.push_back(0);
+		_indexes[&_objects.back()] = index;
+		return index;
+	}
+public:
+	ObjectPool() { _usedCount = 0; }
+	~ObjectPool() = default;
+	ObjectPool(const ObjectPool&) = delete;
+	ObjectPool& operator=(const ObjectPool&) = delete;
+
+	//Creates free objects up front
+	void Reserve(size_t count)
+	{
+		while (_objects.size() < count)
+			_freeIndexes.push_back(Grow());
+	}
+
+	//Free object is reset from prototype, so its buffers are reused when they are big enough
+	T* Acquire(const T& prototype, Handle* handle = nullptr)
+	{
+		uint32_t index;
+		if (_freeIndexes.empty())
+			index = Grow();
+		else
+		{
+			index = _freeIndexes.back();
+			_freeIndexes.pop_back();
+		}
+
+		_objects[index].ResetFrom(prototype);
+		_used[index] = 1;
+		_usedCount++;
+
+		if (handle != nullptr)
+		{
+			handle->index = index;
+			handle->generation = _generations[index];
+		}
+		return &_objects[index];
+	}
+
+	//False if object is not from this pool or was already released
+	bool Release(Handle handle)
+	{
+		if (IsValid(handle) == false) return false;
+
+		_used[handle.index] = 0;
+		_generations[handle.index]++;
+		_freeIndexes.push_back(handle.index);
+		_usedCount--;
+		return true;
+	}
+
+	bool Release(const T* object)
+	{
+		return Release(GetHandle(object));
+	}
+
+	void ReleaseAll()
+	{
+		for (uint32_t i = 0; i < (uint32_t)_objects.size(); i++)
+			if (_used[i] != 0)
+				Release(GetHandle(&_objects[i]));
+	}
+
+	bool IsValid(Handle handle) const
+	{
+		return (handle.index < _objects.size() && _used[handle.index] != 0 && _generations[handle.index] == handle.generation);
+	}
+
+	//Invalid handle if object is not used object of this pool
+	Handle GetHandle(const T* object) const
+	{
+		Handle handle;
+		auto found = _indexes.find(object);
+		if (found == _indexes.end() || _used[found->second] == 0) return handle;
+
+		handle.index = found->second;
+		handle.generation = _generations[found->second];
+		return handle;
+	}
+
+	T* Get(Handle handle)
+	{
+		return IsValid(handle) ? &_objects[handle.index] : nullptr;
+	}
+
+	bool Owns(const T* object) const
+	{
+		return _indexes.find(object) != _indexes.end();
+	}
+
+	size_t GetUsedCount() const { return _usedCount; }
+	size_t GetCapacity() const { return _objects.size(); }
+};
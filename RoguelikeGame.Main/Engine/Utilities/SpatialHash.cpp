@@ -0,0 +1,216 @@
+#include "SpatialHash.h"
+
+SpatialHash::SpatialHash(float cellSize)
+{
+	_cellSize = (cellSize > 0.f) ? cellSize : 64.f;
+	_size = 0;
+}
+
+uint64_t SpatialHash::GetKey(int x, int y)
+{
+	return ((uint64_t)(uint32_t)x << 32) | (uint64_t)(uint32_t)y;
+}
+
+sf::IntRect SpatialHash::GetRange(const sf::FloatRect& bounds) const
+{
+	int x1 = (int)floor(bounds.left / _cellSize);
+	int y1 = (int)floor(bounds.top / _cellSize);
+	int x2 = (int)floor((bounds.left + bounds.width) / _cellSize);
+	int y2 = (int)floor((bounds.top + bounds.height) / _cellSize);
+	return sf::IntRect(x1, y1, x2 - x1 + 1, y2 - y1 + 1);
+}
+
+void SpatialHash::AddToCells(size_t id, const sf::IntRect& range)
+{
+	for (int y = range.top; y < range.top + range.height; y++)
+		for (int x = range.left; x < range.left + range.width; x++)
+			_cells[GetKey(x, y)].push_back(id);
+}
+
+void SpatialHash::RemoveFromCells(size_t id, const sf::IntRect& range)
+{
+	for (int y = range.top; y < range.top + range.height; y++)
+		for (int x = range.left; x < range.left + range.width; x++)
+		{
+			auto found = _cells.find(GetKey(x, y));
+			if (found == _cells.end()) continue;
+
+			auto& ids = found->second;
+			auto it = std::find(ids.begin(), ids.end(), id);
+			if (it == ids.end()) continue;
+
+			*it = ids.back();
+			ids.pop_back();
+			if (ids.empty())
+				_cells.erase(found);
+		}
+}
+
+void SpatialHash::GetCandidates(const sf::FloatRect& rect, std::vector<size_t>& out) const
+{
+	out.clear();
+	if (_size == 0) return;
+
+	auto range = GetRange(rect);
+	for (int y = range.top; y < range.top + range.height; y++)
+		for (int x = range.left; x < range.left + range.width; x++)
+		{
+			auto found = _cells.find(GetKey(x, y));
+			if (found != _cells.end())
+				out.insert(out.end(), found->second.begin(), found->second.end());
+		}
+
+	std::sort(out.begin(), out.end());
+	out.erase(std::unique(out.begin(), out.end()), out.end());
+}
+
+void SpatialHash::Clear()
+{
+	//Cells left empty by previous clear weren't used since, so map only keeps cells of last two fills
+	for (auto it = _cells.begin(); it != _cells.end();)
+	{
+		if (it->second.empty())
+			it = _cells.erase(it);
+		else
+		{
+			it->second.clear();
+			it++;
+		}
+	}
+	_bounds.clear();
+	_ranges.clear();
+	_size = 0;
+}
+
+void SpatialHash::SetCellSize(float cellSize)
+{
+	if (cellSize <= 0.f) return;
+
+	_cells.clear();
+	_bounds.clear();
+	_ranges.clear();
+	_size = 0;
+	_cellSize = cellSize;
+}
+
+void SpatialHash::Insert(size_t id, const sf::FloatRect& bounds)
+{
+	if (id >= _ranges.size())
+	{
+		_ranges.resize(id + 1, sf::IntRect(0, 0, 0, 0));
+		_bounds.resize(id + 1);
+	}
+
+	auto range = GetRange(bounds);
+	auto& old = _ranges[id];
+	if (old.width == 0)
+	{
+		AddToCells(id, range);
+		_size++;
+	}
+	else if (old != range) //Small moves mostly stay in same cells
+	{
+		RemoveFromCells(id, old);
+		AddToCells(id, range);
+	}
+
+	_ranges[id] = range;
+	_bounds[id] = bounds;
+}
+
+void SpatialHash::Remove(size_t id)
+{
+	if (Contains(id) == false) return;
+
+	RemoveFromCells(id, _ranges[id]);
+	_ranges[id] = sf::IntRect(0, 0, 0, 0);
+	_size--;
+}
+
+float SpatialHash::GetCellSize() const
+{
+	return _cellSize;
+}
+
+size_t SpatialHash::GetSize() const
+{
+	return _size;
+}
+
+bool SpatialHash::Contains(size_t id) const
+{
+	return (id < _ranges.size() && _ranges[id].width != 0);
+}
+
+sf::FloatRect SpatialHash::GetBounds(size_t id) const
+{
+	if (Contains(id) == false) return sf::FloatRect();
+	return _bounds[id];
+}
+
+void SpatialHash::QueryRect(const sf::FloatRect& rect, std::vector<size_t>& out) const
+{
+	GetCandidates(rect, out);
+	out.erase(std::remove_if(out.begin(), out.end(), [&](size_t id) {
+		return (_bounds[id].intersects(rect) == false);
+	}), out.end());
+}
+
+void SpatialHash::QueryRadius(const sf::Vector2f& center, float radius, std::vector<size_t>& out) const
+{
+	GetCandidates(sf::FloatRect(center.x - radius, center.y - radius, radius * 2.f, radius * 2.f), out);
+	out.erase(std::remove_if(out.begin(), out.end(), [&](size_t id) {
+		auto& b = _bounds[id];
+		float dx = center.x - std::max(b.left, std::min(center.x, b.left + b.width));
+		float dy = center.y - std::max(b.top, std::min(center.y, b.top + b.height));
+		return (dx * dx + dy * dy > radius * radius);
+	}), out.end());
+}
+
+void SpatialHash::QueryNearest(const sf::Vector2f& center, float radius, size_t maxCount, std::vector<size_t>& out) const
+{
+	QueryRadius(center, radius, out);
+
+	auto distance = [&](size_t id) {
+		auto& b = _bounds[id];
+		float dx = b.left + b.width / 2.f - center.x;
+		float dy = b.top + b.height / 2.f - center.y;
+		return dx * dx + dy * dy;
+	};
+	auto closer = [&](size_t first, size_t second) {
+		auto firstDistance = distance(first);
+		auto secondDistance = distance(second);
+		return (firstDistance != secondDistance) ? firstDistance < secondDistance : first < second;
+	};
+
+	if (out.size() > maxCount)
+	{
+		std::partial_sort(out.begin(), out.begin() + maxCount, out.end(), closer);
+		out.resize(maxCount);
+	}
+	else
+		std::sort(out.begin(), out.end(), closer);
+}
+
+void SpatialHash::QueryCone(const sf::Vector2f& center, float radius, float arc, float angle, std::vector<size_t>& out) const
+{
+	QueryRadius(center, radius, out);
+
+	auto inCone = [&](float x, float y) {
+		float dx = x - center.x;
+		float dy = y - center.y;
+		if (dx * dx + dy * dy > radius * radius) return false;
+		if (arc >= 360.f) return true;
+
+		float diff = fmod(atan2f(dy, dx) * 180.f / 3.14159265359f - angle, 360.f);
+		if (diff > 180.f) diff -= 360.f;
+		else if (diff < -180.f) diff += 360.f;
+		return (fabs(diff) <= arc / 2.f);
+	};
+
+	out.erase(std::remove_if(out.begin(), out.end(), [&](size_t id) {
+		auto& b = _bounds[id];
+		return (inCone(b.left, b.top) == false && inCone(b.left + b.width, b.top) == false &&
+			inCone(b.left, b.top + b.height) == false && inCone(b.left + b.width, b.top + b.height) == false);
+	}), out.end());
+}
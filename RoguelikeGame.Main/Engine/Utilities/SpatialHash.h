@@ -0,0 +1,51 @@
+#pragma once
+
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+#include <cmath>
+#include <algorithm>
+
+#include "SFML/Graphics/Rect.hpp"
+
+//Broadphase for moving objects, ids are stored in every cell their bounds touch
+class SpatialHash
+{
+private:
+	float _cellSize;
+	std::unordered_map<uint64_t, std::vector<size_t>> _cells;
+	std::vector<sf::FloatRect> _bounds; //Per id
+	std::vector<sf::IntRect> _ranges; //Cells covered by id, zero width if id is not stored
+	size_t _size;
+
+	static uint64_t GetKey(int x, int y);
+	sf::IntRect GetRange(const sf::FloatRect& bounds) const;
+	void AddToCells(size_t id, const sf::IntRect& range);
+	void RemoveFromCells(size_t id, const sf::IntRect& range);
+	//Ids from every cell touching rect, sorted and unique
+	void GetCandidates(const sf::FloatRect& rect, std::vector<size_t>& out) const;
+public:
+	SpatialHash(float cellSize = 64.f);
+	~SpatialHash() = default;
+
+	//Keeps cells used since last clear, so rebuilding every tick is cheap and map doesn't grow with roaming objects
+	void Clear();
+	//Clears stored ids
+	void SetCellSize(float cellSize);
+	//Moves id if it is already stored
+	void Insert(size_t id, const sf::FloatRect& bounds);
+	void Remove(size_t id);
+
+	float GetCellSize() const;
+	size_t GetSize() const;
+	bool Contains(size_t id) const;
+	sf::FloatRect GetBounds(size_t id) const;
+
+	//Queries return sorted ids, out is cleared first
+	void QueryRect(const sf::FloatRect& rect, std::vector<size_t>& out) const;
+	void QueryRadius(const sf::Vector2f& center, float radius, std::vector<size_t>& out) const;
+	//At most maxCount ids from QueryRadius, closest bounds centers first, ties by id
+	void QueryNearest(const sf::Vector2f& center, float radius, size_t maxCount, std::vector<size_t>& out) const;
+	//Ids with any bounds corner in cone, angles in degrees like CollisionHelper::CheckCircleCollision
+	void QueryCone(const sf::Vector2f& center, float radius, float arc, float angle, std::vector<size_t>& out) const;
+};
@@ -95,6 +95,19 @@ namespace sf
 	}
 
 
+	void TransformAnimation::ResetFrom(const TransformAnimation& other)
+	{
+		auto target = _target;
+		*this = other;
+		_target = target;
+
+		//Previous transform of other is in its vector
+		_prevStart = nullptr;
+		for (size_t i = 0; i < other._transforms.size(); i++)
+			if (other._prevStart == &std::get<0>(other._transforms[i]))
+				_prevStart = &std::get<0>(_transforms[i]);
+	}
+
 	void TransformAnimation::SetTarget(sf::Transformable* target)
 	{
 		_target = target;
@@ -33,6 +33,8 @@ namespace sf
 		TransformAnimation();
 		~TransformAnimation() = default;
 
+		//Copy of other, but target is kept
+		void ResetFrom(const TransformAnimation& other);
 		void SetTarget(sf::Transformable* target);
 		void Update(float deltaTime);
 
@@ -1,4 +1,6 @@
 #include "Engine/Core/Game.h"
+#include "Engine/Helpers/BenchmarkHelper.h"
+#include "Engine/Helpers/BakeHelper.h"
 
 int main(int argc, char* argv[])
 {
@@ -14,6 +16,18 @@ int main(int argc, char* argv[])
         options.ignoredTypes["DEBUG"] = false;
         Settings::GetInstance()->DEBUG.NewValue(true);
     }
+    else if (argc >= 2 && _stricmp(argv[1], "-b") == 0)
+    {
+        Logger::GetInstance(options);
+        BenchmarkHelper::RunPathfinding("./res/maps/map1.json");
+        return 0;
+    }
+    else if (argc >= 2 && _stricmp(argv[1], "-bake") == 0)
+    {
+        Logger::GetInstance(options);
+        std::string mapPath = (argc >= 3) ? argv[2] : "./res/maps/map1.json";
+        return BakeHelper::BakePathfindingGraph(mapPath) ? 0 : 1;
+    }
 
     Game game(options);
     game.Start();